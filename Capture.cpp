@@ -0,0 +1,178 @@
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+
+#include "Capture.h"
+#include "Ensure.h"
+
+namespace Modbus {
+namespace RTU {
+namespace {
+
+constexpr const char MAGIC[4] = {'M', 'B', 'C', 'P'};
+constexpr const uint8_t VERSION = 1;
+constexpr const std::size_t HEADER_SIZE =
+    4 /* magic */ + 1 /* version */ + 1 /* bitsPerChar */ + 2 /* reserved */
+    + 4 /* bitRate */ + 8 /* started */;
+constexpr const std::size_t RECORD_HEADER_SIZE = 8 /* timestamp */ + 2 /* size */;
+/* file grows (and is mapped) by windows, window holds many records */
+constexpr const uint64_t WINDOW_SIZE = 8 << 20;
+
+template <typename T>
+uint8_t *put(uint8_t *dst, T value)
+{
+    for(std::size_t i = 0; i < sizeof(T); ++i, ++dst) *dst = uint8_t(uint64_t(value) >> (i << 3));
+    return dst;
+}
+
+template <typename T>
+const uint8_t *get(const uint8_t *src, T &value)
+{
+    uint64_t v = 0;
+
+    for(std::size_t i = 0; i < sizeof(T); ++i, ++src) v |= uint64_t(*src) << (i << 3);
+    value = T(v);
+    return src;
+}
+
+} /* namespace */
+
+std::chrono::microseconds CaptureHeader::charTime() const
+{
+    return std::chrono::microseconds(uint64_t(bitsPerChar) * 1000000 / std::max<uint32_t>(bitRate, 1));
+}
+
+std::chrono::microseconds CaptureHeader::silentInterval() const
+{
+    if(19200 < bitRate) return std::chrono::microseconds{1750};
+    return std::chrono::microseconds(uint64_t(7) * bitsPerChar * 1000000 / (2 * std::max<uint32_t>(bitRate, 1)));
+}
+
+CaptureWriter::CaptureWriter(const std::string &path, uint32_t bitRate, uint8_t bitsPerChar):
+    start_{Clock::now()}
+{
+    using namespace std::chrono;
+
+    fd_ = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    ENSURE(-1 != fd_, CRuntimeError);
+    map(0);
+
+    const auto started = duration_cast<milliseconds>(system_clock::now().time_since_epoch()).count();
+    auto *i = window_;
+
+    std::copy(std::begin(MAGIC), std::end(MAGIC), i);
+    i += sizeof(MAGIC);
+    i = put(i, VERSION);
+    i = put(i, bitsPerChar);
+    i = put(i, uint16_t{0});
+    i = put(i, bitRate);
+    put(i, int64_t(started));
+    size_ = HEADER_SIZE;
+}
+
+CaptureWriter::~CaptureWriter()
+{
+    if(window_) (void)::munmap(window_, WINDOW_SIZE);
+    if(-1 != fd_)
+    {
+        (void)::ftruncate(fd_, off_t(size_));
+        (void)::close(fd_);
+    }
+}
+
+void CaptureWriter::map(uint64_t offset)
+{
+    const auto page = uint64_t(::sysconf(_SC_PAGESIZE));
+
+    offset -= offset % page;
+    if(window_) (void)::munmap(window_, WINDOW_SIZE);
+    window_ = nullptr;
+
+    /* new window is zero filled (end of capture for reader) */
+    ENSURE(0 == ::ftruncate(fd_, off_t(offset + WINDOW_SIZE)), CRuntimeError);
+
+    auto *const window = ::mmap(nullptr, WINDOW_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, off_t(offset));
+
+    ENSURE(MAP_FAILED != window, CRuntimeError);
+    window_ = static_cast<uint8_t *>(window);
+    windowOffset_ = offset;
+}
+
+void CaptureWriter::write(Clock::time_point timestamp, const uint8_t *begin, const uint8_t *const end)
+{
+    using namespace std::chrono;
+
+    const auto size = std::size_t(end - begin);
+
+    ENSURE(UINT16_MAX >= size, RuntimeError);
+    if(!size) return;
+
+    if(size_ + RECORD_HEADER_SIZE + size > windowOffset_ + WINDOW_SIZE) map(size_);
+
+    auto *i = window_ + (size_ - windowOffset_);
+
+    i = put(i, int64_t(duration_cast<nanoseconds>(timestamp - start_).count()));
+    i = put(i, uint16_t(size));
+    std::memcpy(i, begin, size);
+    size_ += RECORD_HEADER_SIZE + size;
+}
+
+CaptureReader::CaptureReader(const std::string &path)
+{
+    const auto fd = ::open(path.c_str(), O_RDONLY);
+
+    ENSURE(-1 != fd, CRuntimeError);
+
+    struct stat st;
+
+    if(0 == ::fstat(fd, &st) && HEADER_SIZE <= std::size_t(st.st_size))
+    {
+        size_ = std::size_t(st.st_size);
+
+        auto *const base = ::mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd, 0);
+
+        if(MAP_FAILED != base) base_ = static_cast<const uint8_t *>(base);
+    }
+    (void)::close(fd);
+    ENSURE(base_, RuntimeError);
+    ENSURE(std::equal(std::begin(MAGIC), std::end(MAGIC), base_) && VERSION == base_[4], RuntimeError);
+
+    uint16_t reserved;
+    auto *i = get(base_ + sizeof(MAGIC) + 1, header_.bitsPerChar);
+
+    i = get(i, reserved);
+    i = get(i, header_.bitRate);
+    get(i, header_.started);
+    pos_ = HEADER_SIZE;
+}
+
+CaptureReader::~CaptureReader()
+{
+    if(base_) (void)::munmap(const_cast<uint8_t *>(base_), size_);
+}
+
+bool CaptureReader::next(Chunk &chunk)
+{
+    if(pos_ + RECORD_HEADER_SIZE > size_) return false;
+
+    const auto *const data = get(get(base_ + pos_, chunk.timestamp), chunk.size);
+
+    /* zero filled tail or truncated record */
+    if(!chunk.size || pos_ + RECORD_HEADER_SIZE + chunk.size > size_) return false;
+
+    chunk.data = data;
+    pos_ += RECORD_HEADER_SIZE + chunk.size;
+    return true;
+}
+
+void CaptureReader::rewind()
+{
+    pos_ = HEADER_SIZE;
+}
+
+} /* RTU */
+} /* Modbus */
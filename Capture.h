@@ -0,0 +1,87 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace Modbus {
+namespace RTU {
+
+/* Capture of raw received data (monitor -w): chunks as returned by read()
+ * with monotonic timestamps, so traffic can be decoded (monitor -i) or
+ * replayed into pty (replay) later with original timing.
+ *
+ * Binary form (little endian): header followed by records - timestamp (ns
+ * since capture start), size and data. Writer appends to memory mapped file
+ * which grows by large windows - recording is a copy to memory, reader loop
+ * never waits for disk. File is truncated to its size when writer is closed,
+ * zero filled tail (writer did not exit) is ignored by reader. */
+struct CaptureHeader
+{
+    /* line settings of capture */
+    uint32_t bitRate;
+    uint8_t bitsPerChar;
+    /* wall clock (ms since epoch) of capture start */
+    int64_t started;
+
+    /* wire time of single character */
+    std::chrono::microseconds charTime() const;
+    /* 3.5t, fixed 1750us above 19200bps - as SerialPort::silentInterval() */
+    std::chrono::microseconds silentInterval() const;
+};
+
+class CaptureWriter
+{
+public:
+    using Clock = std::chrono::steady_clock;
+private:
+    int fd_{-1};
+    uint8_t *window_{nullptr};
+    uint64_t windowOffset_{0};
+    uint64_t size_{0};
+    Clock::time_point start_;
+
+    /* window covering offset */
+    void map(uint64_t offset);
+public:
+    CaptureWriter(const std::string &path, uint32_t bitRate, uint8_t bitsPerChar);
+    ~CaptureWriter();
+
+    CaptureWriter(const CaptureWriter &) = delete;
+    CaptureWriter &operator=(const CaptureWriter &) = delete;
+
+    void write(Clock::time_point timestamp, const uint8_t *begin, const uint8_t *const end);
+    uint64_t size() const { return size_; }
+};
+
+class CaptureReader
+{
+public:
+    struct Chunk
+    {
+        /* ns since capture start */
+        int64_t timestamp;
+        const uint8_t *data;
+        uint16_t size;
+    };
+private:
+    const uint8_t *base_{nullptr};
+    std::size_t size_{0};
+    std::size_t pos_{0};
+    CaptureHeader header_{};
+public:
+    explicit CaptureReader(const std::string &path);
+    ~CaptureReader();
+
+    CaptureReader(const CaptureReader &) = delete;
+    CaptureReader &operator=(const CaptureReader &) = delete;
+
+    const CaptureHeader &header() const { return header_; }
+    /* false at the end of capture */
+    bool next(Chunk &);
+    void rewind();
+};
+
+} /* RTU */
+} /* Modbus */
@@ -0,0 +1,101 @@
+#include <algorithm>
+#include <cstring>
+
+#include "Delta.h"
+#include "Ensure.h"
+#include "Frame.h"
+
+namespace Modbus {
+namespace RTU {
+namespace {
+
+bool isRead(uint8_t fcode)
+{
+    return
+        FCODE_RD_COILS == fcode
+        || FCODE_RD_HOLDING_REGISTERS == fcode
+        || FCODE_RD_BYTES == fcode;
+}
+
+std::size_t dataSize(const Plan::Request &req)
+{
+    return isRead(req.fcode) ? req.repSize - req.dataOffset - sizeof(CRC) : 0;
+}
+
+} /* namespace */
+
+Delta::Delta(const Plan &plan):
+    plan_{plan},
+    offset_(plan.size(), 0),
+    known_(plan.size(), false)
+{
+    std::size_t size = 0;
+
+    for(std::size_t i = 0; i < plan.size(); ++i)
+    {
+        offset_[i] = size;
+        size += dataSize(plan[i]);
+    }
+    previous_.resize(size, 0);
+}
+
+std::size_t Delta::update(const Executor &executor, std::size_t i, std::vector<uint32_t> &index)
+{
+    ENSURE(plan_.size() > i, RuntimeError);
+
+    index.clear();
+
+    const auto &req = plan_[i];
+    const auto size = dataSize(req);
+    const auto *const curr = executor.dataBegin(i);
+    auto *const prev = previous_.data() + offset_[i];
+    /* value array element */
+    const std::size_t elementSize = FCODE_RD_HOLDING_REGISTERS == req.fcode ? 2 : 1;
+    const auto differs =
+        [curr, prev, elementSize](std::size_t n)
+        {
+            return 0 != std::memcmp(curr + n, prev + n, elementSize);
+        };
+
+    if(!size) return 0;
+
+    if(!known_[i])
+    {
+        for(std::size_t n = 0; n < size; n += elementSize) index.push_back(uint32_t(n / elementSize));
+    }
+    else if(0 != std::memcmp(curr, prev, size))
+    {
+        std::size_t n = 0;
+
+        /* word is multiple of element size - elements do not span words */
+        for(; n + sizeof(uint64_t) <= size; n += sizeof(uint64_t))
+        {
+            uint64_t currWord, prevWord;
+
+            std::memcpy(&currWord, curr + n, sizeof(currWord));
+            std::memcpy(&prevWord, prev + n, sizeof(prevWord));
+            if(currWord == prevWord) continue;
+
+            for(auto k = n; k < n + sizeof(uint64_t); k += elementSize)
+            {
+                if(differs(k)) index.push_back(uint32_t(k / elementSize));
+            }
+        }
+        for(; n < size; n += elementSize)
+        {
+            if(differs(n)) index.push_back(uint32_t(n / elementSize));
+        }
+    }
+
+    std::memcpy(prev, curr, size);
+    known_[i] = true;
+    return index.size();
+}
+
+void Delta::reset()
+{
+    std::fill(std::begin(known_), std::end(known_), false);
+}
+
+} /* RTU */
+} /* Modbus */
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "Plan.h"
+
+namespace Modbus {
+namespace RTU {
+
+/* Change detection of cyclically executed Plan: data of last reply of every
+ * read request is kept, update() reports elements which changed since.
+ * Element is single entry of result "value" array: register, byte of packed
+ * coils or byte (RD_BYTES).
+ *
+ * Unchanged data (common case) is detected with single memcmp, otherwise
+ * data is compared 8 bytes at a time and only elements of differing words
+ * are examined - cost stays low even for large RD_BYTES blocks. */
+class Delta
+{
+    const Plan &plan_;
+    /* previous data of all reads, offset_[i] - data of i-th request */
+    Plan::ByteSeq previous_;
+    std::vector<std::size_t> offset_;
+    std::vector<bool> known_;
+public:
+    explicit Delta(const Plan &plan);
+
+    /* indices of elements of i-th request (executed successfully) which
+     * changed since previous update - every element on first update (and
+     * after reset()), none for writes */
+    std::size_t update(const Executor &, std::size_t i, std::vector<uint32_t> &index);
+    /* next update() of every request reports all elements (full snapshot) */
+    void reset();
+};
+
+} /* RTU */
+} /* Modbus */
@@ -0,0 +1,69 @@
+#include <algorithm>
+
+#include "Ensure.h"
+#include "Frame.h"
+
+namespace Modbus {
+namespace RTU {
+namespace {
+
+template <typename T>
+FrameCache::Entry toEntry(const T &adu)
+{
+    static_assert(std::tuple_size<T>::value <= std::tuple_size<Frame<8>>::value);
+
+    FrameCache::Entry entry{};
+
+    std::copy(std::begin(adu), std::end(adu), std::begin(entry.data));
+    entry.size = uint8_t(adu.size());
+    return entry;
+}
+
+FrameCache::Entry makeEntry(uint8_t fcode, uint8_t slave, uint16_t memAddr, uint16_t arg)
+{
+    switch(fcode)
+    {
+        case FCODE_RD_COILS:
+            return toEntry(makeRequest<FCODE_RD_COILS>(slave, memAddr, arg));
+        case FCODE_RD_HOLDING_REGISTERS:
+            return toEntry(makeRequest<FCODE_RD_HOLDING_REGISTERS>(slave, memAddr, arg));
+        case FCODE_WR_COIL:
+            return toEntry(makeRequest<FCODE_WR_COIL>(slave, memAddr, arg));
+        case FCODE_WR_REGISTER:
+            return toEntry(makeRequest<FCODE_WR_REGISTER>(slave, memAddr, arg));
+        case FCODE_RD_BYTES:
+            return toEntry(makeRequest<FCODE_RD_BYTES>(slave, memAddr, arg));
+        default:
+            ENSURE(false && "not supported fcode", RuntimeError);
+            break;
+    }
+    return {};
+}
+
+uint64_t toKey(uint8_t fcode, uint8_t slave, uint16_t memAddr, uint16_t arg)
+{
+    return
+        (uint64_t(fcode) << 40)
+        | (uint64_t(slave) << 32)
+        | (uint64_t(memAddr) << 16)
+        | uint64_t(arg);
+}
+
+} /* namespace */
+
+FrameCache::Entry FrameCache::request(
+    uint8_t fcode, uint8_t slave, uint16_t memAddr, uint16_t arg)
+{
+    const auto key = toKey(fcode, slave, memAddr, arg);
+    const auto i = entries_.find(key);
+
+    if(std::end(entries_) != i) return i->second;
+    /* cache is meant for small set of repeated requests,
+     * drop everything if it grows beyond that */
+    if(capacity_ <= entries_.size()) entries_.clear();
+
+    return entries_.emplace(key, makeEntry(fcode, slave, memAddr, arg)).first->second;
+}
+
+} /* RTU */
+} /* Modbus */
@@ -0,0 +1,131 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+
+#include "crc.h"
+
+namespace Modbus {
+namespace RTU {
+
+constexpr const uint8_t FCODE_RD_COILS = 1;
+constexpr const uint8_t FCODE_RD_HOLDING_REGISTERS = 3;
+constexpr const uint8_t FCODE_WR_COIL = 5;
+constexpr const uint8_t FCODE_WR_REGISTER = 6;
+constexpr const uint8_t FCODE_WR_REGISTERS = 16;
+constexpr const uint8_t FCODE_USER1_OFFSET = 65;
+constexpr const uint8_t FCODE_RD_BYTES = FCODE_USER1_OFFSET + 0;
+constexpr const uint8_t FCODE_WR_BYTES = FCODE_USER1_OFFSET + 1;
+constexpr const uint8_t ECODE_ILLEGAL_FUNCTION = 0x81;
+constexpr const uint8_t ECODE_ILLEGAL_DATA_ADDRESS = 0x82;
+constexpr const uint8_t ECODE_ILLEGAL_DATA_VALUE = 0x83;
+constexpr const uint8_t ECODE_SERVER_DEVICE_FAILURE = 0x84;
+
+template <std::size_t N>
+using Frame = std::array<uint8_t, N>;
+
+template <std::size_t N>
+constexpr
+Frame<N + sizeof(CRC)> appendCRC(const Frame<N> &pdu)
+{
+    Frame<N + sizeof(CRC)> adu{};
+
+    for(std::size_t i = 0; i < N; ++i) adu[i] = pdu[i];
+
+    const auto crc = calcCRC(pdu.data(), pdu.data() + N);
+
+    adu[N + 0] = crc.lowByte();
+    adu[N + 1] = crc.highByte();
+    return adu;
+}
+
+/* Build complete ADU (slave + PDU + CRC) of fixed size request.
+ * If all arguments are constant expressions whole frame (including CRC)
+ * is evaluated at compile time:
+ *
+ *  constexpr auto req = makeRequest<FCODE_RD_HOLDING_REGISTERS>(1, 0, 1);
+ *
+ * arg meaning depends on FCODE:
+ * - RD_COILS, RD_HOLDING_REGISTERS, RD_BYTES: count
+ * - WR_COIL: value (0 - OFF, otherwise ON)
+ * - WR_REGISTER: value */
+template <uint8_t FCODE>
+constexpr
+auto makeRequest(uint8_t slave, uint16_t memAddr, uint16_t arg)
+{
+    constexpr auto high = [](uint16_t word) { return uint8_t(word >> 8); };
+    constexpr auto low = [](uint16_t word) { return uint8_t(word & 0xFF); };
+
+    static_assert(
+        FCODE_RD_COILS == FCODE
+        || FCODE_RD_HOLDING_REGISTERS == FCODE
+        || FCODE_WR_COIL == FCODE
+        || FCODE_WR_REGISTER == FCODE
+        || FCODE_RD_BYTES == FCODE,
+        "only fixed size requests are supported");
+
+    if constexpr(FCODE_RD_BYTES == FCODE)
+    {
+        return appendCRC(Frame<5>{slave, FCODE, high(memAddr), low(memAddr), low(arg)});
+    }
+    else if constexpr(FCODE_WR_COIL == FCODE)
+    {
+        return
+            appendCRC(
+                Frame<6>
+                {
+                    slave, FCODE, high(memAddr), low(memAddr),
+                    arg ? uint8_t(0xFF) : uint8_t(0), uint8_t(0)
+                });
+    }
+    else
+    {
+        return
+            appendCRC(
+                Frame<6>{slave, FCODE, high(memAddr), low(memAddr), high(arg), low(arg)});
+    }
+}
+
+static_assert(
+    []()
+    {
+        /* well known RD_HOLDING_REGISTERS request: 01 03 00 00 00 01 84 0A */
+        constexpr auto req = makeRequest<FCODE_RD_HOLDING_REGISTERS>(1, 0, 1);
+        return
+            8 == req.size()
+            && 0x84 == req[6]
+            && 0x0A == req[7];
+    }(),
+    "compile time CRC invalid");
+
+/* Cache of ready to send ADUs for requests which are repeated with the same
+ * arguments (polling, stress testing). Request is encoded (and CRC calculated)
+ * only once - afterwards it is just copied to device. */
+class FrameCache
+{
+public:
+    struct Entry
+    {
+        Frame<8> data;
+        uint8_t size;
+
+        const uint8_t *begin() const { return data.data(); }
+        const uint8_t *end() const { return data.data() + size; }
+    };
+private:
+    std::unordered_map<uint64_t, Entry> entries_;
+    std::size_t capacity_;
+public:
+    explicit FrameCache(std::size_t capacity = 1024): capacity_{capacity} {}
+
+    /* entry is returned by value (9 bytes) - cache is cleared when it is
+     * full, so reference to cached entry could be invalidated by next call */
+    Entry request(uint8_t fcode, uint8_t slave, uint16_t memAddr, uint16_t arg);
+    std::size_t size() const { return entries_.size(); }
+    void clear() { entries_.clear(); }
+};
+
+} /* RTU */
+} /* Modbus */
@@ -0,0 +1,191 @@
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+
+#include "Except.h"
+#include "FrameLog.h"
+
+namespace Modbus {
+namespace RTU {
+namespace {
+
+/* binary form: header followed by records,
+ * every record is stored as fixed size header + size bytes of data,
+ * all numbers are little endian */
+constexpr const char MAGIC[4] = {'M', 'B', 'F', 'L'};
+constexpr const uint8_t VERSION = 1;
+constexpr const std::size_t RECORD_HEADER_SIZE =
+    8 /* timestamp */ + 4 /* duration */ + 2 /* size */ + 1 /* direction */ + 1 /* status */;
+
+template <typename T>
+uint8_t *put(uint8_t *dst, T value)
+{
+    for(std::size_t i = 0; i < sizeof(T); ++i, ++dst) *dst = uint8_t(uint64_t(value) >> (i << 3));
+    return dst;
+}
+
+template <typename T>
+const uint8_t *get(const uint8_t *src, T &value)
+{
+    uint64_t v = 0;
+
+    for(std::size_t i = 0; i < sizeof(T); ++i, ++src) v |= uint64_t(*src) << (i << 3);
+    value = T(v);
+    return src;
+}
+
+bool valid(const FrameLog::Record &record)
+{
+    return
+        FrameLog::DATA_SIZE >= record.size
+        && (FrameLog::Direction::Tx == record.direction || FrameLog::Direction::Rx == record.direction)
+        && STATUS_NUM > std::size_t(record.status);
+}
+
+} /* namespace */
+
+FrameLog::FrameLog(std::size_t capacity):
+    capacity_{capacity},
+    slots_{new Slot[capacity]}
+{
+    ENSURE(0 < capacity, RuntimeError);
+}
+
+void FrameLog::record(
+    Direction direction,
+    Clock::time_point timestamp, Clock::duration duration,
+    Status status,
+    const uint8_t *begin, const uint8_t *const end)
+{
+    using namespace std::chrono;
+
+    const auto head = head_.load(std::memory_order_relaxed);
+    auto &slot = slots_[head % capacity_];
+    const auto seq = slot.seq.load(std::memory_order_relaxed);
+    const auto size = std::min<std::size_t>(DATA_SIZE, std::max<std::ptrdiff_t>(0, std::distance(begin, end)));
+
+    slot.seq.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    auto &record = slot.record;
+
+    record.timestamp = duration_cast<nanoseconds>(timestamp.time_since_epoch()).count();
+    record.duration = uint32_t(std::max<int64_t>(0, duration_cast<microseconds>(duration).count()));
+    record.size = uint16_t(size);
+    record.direction = direction;
+    record.status = status;
+    if(size) std::memcpy(record.data, begin, size);
+
+    slot.seq.store(seq + 2, std::memory_order_release);
+    head_.store(head + 1, std::memory_order_release);
+}
+
+void FrameLog::dump(std::ostream &os, const Record &record, int64_t prevTimestamp)
+{
+    const auto flags = os.flags();
+    const auto fill = os.fill();
+
+    os
+        << std::dec << std::setfill(' ')
+        << std::setw(10) << record.timestamp / 1000000000 << '.'
+        << std::setw(6) << std::setfill('0') << record.timestamp / 1000 % 1000000 << std::setfill(' ')
+        << " +" << std::setw(8) << std::left << (prevTimestamp ? (record.timestamp - prevTimestamp) / 1000 : 0)
+        << std::right
+        << ' ' << (Direction::Tx == record.direction ? "TX" : "RX")
+        << ' ' << std::setw(8) << record.duration << "us"
+        << ' ' << std::setw(9) << std::left << toString(record.status) << std::right
+        << " [" << std::setw(3) << record.size << "]";
+
+    for(std::size_t i = 0; i < record.size; ++i)
+    {
+        os << ' ' << std::hex << std::setw(2) << std::setfill('0') << int(record.data[i]) << std::setfill(' ');
+    }
+    os << '\n';
+    os.flags(flags);
+    os.fill(fill);
+}
+
+void FrameLog::dump(std::ostream &os, std::size_t num) const
+{
+    int64_t prevTimestamp = 0;
+
+    forEach(
+        [&os, &prevTimestamp](const Record &record)
+        {
+            dump(os, record, prevTimestamp);
+            prevTimestamp = record.timestamp;
+        },
+        num);
+    os << std::flush;
+}
+
+void FrameLog::store(std::ostream &os) const
+{
+    os.write(MAGIC, sizeof(MAGIC));
+    os.put(char(VERSION));
+
+    forEach(
+        [&os](const Record &record)
+        {
+            uint8_t header[RECORD_HEADER_SIZE];
+            auto i = std::begin(header);
+
+            i = put(i, record.timestamp);
+            i = put(i, record.duration);
+            i = put(i, record.size);
+            i = put(i, uint8_t(record.direction));
+            put(i, uint8_t(record.status));
+
+            os.write(reinterpret_cast<const char *>(header), sizeof(header));
+            os.write(reinterpret_cast<const char *>(record.data), record.size);
+        });
+    os << std::flush;
+}
+
+void FrameLog::store(const std::string &fileName) const
+{
+    std::ofstream ofile{fileName, std::ios::binary | std::ios::trunc};
+
+    ENSURE(ofile, RuntimeError);
+    store(ofile);
+    ENSURE(ofile, RuntimeError);
+}
+
+void FrameLog::decode(std::istream &is, std::ostream &os)
+{
+    char magic[sizeof(MAGIC)];
+
+    is.read(magic, sizeof(magic));
+    ENSURE(is && std::equal(std::begin(magic), std::end(magic), std::begin(MAGIC)), RuntimeError);
+    ENSURE(VERSION == is.get(), RuntimeError);
+
+    int64_t prevTimestamp = 0;
+    uint8_t header[RECORD_HEADER_SIZE];
+    Record record;
+
+    while(is.read(reinterpret_cast<char *>(header), sizeof(header)))
+    {
+        uint8_t direction, status;
+        auto i = get(std::begin(header), record.timestamp);
+
+        i = get(i, record.duration);
+        i = get(i, record.size);
+        i = get(i, direction);
+        get(i, status);
+        record.direction = Direction(direction);
+        record.status = Status(status);
+
+        ENSURE(valid(record), RuntimeError);
+        is.read(reinterpret_cast<char *>(record.data), record.size);
+        ENSURE(is, RuntimeError);
+
+        dump(os, record, prevTimestamp);
+        prevTimestamp = record.timestamp;
+    }
+    ENSURE(is.eof() && 0 == is.gcount(), RuntimeError);
+    os << std::flush;
+}
+
+} /* RTU */
+} /* Modbus */
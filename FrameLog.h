@@ -0,0 +1,113 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <memory>
+#include <ostream>
+#include <string>
+
+#include "Status.h"
+
+namespace Modbus {
+namespace RTU {
+
+/* Fixed size ring buffer of raw frames (request/reply) exchanged by Master.
+ * Recording is a plain copy of frame (no formatting), so it can stay enabled
+ * all the time - history of last transactions is decoded (or stored in binary
+ * form) only when needed (error, signal, on demand).
+ *
+ * Single writer (thread executing transactions), any number of readers:
+ * every slot is guarded by sequence number (seqlock), readers never block
+ * writer and torn (overwritten while being read) records are skipped. */
+class FrameLog
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    enum class Direction : uint8_t
+    {
+        Tx = 'T', Rx = 'R'
+    };
+
+    /* max RTU ADU size */
+    static constexpr const std::size_t DATA_SIZE = 256;
+
+    struct Record
+    {
+        int64_t timestamp; /* Clock, ns */
+        uint32_t duration; /* us */
+        uint16_t size;
+        Direction direction;
+        Status status;
+        uint8_t data[DATA_SIZE];
+    };
+private:
+    struct Slot
+    {
+        std::atomic<uint32_t> seq{0};
+        Record record;
+    };
+
+    std::size_t capacity_;
+    std::unique_ptr<Slot[]> slots_;
+    /* number of records written so far */
+    std::atomic<uint64_t> head_{0};
+public:
+    /* capacity - number of records (every transaction produces 2 records) */
+    explicit FrameLog(std::size_t capacity = 8192);
+
+    FrameLog(const FrameLog &) = delete;
+    FrameLog &operator=(const FrameLog &) = delete;
+
+    void record(
+        Direction direction,
+        Clock::time_point timestamp, Clock::duration duration,
+        Status status,
+        const uint8_t *begin, const uint8_t *const end);
+
+    std::size_t capacity() const { return capacity_; }
+    uint64_t written() const { return head_.load(std::memory_order_acquire); }
+    void clear() { head_.store(0, std::memory_order_release); }
+
+    /* call f(const Record &) for (at most) last num records, oldest first */
+    template <typename F>
+    void forEach(F f, std::size_t num = SIZE_MAX) const;
+
+    /* decode (at most) last num records as text */
+    void dump(std::ostream &, std::size_t num = SIZE_MAX) const;
+    /* binary form, see decode() */
+    void store(std::ostream &) const;
+    void store(const std::string &fileName) const;
+    /* decode binary form (produced by store()) as text */
+    static void decode(std::istream &, std::ostream &);
+    static void dump(std::ostream &, const Record &, int64_t prevTimestamp);
+};
+
+template <typename F>
+void FrameLog::forEach(F f, std::size_t num) const
+{
+    const auto head = written();
+    const auto size = std::min<uint64_t>({head, uint64_t(capacity_), uint64_t(num)});
+
+    for(auto i = head - size; i != head; ++i)
+    {
+        const auto &slot = slots_[i % capacity_];
+        const auto seq = slot.seq.load(std::memory_order_acquire);
+
+        if(seq & 1) continue; /* being written */
+
+        Record record = slot.record;
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        /* overwritten while copying */
+        if(seq != slot.seq.load(std::memory_order_relaxed)) continue;
+        f(record);
+    }
+}
+
+} /* RTU */
+} /* Modbus */
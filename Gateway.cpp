@@ -0,0 +1,502 @@
+#include <sys/epoll.h>
+#include <sys/socket.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <iomanip>
+
+#include "Except.h"
+#include "Frame.h"
+#include "Gateway.h"
+#include "ReadCache.h"
+#include "Trace.h"
+
+namespace Modbus {
+namespace RTU {
+namespace {
+
+/* MBAP: transaction id, protocol id, length (unit + PDU), unit id */
+constexpr const std::size_t MBAP_HEADER_SIZE = 7;
+constexpr const std::size_t PDU_MAX_SIZE = 253;
+constexpr const uint64_t LISTENER_ID = 0;
+constexpr const int EVENT_NUM = 64;
+
+uint16_t toWord(const uint8_t *begin) { return uint16_t(begin[0] << 8 | begin[1]); }
+uint8_t lowByte(uint16_t word) { return word & 0xFF; }
+uint8_t highByte(uint16_t word) { return word >> 8; }
+
+bool isRead(uint8_t fcode)
+{
+    return
+        FCODE_RD_COILS == fcode
+        || FCODE_RD_HOLDING_REGISTERS == fcode
+        || FCODE_RD_BYTES == fcode;
+}
+
+/* PDU -> single request Plan, ECODE_* returned if PDU is not supported/valid */
+uint8_t compile(
+    Plan &plan, Addr unit,
+    const uint8_t *pdu, std::size_t size,
+    mSecs timeout, int retryNum)
+{
+    const auto fcode = pdu[0];
+
+    try
+    {
+        switch(fcode)
+        {
+            case FCODE_RD_COILS:
+                if(5 != size) return ECODE_ILLEGAL_DATA_VALUE;
+                plan.rdCoils(unit, toWord(pdu + 1), toWord(pdu + 3), timeout, retryNum);
+                break;
+            case FCODE_RD_HOLDING_REGISTERS:
+                if(5 != size || 0xFF < toWord(pdu + 3)) return ECODE_ILLEGAL_DATA_VALUE;
+                plan.rdRegisters(unit, toWord(pdu + 1), uint8_t(toWord(pdu + 3)), timeout, retryNum);
+                break;
+            case FCODE_WR_COIL:
+                if(5 != size) return ECODE_ILLEGAL_DATA_VALUE;
+                if(0xFF00 != toWord(pdu + 3) && 0x0000 != toWord(pdu + 3)) return ECODE_ILLEGAL_DATA_VALUE;
+                plan.wrCoil(unit, toWord(pdu + 1), 0xFF00 == toWord(pdu + 3), timeout, retryNum);
+                break;
+            case FCODE_WR_REGISTER:
+                if(5 != size) return ECODE_ILLEGAL_DATA_VALUE;
+                plan.wrRegister(unit, toWord(pdu + 1), toWord(pdu + 3), timeout, retryNum);
+                break;
+            case FCODE_WR_REGISTERS:
+            {
+                if(6 > size) return ECODE_ILLEGAL_DATA_VALUE;
+
+                const auto count = toWord(pdu + 3);
+
+                if(0 == count || 2u * count != pdu[5] || 6u + pdu[5] != size)
+                {
+                    return ECODE_ILLEGAL_DATA_VALUE;
+                }
+
+                Plan::DataSeq data;
+
+                for(auto i = pdu + 6; i != pdu + size; i += 2) data.push_back(toWord(i));
+                plan.wrRegisters(unit, toWord(pdu + 1), data, timeout, retryNum);
+                break;
+            }
+            case FCODE_RD_BYTES:
+                if(4 != size) return ECODE_ILLEGAL_DATA_VALUE;
+                plan.rdBytes(unit, toWord(pdu + 1), pdu[3], timeout, retryNum);
+                break;
+            case FCODE_WR_BYTES:
+                if(4 > size || 0 == pdu[3] || 4u + pdu[3] != size) return ECODE_ILLEGAL_DATA_VALUE;
+                plan.wrBytes(unit, toWord(pdu + 1), Plan::ByteSeq(pdu + 4, pdu + size), timeout, retryNum);
+                break;
+            default:
+                return ECODE_ILLEGAL_FUNCTION;
+        }
+    }
+    catch(const std::exception &)
+    {
+        /* out of range (e.g. count) */
+        return ECODE_ILLEGAL_DATA_VALUE;
+    }
+    return 0;
+}
+
+} /* namespace */
+
+Gateway::ByteSeq Gateway::key(const Job &job)
+{
+    return ByteSeq(job.plan.adu(0), job.plan.adu(0) + job.plan[0].aduSize);
+}
+
+void Gateway::forget(const Job &job)
+{
+    if(!isRead(job.fcode)) return;
+
+    const auto i = reads_.find(key(job));
+
+    /* entry may be dropped (write) and replaced by later read */
+    if(std::end(reads_) != i && &job == i->second.get()) reads_.erase(i);
+}
+
+Gateway::Gateway(Master &master, const std::string &address, Config config):
+    master_{master},
+    config_{config},
+    listener_{address},
+    epoll_{::epoll_create1(EPOLL_CLOEXEC)}
+{
+    ENSURE(epoll_, CRuntimeError);
+    ENSURE(0 < config_.retryNum && mSecs{0} < config_.timeout, RuntimeError);
+
+    epoll_event event{};
+
+    event.events = EPOLLIN;
+    event.data.u64 = LISTENER_ID;
+    ENSURE(-1 != ::epoll_ctl(epoll_.fd(), EPOLL_CTL_ADD, listener_.fd(), &event), CRuntimeError);
+}
+
+void Gateway::accept()
+{
+    for(;;)
+    {
+        auto fdGuard = listener_.accept(mSecs{0});
+
+        if(!fdGuard) return;
+
+        TcpPort::configure(fdGuard.fd());
+
+        const auto id = nextId_++;
+        auto &client = clients_.emplace(id, std::move(fdGuard)).first->second;
+        epoll_event event{};
+
+        event.events = EPOLLIN;
+        event.data.u64 = id;
+        ENSURE(-1 != ::epoll_ctl(epoll_.fd(), EPOLL_CTL_ADD, client.fdGuard.fd(), &event), CRuntimeError);
+        ++stats_.accepted;
+    }
+}
+
+void Gateway::close(uint64_t id)
+{
+    const auto i = clients_.find(id);
+
+    if(std::end(clients_) == i) return;
+
+    /* jobs shared with other clients are still executed */
+    for(auto &job : i->second.queue)
+    {
+        auto &waiters = job->waiters;
+
+        waiters.erase(
+            std::remove_if(
+                std::begin(waiters), std::end(waiters),
+                [id](const Waiter &waiter) { return id == waiter.client; }),
+            std::end(waiters));
+        if(!waiters.empty() || job->done) continue;
+        job->done = true;
+        forget(*job);
+    }
+    (void)::epoll_ctl(epoll_.fd(), EPOLL_CTL_DEL, i->second.fdGuard.fd(), nullptr);
+    clients_.erase(i);
+    ++stats_.closed;
+}
+
+void Gateway::collect()
+{
+    for(auto i = std::begin(clients_); i != std::end(clients_);)
+    {
+        const auto id = i->first;
+        const auto broken = i->second.broken;
+
+        ++i;
+        if(broken) close(id);
+    }
+}
+
+void Gateway::watch(uint64_t id, Client &client, bool writing)
+{
+    if(writing == client.writing) return;
+
+    epoll_event event{};
+
+    event.events = uint32_t(EPOLLIN) | (writing ? uint32_t(EPOLLOUT) : 0u);
+    event.data.u64 = id;
+    ENSURE(-1 != ::epoll_ctl(epoll_.fd(), EPOLL_CTL_MOD, client.fdGuard.fd(), &event), CRuntimeError);
+    client.writing = writing;
+}
+
+void Gateway::receive(uint64_t id, Client &client)
+{
+    uint8_t buf[4096];
+
+    for(;;)
+    {
+        const auto r = ::recv(client.fdGuard.fd(), buf, sizeof(buf), 0);
+
+        if(-1 == r && (EAGAIN == errno || EWOULDBLOCK == errno)) break;
+        if(-1 == r && EINTR == errno) continue;
+        if(0 >= r)
+        {
+            client.broken = true;
+            return;
+        }
+        client.rx.insert(std::end(client.rx), buf, buf + r);
+    }
+
+    std::size_t offset = 0;
+
+    while(client.rx.size() - offset >= MBAP_HEADER_SIZE)
+    {
+        const auto frame = client.rx.data() + offset;
+        const auto length = toWord(frame + 4);
+
+        /* not Modbus - connection can not be resynchronized */
+        if(0 != toWord(frame + 2) || 2 > length || PDU_MAX_SIZE + 1 < length)
+        {
+            TRACE(TraceLevel::Warning, "invalid MBAP header, client ", id);
+            client.broken = true;
+            return;
+        }
+
+        const auto size = MBAP_HEADER_SIZE - 1 + length;
+
+        if(client.rx.size() - offset < size) break;
+        enqueue(id, client, frame, size);
+        offset += size;
+    }
+    client.rx.erase(std::begin(client.rx), std::next(std::begin(client.rx), offset));
+}
+
+void Gateway::transmit(uint64_t id, Client &client)
+{
+    std::size_t offset = 0;
+
+    while(offset < client.tx.size())
+    {
+        const auto r =
+            ::send(
+                client.fdGuard.fd(),
+                client.tx.data() + offset, client.tx.size() - offset,
+                MSG_NOSIGNAL);
+
+        if(-1 == r && (EAGAIN == errno || EWOULDBLOCK == errno)) break;
+        if(-1 == r && EINTR == errno) continue;
+        if(0 > r)
+        {
+            /* closed later - caller may still use client */
+            client.broken = true;
+            return;
+        }
+        offset += std::size_t(r);
+    }
+    client.tx.erase(std::begin(client.tx), std::next(std::begin(client.tx), offset));
+    watch(id, client, !client.tx.empty());
+}
+
+void Gateway::enqueue(uint64_t id, Client &client, const uint8_t *frame, std::size_t size)
+{
+    ++stats_.requests;
+
+    const Waiter waiter{id, toWord(frame)};
+    const auto unit = frame[6];
+    const auto pdu = frame + MBAP_HEADER_SIZE;
+    const auto pduSize = size - MBAP_HEADER_SIZE;
+    const auto fcode = pdu[0];
+
+    /* broadcast (0) is not replied by slaves - MBAP request would never complete */
+    if(0 == unit || 247 < unit)
+    {
+        respond(waiter, unit, fcode, ECODE_GATEWAY_PATH_UNAVAILABLE);
+        return;
+    }
+
+    if(client.queue.size() >= config_.queueLimit)
+    {
+        ++stats_.busy;
+        respond(waiter, unit, fcode, ECODE_SERVER_DEVICE_BUSY);
+        return;
+    }
+
+    auto job = std::make_shared<Job>();
+    const auto ecode = compile(job->plan, Addr{unit}, pdu, pduSize, config_.timeout, config_.retryNum);
+
+    if(ecode)
+    {
+        respond(waiter, unit, fcode, ecode);
+        return;
+    }
+
+    if(isRead(fcode))
+    {
+        const auto pendingWrite =
+            std::any_of(
+                std::begin(client.queue), std::end(client.queue),
+                [unit](const JobPtr &queued)
+                {
+                    return !queued->done && !isRead(queued->fcode) && unit == queued->unit;
+                });
+        auto &queued = reads_[key(*job)];
+
+        /* queued by every requester - executed on turn of first of them,
+         * possibly before own write of this client (which is not merged) */
+        if(queued && !pendingWrite)
+        {
+            ++stats_.deduplicated;
+            job = queued;
+        }
+        else if(!queued) queued = job;
+    }
+    else
+    {
+        /* reads queued so far (read before this write) are not shared with later reads */
+        for(auto i = std::begin(reads_); i != std::end(reads_);)
+        {
+            if(unit == i->first[0]) i = reads_.erase(i);
+            else ++i;
+        }
+    }
+
+    job->unit = unit;
+    job->fcode = fcode;
+    job->waiters.push_back(waiter);
+    client.queue.push_back(job);
+    if(!client.scheduled)
+    {
+        client.scheduled = true;
+        ready_.push_back(id);
+    }
+}
+
+void Gateway::respond(const Waiter &waiter, uint8_t unit, const uint8_t *pdu, std::size_t size)
+{
+    const auto i = clients_.find(waiter.client);
+
+    if(std::end(clients_) == i || i->second.broken) return;
+
+    auto &tx = i->second.tx;
+    const auto length = uint16_t(size + 1);
+
+    tx.insert(
+        std::end(tx),
+        {
+            highByte(waiter.tid), lowByte(waiter.tid),
+            0, 0, /* protocol id */
+            highByte(length), lowByte(length),
+            unit
+        });
+    tx.insert(std::end(tx), pdu, pdu + size);
+    transmit(waiter.client, i->second);
+}
+
+void Gateway::respond(const Waiter &waiter, uint8_t unit, uint8_t fcode, uint8_t ecode)
+{
+    const uint8_t pdu[] = {uint8_t(fcode | 0x80), uint8_t(ecode & 0x7F)};
+
+    ++stats_.exceptions;
+    respond(waiter, unit, pdu, sizeof(pdu));
+}
+
+void Gateway::execute(Job &job)
+{
+    job.done = true;
+    forget(job);
+
+    Executor executor{master_, job.plan};
+    auto status = Status::Request;
+
+    ++stats_.transactions;
+    try
+    {
+        status = executor.tryExec(0);
+    }
+    catch(const std::exception &except)
+    {
+        /* device failure - Master reopens it with next request */
+        TRACE(TraceLevel::Error, except.what());
+        for(const auto &waiter : job.waiters) respond(waiter, job.unit, job.fcode, ECODE_GATEWAY_PATH_UNAVAILABLE);
+        return;
+    }
+
+    const auto reply = executor.reply(0);
+
+    for(const auto &waiter : job.waiters)
+    {
+        if(Status::Ok == status)
+        {
+            /* without slave address and CRC */
+            respond(waiter, job.unit, reply + 1, job.plan[0].repSize - 1 - sizeof(CRC));
+        }
+        else if(Status::Exception == status)
+        {
+            respond(waiter, job.unit, job.fcode, uint8_t(reply[2] | 0x80));
+        }
+        else respond(waiter, job.unit, job.fcode, ECODE_GATEWAY_TARGET_FAILED);
+    }
+}
+
+void Gateway::step(mSecs timeout)
+{
+    epoll_event events[EVENT_NUM];
+    const auto r =
+        ::epoll_wait(
+            epoll_.fd(), events, EVENT_NUM,
+            ready_.empty() ? int(timeout.count()) : 0);
+
+    ENSURE(-1 != r || EINTR == errno, CRuntimeError);
+
+    for(int i = 0; i < r; ++i)
+    {
+        const auto id = events[i].data.u64;
+
+        if(LISTENER_ID == id)
+        {
+            accept();
+            continue;
+        }
+
+        /* may be closed while handling previous events */
+        const auto client = clients_.find(id);
+
+        if(std::end(clients_) == client || client->second.broken) continue;
+        if(events[i].events & (EPOLLERR | EPOLLHUP))
+        {
+            client->second.broken = true;
+            continue;
+        }
+        if(events[i].events & EPOLLOUT) transmit(id, client->second);
+        if(events[i].events & EPOLLIN) receive(id, client->second);
+    }
+    collect();
+
+    while(!ready_.empty())
+    {
+        const auto id = ready_.front();
+        const auto i = clients_.find(id);
+
+        ready_.pop_front();
+        if(std::end(clients_) == i) continue;
+
+        auto &client = i->second;
+
+        /* shared (deduplicated) jobs may be already executed */
+        while(!client.queue.empty() && client.queue.front()->done) client.queue.pop_front();
+        if(client.queue.empty())
+        {
+            client.scheduled = false;
+            continue;
+        }
+
+        const auto job = client.queue.front();
+
+        client.queue.pop_front();
+        /* back of the line - other clients go first */
+        ready_.push_back(id);
+        execute(*job);
+        collect();
+        break;
+    }
+}
+
+void Gateway::dump(std::ostream &os) const
+{
+    os
+        << "clients " << clients_.size()
+        << " accepted " << stats_.accepted
+        << " closed " << stats_.closed
+        << " requests " << stats_.requests
+        << " deduplicated " << stats_.deduplicated
+        << " transactions " << stats_.transactions
+        << " exceptions " << stats_.exceptions
+        << " busy " << stats_.busy
+        << '\n';
+
+    /* transactions replied from cache did not reach the bus */
+    if(const auto *const cache = master_.cache())
+    {
+        os
+            << "cache hits " << cache->stats().hits
+            << " misses " << cache->stats().misses
+            << " invalidated " << cache->stats().invalidated
+            << '\n';
+    }
+}
+
+} /* RTU */
+} /* Modbus */
@@ -0,0 +1,138 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "FdGuard.h"
+#include "Master.h"
+#include "Plan.h"
+#include "TcpPort.h"
+
+namespace Modbus {
+namespace RTU {
+
+/* Modbus TCP (MBAP) exception codes reported by gateway itself */
+constexpr const uint8_t ECODE_SERVER_DEVICE_BUSY = 0x86;
+constexpr const uint8_t ECODE_GATEWAY_PATH_UNAVAILABLE = 0x8A;
+constexpr const uint8_t ECODE_GATEWAY_TARGET_FAILED = 0x8B;
+
+/* Modbus TCP to RTU gateway: any number of TCP clients (epoll, single thread)
+ * share one Master (bus). Requests are queued per client and executed
+ * round robin (one request of every client with pending requests in turn),
+ * so a chatty client can not starve the others. Identical reads queued
+ * concurrently (same RTU ADU) are executed once and the reply is sent to every
+ * requester with its own transaction id - unless a write to the same unit is
+ * queued in between, or requester's own write to the unit is still pending
+ * (read must see it). Socket events are handled between
+ * bus transactions - next request is transmitted right after previous one
+ * completed (Master still enforces inter-frame silent interval). */
+class Gateway
+{
+public:
+    using ByteSeq = Master::ByteSeq;
+
+    struct Config
+    {
+        /* reply timeout and attempts of every RTU request */
+        mSecs timeout{100};
+        int retryNum{1};
+        /* pending requests per client, above it ECODE_SERVER_DEVICE_BUSY */
+        std::size_t queueLimit{32};
+    };
+
+    struct Stats
+    {
+        uint64_t accepted{0};
+        uint64_t closed{0};
+        /* MBAP requests received */
+        uint64_t requests{0};
+        /* requests served by other (identical) request's transaction */
+        uint64_t deduplicated{0};
+        /* RTU transactions executed */
+        uint64_t transactions{0};
+        /* replies with exception (slave or gateway) */
+        uint64_t exceptions{0};
+        uint64_t busy{0};
+    };
+private:
+    struct Waiter
+    {
+        uint64_t client;
+        uint16_t tid;
+    };
+
+    struct Job
+    {
+        Plan plan;
+        uint8_t unit;
+        uint8_t fcode;
+        bool done{false};
+        std::vector<Waiter> waiters;
+    };
+
+    using JobPtr = std::shared_ptr<Job>;
+
+    struct Client
+    {
+        explicit Client(FdGuard fd): fdGuard{std::move(fd)} {}
+
+        FdGuard fdGuard;
+        ByteSeq rx;
+        ByteSeq tx;
+        std::deque<JobPtr> queue;
+        bool scheduled{false};
+        bool writing{false};
+        /* transmission failed, closed by collect() */
+        bool broken{false};
+    };
+
+    Master &master_;
+    Config config_;
+    TcpListener listener_;
+    FdGuard epoll_;
+    /* 0 is reserved for listener */
+    uint64_t nextId_{1};
+    std::map<uint64_t, Client> clients_;
+    /* clients with pending requests, in order of service */
+    std::deque<uint64_t> ready_;
+    /* queued (not yet executed) reads by RTU ADU */
+    std::map<ByteSeq, JobPtr> reads_;
+    Stats stats_;
+
+    static ByteSeq key(const Job &);
+    /* executed (or abandoned) read is not shared any more */
+    void forget(const Job &);
+    void accept();
+    void close(uint64_t id);
+    void collect();
+    void receive(uint64_t id, Client &);
+    void transmit(uint64_t id, Client &);
+    void watch(uint64_t id, Client &, bool writing);
+    void enqueue(uint64_t id, Client &, const uint8_t *frame, std::size_t size);
+    void respond(const Waiter &, uint8_t unit, const uint8_t *pdu, std::size_t size);
+    void respond(const Waiter &, uint8_t unit, uint8_t fcode, uint8_t ecode);
+    void execute(Job &);
+public:
+    /* listen on [host:]port */
+    Gateway(Master &master, const std::string &address, Config config);
+
+    Gateway(const Gateway &) = delete;
+    Gateway &operator=(const Gateway &) = delete;
+
+    uint16_t port() const { return listener_.port(); }
+    /* handle socket events (waiting up to timeout only if nothing is queued)
+     * and execute at most one queued request */
+    void step(mSecs timeout);
+
+    std::size_t clientNum() const { return clients_.size(); }
+    const Stats &stats() const { return stats_; }
+    void dump(std::ostream &) const;
+};
+
+} /* RTU */
+} /* Modbus */
@@ -4,10 +4,13 @@
 #include <iomanip>
 #include <iostream>
 #include <thread>
+#include <type_traits>
 
 #include "Master.h"
 #include "Except.h"
-#include "crc.h"
+#include "Frame.h"
+#include "ReadCache.h"
+#include "TcpPort.h"
 
 namespace Modbus {
 namespace RTU {
@@ -16,19 +19,6 @@ namespace {
 using ByteSeq = Master::ByteSeq;
 using DataSeq  = Master::DataSeq;
 
-constexpr const uint8_t FCODE_RD_COILS = 1;
-constexpr const uint8_t FCODE_RD_HOLDING_REGISTERS = 3;
-constexpr const uint8_t FCODE_WR_COIL = 5;
-constexpr const uint8_t FCODE_WR_REGISTER = 6;
-constexpr const uint8_t FCODE_WR_REGISTERS = 16;
-constexpr const uint8_t FCODE_USER1_OFFSET = 65;
-constexpr const uint8_t FCODE_RD_BYTES = FCODE_USER1_OFFSET + 0;
-constexpr const uint8_t FCODE_WR_BYTES = FCODE_USER1_OFFSET + 1;
-constexpr const uint8_t ECODE_ILLEGAL_FUNCTION = 0x81;
-constexpr const uint8_t ECODE_ILLEGAL_DATA_ADDRESS = 0x82;
-constexpr const uint8_t ECODE_ILLEGAL_DATA_VALUE = 0x83;
-constexpr const uint8_t ECODE_SERVER_DEVICE_FAILURE = 0x84;
-
 uint8_t lowByte(uint16_t word) { return word & 0xFF; }
 uint8_t highByte(uint16_t word) { return word >> 8; }
 
@@ -165,34 +155,44 @@ ByteSeq &appendCRC(ByteSeq &seq)
     return seq;
 }
 
-void validateCRC(std::ostream &debugTo, const ByteSeq &seq)
+bool validCRC(std::ostream *debugTo, const uint8_t *begin, const uint8_t *const end)
 {
-    if(seq.empty()) return;
+    if(2 >= std::distance(begin, end)) return false;
 
-    ENSURE(2u < seq.size(), CRCError);
+    const CRC recvValue{*std::prev(end), *std::prev(end, 2)};
+    const auto calcValue = calcCRC(begin, std::prev(end, 2));
 
-    const CRC recvValue{*seq.rbegin(), *std::next(seq.rbegin())};
+    if(debugTo && debugActive())
+    {
+        const auto flags = debugTo->flags();
+        (*debugTo) << "rCRC ";
+        dump(*debugTo, recvValue.highByte());
+        dump(*debugTo, recvValue.lowByte());
+        (*debugTo) << " cCRC ";
+        dump(*debugTo, calcValue.highByte());
+        dump(*debugTo, calcValue.lowByte());
+        (*debugTo) << "\n";
+        debugTo->flags(flags);
+    }
 
-    const auto begin = seq.data();
-    auto calcValue = calcCRC(begin, std::next(begin, seq.size() - 2));
+    return recvValue.value == calcValue.value;
+}
 
-    const auto flags = debugTo.flags();
-    debugTo << "rCRC ";
-    dump(debugTo, recvValue.highByte());
-    dump(debugTo, recvValue.lowByte());
-    debugTo << " cCRC ";
-    dump(debugTo, calcValue.highByte());
-    dump(debugTo, calcValue.lowByte());
-    debugTo << "\n";
-    debugTo.flags(flags);
+/* addr + (fcode | 0x80) + ecode + crc */
+constexpr const mSecs connectTimeout{3000};
+constexpr const std::ptrdiff_t exceptionReplySize = 1 + 1 + 1 + sizeof(CRC);
 
-    ENSURE(recvValue.value == calcValue.value, CRCError);
+bool isException(const uint8_t *req, const uint8_t *rep)
+{
+    return req[0] == rep[0] && (req[1] | 0x80) == rep[1];
 }
 
 } /* namespace */
 
 Master::DebugScope::~DebugScope()
 {
+    if(!master_.debugging()) return;
+
     const auto str = master_.debugTo_.str();
     auto i = std::begin(str);
     const auto end = std::end(str);
@@ -202,7 +202,7 @@ Master::DebugScope::~DebugScope()
         auto j = std::find(i, end, '\n');
 
         trace(
-            std::uncaught_exceptions()
+            std::uncaught_exceptions() || Status::Ok != status_
             ? TraceLevel::Error
             : TraceLevel::Debug,
             std::string{i, j});
@@ -214,6 +214,15 @@ Master::DebugScope::~DebugScope()
     master_.debugTo_.str(std::string{});
 }
 
+void ensureOk(Status status)
+{
+    ENSURE(Status::Request != status, RequestError);
+    ENSURE(Status::Timeout != status, TimeoutError);
+    ENSURE(Status::CRC != status, CRCError);
+    ENSURE(Status::Exception != status, ReplyError);
+    ENSURE(Status::Reply != status, ReplyError);
+}
+
 Master::Master(
     std::string devName,
     BaudRate baudRate,
@@ -228,31 +237,61 @@ Master::Master(
 {
 }
 
+Master::Master(Transport &transport):
+    baudRate_{BaudRate::BR_19200},
+    parity_{Parity::None},
+    dataBits_{DataBits::Eight},
+    stopBits_{StopBits::One},
+    external_{&transport},
+    transport_{&transport}
+{
+}
+
 void Master::initDevice()
 {
-    if(dev_) return;
+    if(transport_) return;
 
-    dev_ =
-        std::make_unique<SerialPort>(devName_, baudRate_, parity_, dataBits_, stopBits_, &debugTo_);
+    if(TcpPort::isDevice(devName_))
+    {
+        dev_ =
+            std::make_unique<TcpPort>(
+                devName_, connectTimeout, debug_ ? &debugTo_ : nullptr);
+    }
+    else
+    {
+        dev_ =
+            std::make_unique<SerialPort>(
+                devName_, baudRate_, parity_, dataBits_, stopBits_,
+                debug_ ? &debugTo_ : nullptr);
+    }
     ENSURE(dev_, RuntimeError);
+    transport_ = dev_.get();
     updateTiming();
 }
 
+void Master::resetDevice()
+{
+    dev_.reset();
+    transport_ = external_;
+}
+
 void Master::drainDevice()
 {
     initDevice();
+    /* stream transport - nothing is waiting for the line */
+    if(!transport_->paced()) return;
     try
     {
-        dev_->drain();
+        transport_->drain();
     }
     catch(CRuntimeError &except)
     {
-        dev_.reset();
+        resetDevice();
         throw;
     }
     catch(RuntimeError &exept)
     {
-        dev_.reset();
+        resetDevice();
         throw;
     }
 }
@@ -262,16 +301,16 @@ void Master::flushDevice()
     initDevice();
     try
     {
-        dev_->flush();
+        transport_->flush();
     }
     catch(CRuntimeError &except)
     {
-        dev_.reset();
+        resetDevice();
         throw;
     }
     catch(RuntimeError &exept)
     {
-        dev_.reset();
+        resetDevice();
         throw;
     }
 }
@@ -281,19 +320,19 @@ uint8_t *Master::readDevice(uint8_t *begin, const uint8_t *const end, mSecs time
     initDevice();
     try
     {
-        ensureTiming();
-        auto *r = dev_->read(begin, end, timeout);
+        /* silent interval is required only before transmission */
+        auto *r = transport_->read(begin, end, timeout);
         updateTiming();
         return r;
     }
     catch(CRuntimeError &except)
     {
-        dev_.reset();
+        resetDevice();
         throw;
     }
     catch(RuntimeError &exept)
     {
-        dev_.reset();
+        resetDevice();
         throw;
     }
 }
@@ -303,156 +342,236 @@ const uint8_t *Master::writeDevice(const uint8_t *begin, const uint8_t *const en
     initDevice();
     try
     {
-        ensureTiming();
-        const auto *r = dev_->write(begin, end, timeout);
+        const auto *r = transport_->write(begin, end, timeout);
         updateTiming();
         return r;
     }
     catch(CRuntimeError &except)
     {
-        dev_.reset();
+        resetDevice();
         throw;
     }
     catch(RuntimeError &exept)
     {
-        dev_.reset();
+        resetDevice();
         throw;
     }
 }
 
-SerialPort &Master::device()
+void Master::debug(bool enable)
+{
+    debug_ = enable;
+    if(transport_) transport_->debugTo(debug_ ? &debugTo_ : nullptr);
+}
+
+Transport &Master::transport()
 {
     initDevice();
-    return *dev_;
+    return *transport_;
 }
 
-void Master::wrCoil(
-    Addr slaveAddr,
-    uint16_t memAddr,
-    bool data,
-    mSecs timeout)
+SerialPort &Master::device()
 {
-    DebugScope debuScope{*this};
-    flushDevice();
+    auto *port = dynamic_cast<SerialPort *>(&transport());
 
-    ByteSeq req
-    {
-        slaveAddr.value,
-        FCODE_WR_COIL,
-        highByte(memAddr),
-        lowByte(memAddr),
-        data ? static_cast<uint8_t>(0xFF) : static_cast<uint8_t>(0),
-        UINT8_C(0)
-    };
+    ENSURE(port, RuntimeError);
+    return *port;
+}
 
-    appendCRC(req);
+void Master::transact(
+    const uint8_t *reqBegin, const uint8_t *const reqEnd,
+    uint8_t *repBegin, uint8_t *const repEnd,
+    std::size_t echoSize,
+    mSecs timeout)
+{
+    ensureOk(tryTransact(reqBegin, reqEnd, repBegin, repEnd, echoSize, timeout));
+}
 
-    // request
-    {
-        const auto reqBegin = req.data();
-        const auto reqEnd = reqBegin + req.size();
-        const auto r = writeDevice(reqBegin, reqEnd, mSecs{0});
+Status Master::tryTransact(
+    const uint8_t *reqBegin, const uint8_t *const reqEnd,
+    uint8_t *repBegin, uint8_t *const repEnd,
+    std::size_t echoSize,
+    mSecs timeout)
+{
+    return transact(__FUNCTION__, reqBegin, reqEnd, repBegin, repEnd, echoSize, timeout);
+}
 
-        dump(debugTo_, DataSource::Master, __FUNCTION__, __LINE__, reqBegin, reqEnd, r);
-        ENSURE(reqEnd == r, RequestError);
-    }
+Status Master::transact(
+    const char *tag,
+    const uint8_t *reqBegin, const uint8_t *const reqEnd,
+    uint8_t *repBegin, uint8_t *const repEnd,
+    std::size_t echoSize,
+    mSecs timeout)
+{
+    auto status = Status::Ok;
+    DebugScope debuScope{*this, status};
 
-    drainDevice();
+    ENSURE(std::distance(reqBegin, reqEnd) > 1 /* slave + fcode */, RuntimeError);
+    ENSURE(std::distance(repBegin, repEnd) >= std::ptrdiff_t(echoSize + sizeof(CRC)), RuntimeError);
+    ENSURE(std::distance(reqBegin, reqEnd) >= std::ptrdiff_t(echoSize), RuntimeError);
 
-    constexpr const auto repSize =
-        1 /* slave */
-        + 1 /* fcode */
-        + 2 /* address */
-        + 2 /* value */
-        + sizeof(CRC);
-    ByteSeq rep(repSize, 0);
+    using std::chrono::duration_cast;
 
-    // reply
-    {
-        const auto repBegin = rep.data();
-        const auto repEnd = repBegin + rep.size();
-        const auto r = readDevice(repBegin, repEnd, timeout);
+    initDevice();
 
-        dump(debugTo_, DataSource::Slave, __FUNCTION__, __LINE__, repBegin, repEnd, r);
-        ENSURE(repBegin != r, TimeoutError);
+    if(cache_)
+    {
+        /* not a bus transaction - timing and frame log are left intact */
+        if(cache_->lookup(reqBegin, reqEnd, repBegin, repEnd, transport_->now())) return status;
+        /* write (whatever its outcome) makes cached data stale */
+        cache_->invalidate(reqBegin, reqEnd);
     }
 
-    validateCRC(debugTo_, rep);
-    ENSURE(
-        std::equal(
-            std::begin(rep), std::next(std::begin(rep), rep.size() - sizeof(CRC)),
-            std::begin(req)),
-        ReplyError);
-}
+    timing_ = Timing{reqBegin[0], reqBegin[1], Status::Ok, {}, {}, {}, {}, {}, {}, {}};
 
-void Master::wrRegister(
-    Addr slaveAddr,
-    uint16_t memAddr,
-    uint16_t data,
-    mSecs timeout)
-{
-    DebugScope debuScope{*this};
-    flushDevice();
-
-    ByteSeq req
-    {
-        slaveAddr.value,
-        FCODE_WR_REGISTER,
-        highByte(memAddr),
-        lowByte(memAddr),
-        highByte(data),
-        lowByte(data)
-    };
+    const auto finish =
+        [this, &status](Status result)
+        {
+            timing_.status = result;
+            timingStats_.record(timing_);
+            return status = result;
+        };
+
+    /* transport clock - wall clock or virtual (simulated transport) */
+    auto &clock = *transport_;
+    auto timestamp = clock.now();
+    const auto elapsed =
+        [&timestamp, &clock]()
+        {
+            const auto prev = timestamp;
 
-    const auto reqSize = req.size();
+            timestamp = clock.now();
+            return duration_cast<uSecs>(timestamp - prev);
+        };
 
-    appendCRC(req);
+    ensureTiming();
+    timing_.gap = elapsed();
+    flushDevice();
+    timing_.flush = elapsed();
 
     // request
     {
-        const auto reqBegin = req.data();
-        const auto reqEnd = reqBegin + req.size();
+        const auto txTimestamp = timestamp;
         const auto r = writeDevice(reqBegin, reqEnd, mSecs{0});
 
-        dump(debugTo_, DataSource::Master, __FUNCTION__, __LINE__, reqBegin, reqEnd, r);
-        ENSURE(reqEnd == r, RequestError);
+        timing_.write = elapsed();
+        if(debugging()) dump(debugTo_, DataSource::Master, tag, __LINE__, reqBegin, reqEnd, r);
+        frameLog_.record(
+            FrameLog::Direction::Tx,
+            txTimestamp, timestamp - txTimestamp,
+            reqEnd == r ? Status::Ok : Status::Request,
+            reqBegin, r);
+        if(reqEnd != r) return finish(Status::Request);
     }
 
     drainDevice();
-
-    ByteSeq rep(reqSize + sizeof(CRC), 0);
+    timing_.drain = elapsed();
+
+    auto end = repEnd;
+    const auto rxTimestamp = timestamp;
+    const uint8_t *rxEnd = repBegin;
+    /* reply is logged with final status of transaction */
+    const auto complete =
+        [&](Status result)
+        {
+            frameLog_.record(
+                FrameLog::Direction::Rx,
+                rxTimestamp, clock.now() - rxTimestamp,
+                result,
+                repBegin, rxEnd);
+            return finish(result);
+        };
 
     // reply
     {
-        const auto repBegin = rep.data();
-        const auto repEnd = repBegin + rep.size();
-        const auto r = readDevice(repBegin, repEnd, timeout);
+        /* read header first - if slave replies with exception
+         * there is no need to wait (timeout) for remaining data */
+        const auto headerEnd =
+            std::next(repBegin, std::min(exceptionReplySize, std::distance(repBegin, repEnd)));
+        auto r = readDevice(repBegin, headerEnd, timeout);
+        const auto firstRxTimestamp = transport_->firstRxTimestamp();
+
+        if(headerEnd == r && isException(reqBegin, repBegin)) end = headerEnd;
+        else if(headerEnd == r && headerEnd != repEnd)
+        {
+            const auto waited = duration_cast<mSecs>(clock.now() - rxTimestamp);
+            r = readDevice(r, repEnd, std::max(mSecs{0}, timeout - waited));
+        }
+
+        rxEnd = r;
+        elapsed();
+        if(repBegin == r) timing_.turnaround = duration_cast<uSecs>(timestamp - rxTimestamp);
+        else
+        {
+            timing_.turnaround = duration_cast<uSecs>(firstRxTimestamp - rxTimestamp);
+            timing_.receive = duration_cast<uSecs>(timestamp - firstRxTimestamp);
+        }
 
-        dump(debugTo_, DataSource::Slave, __FUNCTION__, __LINE__, repBegin, repEnd, r);
-        ENSURE(repBegin != r, TimeoutError);
+        if(debugging()) dump(debugTo_, DataSource::Slave, tag, __LINE__, repBegin, end, r);
+        if(repBegin == r) return complete(Status::Timeout);
+        /* reply buffer can be reused - partial reply must not be completed
+         * with stale data of previous one */
+        std::fill(r, end, UINT8_C(0));
     }
 
-    validateCRC(debugTo_, rep);
-    ENSURE(
-        std::equal(
-            std::begin(rep), std::next(std::begin(rep), rep.size() - sizeof(CRC)),
-            std::begin(req)),
-        ReplyError);
+    const auto crcValid = validCRC(debugging() ? &debugTo_ : nullptr, repBegin, end);
+
+    timing_.crc = elapsed();
+    if(!crcValid) return complete(Status::CRC);
+    if(end != repEnd) return complete(Status::Exception);
+    if(!std::equal(repBegin, std::next(repBegin, echoSize), reqBegin)) return complete(Status::Reply);
+    /* data is at least as old as request */
+    if(cache_) cache_->store(reqBegin, reqEnd, repBegin, repEnd, rxTimestamp);
+    return complete(Status::Ok);
 }
 
-void Master::wrRegisters(
+Status Master::tryWrCoil(
     Addr slaveAddr,
     uint16_t memAddr,
-    const DataSeq &dataSeq,
+    bool data,
     mSecs timeout)
 {
-    DebugScope debuScope{*this};
+    const auto req = makeRequest<FCODE_WR_COIL>(slaveAddr.value, memAddr, data);
+    /* reply is an echo of request */
+    std::remove_const_t<decltype(req)> rep{};
+
+    return
+        transact(
+            __FUNCTION__,
+            req.data(), req.data() + req.size(),
+            rep.data(), rep.data() + rep.size(),
+            rep.size() - sizeof(CRC),
+            timeout);
+}
 
-    if(dataSeq.empty()) return;
+Status Master::tryWrRegister(
+    Addr slaveAddr,
+    uint16_t memAddr,
+    uint16_t data,
+    mSecs timeout)
+{
+    const auto req = makeRequest<FCODE_WR_REGISTER>(slaveAddr.value, memAddr, data);
+    /* reply is an echo of request */
+    std::remove_const_t<decltype(req)> rep{};
+
+    return
+        transact(
+            __FUNCTION__,
+            req.data(), req.data() + req.size(),
+            rep.data(), rep.data() + rep.size(),
+            rep.size() - sizeof(CRC),
+            timeout);
+}
 
-    ENSURE(0x7C > dataSeq.size(), RuntimeError);
+Status Master::tryWrRegisters(
+    Addr slaveAddr,
+    uint16_t memAddr,
+    const DataSeq &dataSeq,
+    mSecs timeout)
+{
+    if(dataSeq.empty()) return Status::Ok;
 
-    flushDevice();
+    ENSURE(0x7C > dataSeq.size(), RuntimeError);
 
     ByteSeq req
     {
@@ -466,186 +585,101 @@ void Master::wrRegisters(
     append(req, dataSeq);
     appendCRC(req);
 
-    // request
-    {
-        const auto reqBegin = req.data();
-        const auto reqEnd = reqBegin + req.size();
-        const auto r = writeDevice(reqBegin, reqEnd, mSecs{0});
-
-        dump(debugTo_, DataSource::Master, __FUNCTION__, __LINE__, reqBegin, reqEnd, r);
-        ENSURE(reqEnd == r, RequestError);
-    }
-
-    drainDevice();
-
-    ByteSeq rep(
+    Frame<
         1 /* addr */
         + 1 /* fcode */
         + 2 /* starting address */
         + 2 /* quantity of registers */
-        + sizeof(CRC), 0);
-
-    // reply
-    {
-        const auto repBegin = rep.data();
-        const auto repEnd = repBegin + rep.size();
-        const auto r = readDevice(repBegin, repEnd, timeout);
-
-        dump(debugTo_, DataSource::Slave, __FUNCTION__, __LINE__, repBegin, repEnd, r);
-        ENSURE(repBegin != r, TimeoutError);
-    }
-
-    validateCRC(debugTo_, rep);
-    ENSURE(
-        std::equal(
-            std::begin(rep), std::next(std::begin(rep), rep.size() - sizeof(CRC)),
-            std::begin(req)),
-        ReplyError);
+        + sizeof(CRC)> rep{};
+
+    return
+        transact(
+            __FUNCTION__,
+            req.data(), req.data() + req.size(),
+            rep.data(), rep.data() + rep.size(),
+            rep.size() - sizeof(CRC),
+            timeout);
 }
 
-DataSeq Master::rdCoils(
+Status Master::tryRdCoils(
     Addr slaveAddr,
     uint16_t memAddr,
     uint16_t count,
+    DataSeq &dataSeq,
     mSecs timeout)
 {
-    DebugScope debuScope{*this};
-
     ENSURE(0 < count, RuntimeError);
     ENSURE(0x7D1 > count, RuntimeError);
 
-    flushDevice();
-
-    ByteSeq req
-    {
-        slaveAddr.value,
-        FCODE_RD_COILS,
-        highByte(memAddr),
-        lowByte(memAddr),
-        highByte(count),
-        lowByte(count)
-    };
-
-    appendCRC(req);
-
-    // request
-    {
-        const auto reqBegin = req.data();
-        const auto reqEnd = reqBegin + req.size();
-        const auto r = writeDevice(reqBegin, reqEnd, mSecs{0});
-
-        dump(debugTo_, DataSource::Master, __FUNCTION__, __LINE__, reqBegin, reqEnd, r);
-        ENSURE(reqEnd == r, RequestError);
-    }
-
-    drainDevice();
+    const auto req = reqCache_.request(FCODE_RD_COILS, slaveAddr.value, memAddr, count);
 
     constexpr const auto repHeaderSize = 1 /* slave */ + 1 /* fcode */ + 1 /* byte count */;
     const auto payloadSize = (count >> 3) + (count & 0x7 ? 1 : 0);
     const auto repSize = repHeaderSize + payloadSize  /* data[] */ + sizeof(CRC);
     ByteSeq rep(repSize, 0);
 
-    // reply
-    {
-        const auto repBegin = rep.data();
-        const auto repEnd = repBegin + rep.size();
-        const auto r = readDevice(repBegin, repEnd, timeout);
+    const auto status =
+        transact(
+            __FUNCTION__,
+            req.begin(), req.end(),
+            rep.data(), rep.data() + rep.size(),
+            2 /* slave + fcode */,
+            timeout);
 
-        dump(debugTo_, DataSource::Slave, __FUNCTION__, __LINE__, repBegin, repEnd, r);
-        ENSURE(repBegin != r, TimeoutError);
-    }
+    if(Status::Ok != status) return status;
 
-    validateCRC(debugTo_, rep);
-    ENSURE(rep[0] == slaveAddr.value, ReplyError);
-    ENSURE(rep[1] == FCODE_RD_COILS, ReplyError);
-
-    auto dataSeq =
-        DataSeq(
-            std::next(std::begin(rep), repHeaderSize),
-            std::next(std::begin(rep), rep.size() - sizeof(CRC)));
-
-    return dataSeq;
+    dataSeq.assign(
+        std::next(std::begin(rep), repHeaderSize),
+        std::next(std::begin(rep), rep.size() - sizeof(CRC)));
+    return status;
 }
 
-DataSeq Master::rdRegisters(
+Status Master::tryRdRegisters(
     Addr slaveAddr,
     uint16_t memAddr,
     uint8_t count,
+    DataSeq &dataSeq,
     mSecs timeout)
 {
-    DebugScope debuScope{*this};
-
     ENSURE(0 < count, RuntimeError);
     ENSURE(0x7E > count, RuntimeError);
 
-    flushDevice();
-
-    ByteSeq req
-    {
-        slaveAddr.value,
-        FCODE_RD_HOLDING_REGISTERS,
-        highByte(memAddr),
-        lowByte(memAddr),
-        highByte(count),
-        lowByte(count)
-    };
-
-    appendCRC(req);
-
-    // request
-    {
-        const auto reqBegin = req.data();
-        const auto reqEnd = reqBegin + req.size();
-        const auto r = writeDevice(reqBegin, reqEnd, mSecs{0});
-
-        dump(debugTo_, DataSource::Master, __FUNCTION__, __LINE__, reqBegin, reqEnd, r);
-        ENSURE(reqEnd == r, RequestError);
-    }
-
-    drainDevice();
+    const auto req = reqCache_.request(FCODE_RD_HOLDING_REGISTERS, slaveAddr.value, memAddr, count);
 
     constexpr const auto repHeaderSize = 1 /* slave */ + 1 /* fcode */ + 1 /* byte count */;
     const auto repSize = repHeaderSize + (count << 1)  /* data[] */ + sizeof(CRC);
     ByteSeq rep(repSize, 0);
 
-    // reply
-    {
-        const auto repBegin = rep.data();
-        const auto repEnd = repBegin + rep.size();
-        const auto r = readDevice(repBegin, repEnd, timeout);
-
-        dump(debugTo_, DataSource::Slave, __FUNCTION__, __LINE__, repBegin, repEnd, r);
-        ENSURE(repBegin != r, TimeoutError);
-    }
+    const auto status =
+        transact(
+            __FUNCTION__,
+            req.begin(), req.end(),
+            rep.data(), rep.data() + rep.size(),
+            2 /* slave + fcode */,
+            timeout);
 
-    validateCRC(debugTo_, rep);
-    ENSURE(rep[0] == slaveAddr.value, ReplyError);
-    ENSURE(rep[1] == FCODE_RD_HOLDING_REGISTERS, ReplyError);
+    if(Status::Ok != status) return status;
 
-    auto dataSeq =
+    dataSeq =
         toDataSeq(
             ByteSeq
             {
                 std::next(std::begin(rep), repHeaderSize),
                 std::next(std::begin(rep), rep.size() - sizeof(CRC))
             });
-    return dataSeq;
+    return status;
 }
 
-void Master::wrBytes(
+Status Master::tryWrBytes(
     Addr slaveAddr,
     uint16_t memAddr,
     const ByteSeq &byteSeq,
     mSecs timeout)
 {
-    DebugScope debuScope{*this};
-
-    if(byteSeq.empty()) return;
+    if(byteSeq.empty()) return Status::Ok;
 
     ENSURE(250u > byteSeq.size(), RuntimeError);
 
-    flushDevice();
-
     ByteSeq req
     {
         slaveAddr.value,
@@ -660,119 +694,108 @@ void Master::wrBytes(
     append(req, byteSeq);
     appendCRC(req);
 
-    // request
-    {
-        const auto reqBegin = req.data();
-        const auto reqEnd = reqBegin + req.size();
-        const auto r = writeDevice(reqBegin, reqEnd, mSecs{0});
-
-        dump(debugTo_, DataSource::Master, __FUNCTION__, __LINE__, reqBegin, reqEnd, r);
-        ENSURE(reqEnd == r, RequestError);
-    }
-
-    drainDevice();
-
     ByteSeq rep(reqSize + sizeof(CRC), 0);
 
-    // reply
-    {
-        const auto repBegin = rep.data();
-        const auto repEnd = repBegin + rep.size();
-        const auto r = readDevice(repBegin, repEnd, timeout);
-
-        dump(debugTo_, DataSource::Slave, __FUNCTION__, __LINE__, repBegin, repEnd, r);
-        ENSURE(repBegin != r, TimeoutError);
-    }
-
-    validateCRC(debugTo_, rep);
-    ENSURE(
-        std::equal(
-            std::begin(rep), std::next(std::begin(rep), rep.size() - sizeof(CRC)),
-            std::begin(req)),
-        ReplyError);
+    return
+        transact(
+            __FUNCTION__,
+            req.data(), req.data() + req.size(),
+            rep.data(), rep.data() + rep.size(),
+            reqSize,
+            timeout);
 }
 
-ByteSeq Master::rdBytes(
+Status Master::tryRdBytes(
     Addr slaveAddr,
     uint16_t memAddr,
     uint8_t count,
+    ByteSeq &dataSeq,
     mSecs timeout)
 {
-    DebugScope debuScope{*this};
-
     ENSURE(0 < count, RuntimeError);
     ENSURE(250 > count, RuntimeError);
 
-    flushDevice();
+    const auto req = reqCache_.request(FCODE_RD_BYTES, slaveAddr.value, memAddr, count);
+    const auto reqHeaderSize = req.size - sizeof(CRC);
+    const auto repHeaderSize = reqHeaderSize;
+    const auto repSize = repHeaderSize + count  /* data[] */ + sizeof(CRC);
+    ByteSeq rep(repSize, 0);
 
-    ByteSeq req
-    {
-        slaveAddr.value,
-        FCODE_RD_BYTES,
-        highByte(memAddr),
-        lowByte(memAddr),
-        uint8_t(count)
-    };
+    const auto status =
+        transact(
+            __FUNCTION__,
+            req.begin(), req.end(),
+            rep.data(), rep.data() + rep.size(),
+            repHeaderSize,
+            timeout);
 
-    const auto reqHeaderSize = req.size();
+    if(Status::Ok != status) return status;
 
-    appendCRC(req);
+    dataSeq.assign(
+        std::next(std::begin(rep), repHeaderSize),
+        std::next(std::begin(rep), rep.size() - sizeof(CRC)));
+    return status;
+}
 
-    // request
-    {
-        const auto reqBegin = req.data();
-        const auto reqEnd = reqBegin + req.size();
-        const auto r = writeDevice(reqBegin, reqEnd, mSecs{0});
+void Master::wrCoil(Addr slaveAddr, uint16_t memAddr, bool data, mSecs timeout)
+{
+    ensureOk(tryWrCoil(slaveAddr, memAddr, data, timeout));
+}
 
-        dump(debugTo_, DataSource::Master, __FUNCTION__, __LINE__, reqBegin, reqEnd, r);
-        ENSURE(reqEnd == r, RequestError);
-    }
+void Master::wrRegister(Addr slaveAddr, uint16_t memAddr, uint16_t data, mSecs timeout)
+{
+    ensureOk(tryWrRegister(slaveAddr, memAddr, data, timeout));
+}
 
-    drainDevice();
+void Master::wrRegisters(Addr slaveAddr, uint16_t memAddr, const DataSeq &data, mSecs timeout)
+{
+    ensureOk(tryWrRegisters(slaveAddr, memAddr, data, timeout));
+}
 
-    const auto repHeaderSize = reqHeaderSize;
-    const auto repSize = repHeaderSize + count  /* data[] */ + sizeof(CRC);
-    ByteSeq rep(repSize, 0);
+DataSeq Master::rdCoils(Addr slaveAddr, uint16_t memAddr, uint16_t count, mSecs timeout)
+{
+    DataSeq data;
 
-    // reply
-    {
-        const auto repBegin = rep.data();
-        const auto repEnd = repBegin + rep.size();
-        const auto r = readDevice(repBegin, repEnd, timeout);
+    ensureOk(tryRdCoils(slaveAddr, memAddr, count, data, timeout));
+    return data;
+}
 
-        dump(debugTo_, DataSource::Slave, __FUNCTION__, __LINE__, repBegin, repEnd, r);
-        ENSURE(repBegin != r, TimeoutError);
-    }
+DataSeq Master::rdRegisters(Addr slaveAddr, uint16_t memAddr, uint8_t count, mSecs timeout)
+{
+    DataSeq data;
 
-    validateCRC(debugTo_, rep);
+    ensureOk(tryRdRegisters(slaveAddr, memAddr, count, data, timeout));
+    return data;
+}
 
-    ENSURE(
-        std::equal(
-            std::begin(rep), std::next(std::begin(rep), repHeaderSize),
-            std::begin(req)),
-        ReplyError);
+void Master::wrBytes(Addr slaveAddr, uint16_t memAddr, const ByteSeq &data, mSecs timeout)
+{
+    ensureOk(tryWrBytes(slaveAddr, memAddr, data, timeout));
+}
 
-    ByteSeq dataSeq
-    {
-        std::next(std::begin(rep), repHeaderSize),
-        std::next(std::begin(rep), rep.size() - sizeof(CRC))
-    };
+ByteSeq Master::rdBytes(Addr slaveAddr, uint16_t memAddr, uint8_t count, mSecs timeout)
+{
+    ByteSeq data;
 
-    return dataSeq;
+    ensureOk(tryRdBytes(slaveAddr, memAddr, count, data, timeout));
+    return data;
 }
 
 void Master::updateTiming()
 {
-    timestamp_ = std::chrono::steady_clock::now();
+    timestamp_ = transport_->now();
 }
 
 void Master::ensureTiming()
 {
     using namespace std::chrono;
 
-    const auto now = steady_clock::now();
+    /* frames are not delimited by silence e.g. RTU over TCP */
+    if(!transport_->paced()) return;
+
+    const auto now = transport_->now();
 
-    ENSURE(now > timestamp_, RuntimeError);
+    ENSURE(now >= timestamp_, RuntimeError);
     const auto elapsed = now - timestamp_;
 
     if(elapsed >= interFrameTimeout()) return;
@@ -780,7 +803,7 @@ void Master::ensureTiming()
     const auto diff = interFrameTimeout() - duration_cast<microseconds>(elapsed);
 
     TRACE(TraceLevel::Trace, "waiting ", diff.count(), "us");
-    std::this_thread::sleep_for(diff);
+    transport_->sleepFor(diff);
 }
 
 } /* RTU */
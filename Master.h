@@ -8,7 +8,12 @@
 #include <vector>
 
 #include "Ensure.h"
+#include "Frame.h"
+#include "FrameLog.h"
 #include "SerialPort.h"
+#include "Status.h"
+#include "Timing.h"
+#include "TraceLevel.h"
 
 namespace Modbus {
 namespace RTU {
@@ -45,6 +50,11 @@ std::chrono::microseconds interFrameTimeout() { return std::chrono::microseconds
 
 using mSecs = std::chrono::milliseconds;
 
+/* map failure to exception: RequestError, TimeoutError, CRCError, ReplyError */
+void ensureOk(Status);
+
+class ReadCache;
+
 struct Master
 {
     using BaudRate = SerialPort::BaudRate;
@@ -57,35 +67,96 @@ private:
     class DebugScope
     {
         Master &master_;
+        const Status &status_;
     public:
-        DebugScope(Master &master): master_{master} {}
+        DebugScope(Master &master, const Status &status): master_{master}, status_{status} {}
         ~DebugScope();
     };
 
     std::ostringstream debugTo_;
+    bool debug_{false};
     std::string devName_;
     BaudRate baudRate_;
     Parity parity_;
     DataBits dataBits_;
     StopBits stopBits_;
-    std::unique_ptr<SerialPort> dev_;
+    /* SerialPort or TcpPort (devName_ tcp://host:port) */
+    std::unique_ptr<Transport> dev_;
+    /* not owned, see Master(Transport &) */
+    Transport *external_{nullptr};
+    /* dev_ or external_ */
+    Transport *transport_{nullptr};
     std::chrono::steady_clock::time_point timestamp_;
+    /* not owned, see cache() */
+    ReadCache *cache_{nullptr};
+    FrameCache reqCache_;
+    FrameLog frameLog_;
+    Timing timing_{};
+    TimingStats timingStats_;
 
     void initDevice();
+    void resetDevice();
     void drainDevice();
     void flushDevice();
     uint8_t *readDevice(uint8_t *begin, const uint8_t *const end, mSecs timeout);
     const uint8_t *writeDevice(const uint8_t *begin, const uint8_t *const end, mSecs timeout);
     void updateTiming();
     void ensureTiming();
+    bool debugging() const { return debug_ && debugActive(); }
+    Status transact(
+        const char *tag,
+        const uint8_t *reqBegin, const uint8_t *const reqEnd,
+        uint8_t *repBegin, uint8_t *const repEnd,
+        std::size_t echoSize,
+        mSecs timeout);
 public:
+    /* devName: serial device or tcp://host:port (raw RTU over TCP, line
+     * settings are then configured on device server) */
     Master(
         std::string devName,
         BaudRate baudRate = BaudRate::BR_19200,
         Parity parity = Parity::Even,
         DataBits dataBits = DataBits::Eight,
         StopBits stopBits = StopBits::One);
+    /* transport (and its clock) provided by caller e.g. VirtualPort,
+     * it must outlive Master */
+    explicit Master(Transport &transport);
+    Transport &transport();
+    /* transport if it is SerialPort (RuntimeError otherwise) */
     SerialPort &device();
+    /* debug output: hex dumps of every request/reply, CRC and timing info.
+     * Disabled by default - formatted only if enabled and Debug trace level
+     * is active (see traceLevel()), with DISABLE_DEBUG_DUMP not compiled in */
+    void debug(bool enable);
+    bool debug() const { return debug_; }
+    /* raw history of last transactions (every request and reply),
+     * always recorded - decoded only on demand */
+    const FrameLog &frameLog() const { return frameLog_; }
+    /* timing breakdown of last transaction (any status) */
+    const Timing &timing() const { return timing_; }
+    /* timing of all transactions aggregated per slave/fcode */
+    const TimingStats &timingStats() const { return timingStats_; }
+    void clearTimingStats() { timingStats_.clear(); }
+    /* optional read-through cache (nullptr - disabled), it must outlive Master:
+     * reads covered by fresh cached data are replied without bus transaction
+     * (not recorded in frameLog/timing), writes invalidate cached data */
+    void cache(ReadCache *cache) { cache_ = cache; }
+    ReadCache *cache() const { return cache_; }
+    /* non-throwing API: transaction failures are reported as Status,
+     * (invalid arguments and device failures are still reported with exceptions) */
+    Status tryWrCoil(Addr slaveAddr, uint16_t memAddr, bool data, mSecs timeout);
+    Status tryWrRegister(Addr slaveAddr, uint16_t memAddr, uint16_t data, mSecs timeout);
+    Status tryWrRegisters(Addr slaveAddr, uint16_t memAddr, const DataSeq &data, mSecs timeout);
+    Status tryRdCoils(Addr slaveAddr, uint16_t memAddr, uint16_t count, DataSeq &data, mSecs timeout);
+    Status tryRdRegisters(Addr slaveAddr, uint16_t memAddr, uint8_t count, DataSeq &data, mSecs timeout);
+    Status tryWrBytes(Addr slaveAddr, uint16_t memAddr, const ByteSeq &data, mSecs timeout);
+    Status tryRdBytes(Addr slaveAddr, uint16_t memAddr, uint8_t count, ByteSeq &data, mSecs timeout);
+    Status tryTransact(
+        const uint8_t *reqBegin, const uint8_t *const reqEnd,
+        uint8_t *repBegin, uint8_t *const repEnd,
+        std::size_t echoSize,
+        mSecs timeout);
+
     void wrCoil(Addr slaveAddr, uint16_t memAddr, bool data, mSecs timeout);
     void wrRegister(Addr slaveAddr, uint16_t memAddr, uint16_t data, mSecs timeout);
     void wrRegisters(Addr slaveAddr, uint16_t memAddr, const DataSeq &data, mSecs timeout);
@@ -93,6 +164,14 @@ public:
     DataSeq rdRegisters(Addr slaveAddr, uint16_t memAddr, uint8_t count, mSecs timeout);
     void wrBytes(Addr slaveAddr, uint16_t memAddr, const ByteSeq &data, mSecs timeout);
     ByteSeq rdBytes(Addr slaveAddr, uint16_t memAddr, uint8_t count, mSecs timeout);
+    /* execute prebuilt request [reqBegin, reqEnd) (complete ADU including CRC),
+     * reply is received into [repBegin, repEnd) and validated:
+     * CRC and first echoSize bytes, which must match request */
+    void transact(
+        const uint8_t *reqBegin, const uint8_t *const reqEnd,
+        uint8_t *repBegin, uint8_t *const repEnd,
+        std::size_t echoSize,
+        mSecs timeout);
 };
 
 } /* RTU */
@@ -0,0 +1,241 @@
+#include <algorithm>
+
+#include "Except.h"
+#include "Frame.h"
+#include "Plan.h"
+
+namespace Modbus {
+namespace RTU {
+namespace {
+
+using ByteSeq = Plan::ByteSeq;
+using DataSeq = Plan::DataSeq;
+
+uint8_t lowByte(uint16_t word) { return word & 0xFF; }
+uint8_t highByte(uint16_t word) { return word >> 8; }
+
+ByteSeq &appendCRC(ByteSeq &seq)
+{
+    const auto crc = calcCRC(seq.data(), seq.data() + seq.size());
+
+    seq.push_back(crc.lowByte());
+    seq.push_back(crc.highByte());
+    return seq;
+}
+
+} /* namespace */
+
+void Plan::add(
+    Addr slave, uint8_t fcode, uint16_t addr, uint16_t count,
+    mSecs timeout, int retryNum,
+    const uint8_t *aduBegin, const uint8_t *const aduEnd,
+    std::size_t repSize, std::size_t echoSize, std::size_t dataOffset)
+{
+    ENSURE(0 < retryNum, RuntimeError);
+    ENSURE(mSecs{0} < timeout, RuntimeError);
+
+    const auto aduSize = std::distance(aduBegin, aduEnd);
+
+    requests_.push_back(
+        Request
+        {
+            timeout,
+            retryNum,
+            uint32_t(adus_.size()),
+            uint32_t(repSize_),
+            addr,
+            count,
+            uint16_t(aduSize),
+            uint16_t(aduSize ? repSize : 0),
+            slave.value,
+            fcode,
+            uint8_t(echoSize),
+            uint8_t(dataOffset)
+        });
+
+    adus_.insert(std::end(adus_), aduBegin, aduEnd);
+    repSize_ += requests_.back().repSize;
+}
+
+void Plan::rdCoils(Addr slave, uint16_t memAddr, uint16_t count, mSecs timeout, int retryNum)
+{
+    ENSURE(0 < count, RuntimeError);
+    ENSURE(0x7D1 > count, RuntimeError);
+
+    const auto adu = makeRequest<FCODE_RD_COILS>(slave.value, memAddr, count);
+    constexpr const auto repHeaderSize = 1 /* slave */ + 1 /* fcode */ + 1 /* byte count */;
+    const auto payloadSize = (count >> 3) + (count & 0x7 ? 1 : 0);
+
+    add(
+        slave, FCODE_RD_COILS, memAddr, count, timeout, retryNum,
+        adu.data(), adu.data() + adu.size(),
+        repHeaderSize + payloadSize + sizeof(CRC), 2 /* slave + fcode */, repHeaderSize);
+}
+
+void Plan::rdRegisters(Addr slave, uint16_t memAddr, uint8_t count, mSecs timeout, int retryNum)
+{
+    ENSURE(0 < count, RuntimeError);
+    ENSURE(0x7E > count, RuntimeError);
+
+    const auto adu = makeRequest<FCODE_RD_HOLDING_REGISTERS>(slave.value, memAddr, count);
+    constexpr const auto repHeaderSize = 1 /* slave */ + 1 /* fcode */ + 1 /* byte count */;
+
+    add(
+        slave, FCODE_RD_HOLDING_REGISTERS, memAddr, count, timeout, retryNum,
+        adu.data(), adu.data() + adu.size(),
+        repHeaderSize + (count << 1) + sizeof(CRC), 2 /* slave + fcode */, repHeaderSize);
+}
+
+void Plan::wrCoil(Addr slave, uint16_t memAddr, bool data, mSecs timeout, int retryNum)
+{
+    const auto adu = makeRequest<FCODE_WR_COIL>(slave.value, memAddr, data);
+
+    add(
+        slave, FCODE_WR_COIL, memAddr, 1, timeout, retryNum,
+        adu.data(), adu.data() + adu.size(),
+        adu.size(), adu.size() - sizeof(CRC), adu.size() - sizeof(CRC));
+}
+
+void Plan::wrRegister(Addr slave, uint16_t memAddr, uint16_t data, mSecs timeout, int retryNum)
+{
+    const auto adu = makeRequest<FCODE_WR_REGISTER>(slave.value, memAddr, data);
+
+    add(
+        slave, FCODE_WR_REGISTER, memAddr, 1, timeout, retryNum,
+        adu.data(), adu.data() + adu.size(),
+        adu.size(), adu.size() - sizeof(CRC), adu.size() - sizeof(CRC));
+}
+
+void Plan::wrRegisters(Addr slave, uint16_t memAddr, const DataSeq &data, mSecs timeout, int retryNum)
+{
+    ENSURE(0x7C > data.size(), RuntimeError);
+
+    constexpr const auto repSize =
+        1 /* addr */
+        + 1 /* fcode */
+        + 2 /* starting address */
+        + 2 /* quantity of registers */
+        + sizeof(CRC);
+
+    ByteSeq adu;
+
+    /* empty write is a no-op (same as Master::wrRegisters) */
+    if(!data.empty())
+    {
+        adu =
+        {
+            slave.value,
+            FCODE_WR_REGISTERS,
+            highByte(memAddr), lowByte(memAddr), /* starting address */
+            highByte(data.size()), lowByte(data.size()), /* quantity of registers */
+            uint8_t(data.size() << 1) /* byte_count */
+        };
+
+        for(auto word : data)
+        {
+            adu.push_back(highByte(word));
+            adu.push_back(lowByte(word));
+        }
+        appendCRC(adu);
+    }
+
+    add(
+        slave, FCODE_WR_REGISTERS, memAddr, uint16_t(data.size()), timeout, retryNum,
+        adu.data(), adu.data() + adu.size(),
+        repSize, repSize - sizeof(CRC), repSize - sizeof(CRC));
+}
+
+void Plan::wrBytes(Addr slave, uint16_t memAddr, const ByteSeq &data, mSecs timeout, int retryNum)
+{
+    ENSURE(250u > data.size(), RuntimeError);
+
+    constexpr const auto reqHeaderSize =
+        1 /* slave */ + 1 /* fcode */ + 2 /* address */ + 1 /* byte count */;
+
+    ByteSeq adu;
+
+    /* empty write is a no-op (same as Master::wrBytes) */
+    if(!data.empty())
+    {
+        adu = {slave.value, FCODE_WR_BYTES, highByte(memAddr), lowByte(memAddr), uint8_t(data.size())};
+        adu.insert(std::end(adu), std::begin(data), std::end(data));
+        appendCRC(adu);
+    }
+
+    add(
+        slave, FCODE_WR_BYTES, memAddr, uint16_t(data.size()), timeout, retryNum,
+        adu.data(), adu.data() + adu.size(),
+        reqHeaderSize + sizeof(CRC), reqHeaderSize, reqHeaderSize);
+}
+
+void Plan::rdBytes(Addr slave, uint16_t memAddr, uint8_t count, mSecs timeout, int retryNum)
+{
+    ENSURE(0 < count, RuntimeError);
+    ENSURE(250 > count, RuntimeError);
+
+    const auto adu = makeRequest<FCODE_RD_BYTES>(slave.value, memAddr, count);
+    const auto repHeaderSize = adu.size() - sizeof(CRC);
+
+    add(
+        slave, FCODE_RD_BYTES, memAddr, count, timeout, retryNum,
+        adu.data(), adu.data() + adu.size(),
+        repHeaderSize + count + sizeof(CRC), repHeaderSize, repHeaderSize);
+}
+
+Executor::Executor(Master &master, const Plan &plan):
+    master_{master},
+    plan_{plan},
+    replies_(plan.repSize(), UINT8_C(0))
+{}
+
+Status Executor::attempt(std::size_t i)
+{
+    ENSURE(plan_.size() > i, RuntimeError);
+
+    const auto &req = plan_[i];
+
+    if(0 == req.aduSize) return Status::Ok;
+
+    const auto aduBegin = plan_.adu(i);
+    const auto repBegin = replies_.data() + req.repOffset;
+
+    return
+        master_.tryTransact(
+            aduBegin, aduBegin + req.aduSize,
+            repBegin, repBegin + req.repSize,
+            req.echoSize, req.timeout);
+}
+
+Status Executor::tryExec(std::size_t i)
+{
+    ENSURE(plan_.size() > i, RuntimeError);
+
+    const auto &req = plan_[i];
+
+    for(auto retryNum = req.retryNum;;)
+    {
+        const auto status = attempt(i);
+
+        if(Status::Ok == status) return status;
+
+        --retryNum;
+        TRACE(
+            TraceLevel::Warning,
+            " failed (", toString(status), "),"
+            " retryNum ", retryNum,
+            " addr ", int(req.slave),
+            " fcode ", int(req.fcode));
+
+        if(!retryNum) return status;
+        /* transport clock - virtual time does not block */
+        master_.transport().sleepFor(req.timeout);
+    }
+}
+
+void Executor::exec(std::size_t i)
+{
+    ensureOk(tryExec(i));
+}
+
+} /* RTU */
+} /* Modbus */
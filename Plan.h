@@ -0,0 +1,89 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "Master.h"
+
+namespace Modbus {
+namespace RTU {
+
+/* Sequence of pre-validated and pre-encoded requests (ADUs with CRC).
+ * Plan is built once and can be executed any number of times (see Executor)
+ * without re-encoding or re-validating requests. */
+class Plan
+{
+public:
+    using ByteSeq = Master::ByteSeq;
+    using DataSeq = Master::DataSeq;
+
+    struct Request
+    {
+        mSecs timeout;
+        int retryNum;
+        uint32_t aduOffset;
+        uint32_t repOffset;
+        uint16_t addr;
+        uint16_t count;
+        uint16_t aduSize;
+        uint16_t repSize;
+        uint8_t slave;
+        uint8_t fcode;
+        /* number of leading reply bytes which must match request */
+        uint8_t echoSize;
+        /* offset of data[] in reply */
+        uint8_t dataOffset;
+    };
+private:
+    std::vector<Request> requests_;
+    ByteSeq adus_;
+    std::size_t repSize_{0};
+
+    void add(
+        Addr slave, uint8_t fcode, uint16_t addr, uint16_t count,
+        mSecs timeout, int retryNum,
+        const uint8_t *aduBegin, const uint8_t *const aduEnd,
+        std::size_t repSize, std::size_t echoSize, std::size_t dataOffset);
+public:
+    void rdCoils(Addr slave, uint16_t memAddr, uint16_t count, mSecs timeout, int retryNum);
+    void rdRegisters(Addr slave, uint16_t memAddr, uint8_t count, mSecs timeout, int retryNum);
+    void wrCoil(Addr slave, uint16_t memAddr, bool data, mSecs timeout, int retryNum);
+    void wrRegister(Addr slave, uint16_t memAddr, uint16_t data, mSecs timeout, int retryNum);
+    void wrRegisters(Addr slave, uint16_t memAddr, const DataSeq &data, mSecs timeout, int retryNum);
+    void wrBytes(Addr slave, uint16_t memAddr, const ByteSeq &data, mSecs timeout, int retryNum);
+    void rdBytes(Addr slave, uint16_t memAddr, uint8_t count, mSecs timeout, int retryNum);
+
+    std::size_t size() const { return requests_.size(); }
+    bool empty() const { return requests_.empty(); }
+    const Request &operator[](std::size_t i) const { return requests_[i]; }
+    const uint8_t *adu(std::size_t i) const { return adus_.data() + requests_[i].aduOffset; }
+    /* total size of all replies */
+    std::size_t repSize() const { return repSize_; }
+};
+
+/* Executes Plan using preallocated reply buffers,
+ * reply of every request stays available until it is executed again. */
+class Executor
+{
+    Master &master_;
+    const Plan &plan_;
+    Plan::ByteSeq replies_;
+public:
+    Executor(Master &master, const Plan &plan);
+
+    /* single attempt to execute i-th request (no retries) */
+    Status attempt(std::size_t i);
+    /* execute i-th request (with retries), status of last attempt is returned */
+    Status tryExec(std::size_t i);
+    /* same as tryExec() but failure is reported with same exceptions as Master */
+    void exec(std::size_t i);
+
+    const uint8_t *reply(std::size_t i) const { return replies_.data() + plan_[i].repOffset; }
+    const uint8_t *dataBegin(std::size_t i) const { return reply(i) + plan_[i].dataOffset; }
+    const uint8_t *dataEnd(std::size_t i) const { return reply(i) + plan_[i].repSize - sizeof(CRC); }
+    const Plan &plan() const { return plan_; }
+};
+
+} /* RTU */
+} /* Modbus */
@@ -33,3 +33,28 @@ PseudoPair createPseudoPair(
         SerialPort{std::move(sfd), baudRate, parity, dataBits, stopBits, slaveDbgTo}
     };
 }
+
+PseudoTerminal createPseudoTerminal(
+    SerialPort::BaudRate baudRate, SerialPort::Parity parity,
+    SerialPort::DataBits dataBits, SerialPort::StopBits stopBits,
+    std::ostream *masterDbgTo,
+    const char *multiplexor)
+{
+    assert(multiplexor);
+
+    FdGuard mfd{multiplexor, O_RDWR | O_NONBLOCK};
+
+    ENSURE(0 == ::grantpt(mfd.fd()), CRuntimeError);
+    ENSURE(0 == ::unlockpt(mfd.fd()), CRuntimeError);
+
+    char spath[PATH_MAX];
+    ENSURE(0 == ::ptsname_r(mfd.fd(), spath, sizeof(spath)), CRuntimeError);
+
+    FdGuard sfd{spath, O_RDWR | O_NONBLOCK | O_NOCTTY};
+
+    return
+    {
+        SerialPort{std::move(mfd), baudRate, parity, dataBits, stopBits, masterDbgTo},
+        std::move(sfd)
+    };
+}
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <ostream>
+#include <string>
 
 #include "SerialPort.h"
 
@@ -16,3 +17,19 @@ PseudoPair createPseudoPair(
     std::ostream *masterDbgTo = nullptr,
     std::ostream *slaveDbgTo = nullptr,
     const char *multiplexor = "/dev/ptmx");
+
+/* Only master side (multiplexor) is used as SerialPort, slave side is left
+ * to be opened by name (slave.path()) by someone else e.g. Modbus::RTU::Master.
+ * Slave fd is kept open (and never read) so master side does not see hangup
+ * when slave device is (re)opened. */
+struct PseudoTerminal
+{
+    SerialPort master;
+    FdGuard slave;
+};
+
+PseudoTerminal createPseudoTerminal(
+    SerialPort::BaudRate, SerialPort::Parity,
+    SerialPort::DataBits, SerialPort::StopBits,
+    std::ostream *masterDbgTo = nullptr,
+    const char *multiplexor = "/dev/ptmx");
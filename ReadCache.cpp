@@ -0,0 +1,375 @@
+#include <algorithm>
+#include <iterator>
+
+#include "Ensure.h"
+#include "Frame.h"
+#include "ReadCache.h"
+
+namespace Modbus {
+namespace RTU {
+namespace {
+
+/* slave, space and address range of request ADU */
+struct Access
+{
+    uint8_t slave;
+    ReadCache::Space space;
+    uint32_t begin;
+    uint32_t end;
+};
+
+uint16_t word(const uint8_t *data)
+{
+    return uint16_t((uint16_t(data[0]) << 8) | data[1]);
+}
+
+/* false if request is not a (complete) read */
+bool toRead(const uint8_t *req, std::size_t size, Access &access)
+{
+    if(sizeof(CRC) + 5 > size) return false;
+
+    access.slave = req[0];
+    access.begin = word(req + 2);
+
+    switch(req[1])
+    {
+        case FCODE_RD_COILS:
+            access.space = ReadCache::Space::Coils;
+            access.end = access.begin + word(req + 4);
+            break;
+        case FCODE_RD_HOLDING_REGISTERS:
+            access.space = ReadCache::Space::Registers;
+            access.end = access.begin + word(req + 4);
+            break;
+        case FCODE_RD_BYTES:
+            access.space = ReadCache::Space::Bytes;
+            access.end = access.begin + req[4];
+            break;
+        default:
+            return false;
+    }
+    return access.begin < access.end;
+}
+
+/* false if request is not a (known) write */
+bool toWrite(const uint8_t *req, std::size_t size, Access &access)
+{
+    if(sizeof(CRC) + 5 > size) return false;
+
+    access.slave = req[0];
+    access.begin = word(req + 2);
+
+    switch(req[1])
+    {
+        case FCODE_WR_COIL:
+            access.space = ReadCache::Space::Coils;
+            access.end = access.begin + 1;
+            break;
+        case FCODE_WR_REGISTER:
+            access.space = ReadCache::Space::Registers;
+            access.end = access.begin + 1;
+            break;
+        case FCODE_WR_REGISTERS:
+            access.space = ReadCache::Space::Registers;
+            access.end = access.begin + word(req + 4);
+            break;
+        case FCODE_WR_BYTES:
+            access.space = ReadCache::Space::Bytes;
+            access.end = access.begin + req[4];
+            break;
+        default:
+            return false;
+    }
+    return true;
+}
+
+/* reply header size (slave, fcode, ...) */
+std::size_t headerSize(ReadCache::Space space)
+{
+    /* RD_BYTES reply echoes slave, fcode, address and count */
+    return ReadCache::Space::Bytes == space ? 5 : 3;
+}
+
+std::size_t payloadSize(ReadCache::Space space, uint32_t count)
+{
+    switch(space)
+    {
+        case ReadCache::Space::Coils: return (count + 7) >> 3;
+        case ReadCache::Space::Registers: return count << 1;
+        default: break;
+    }
+    return count;
+}
+
+} /* namespace */
+
+ReadCache::ReadCache(mSecs ttl): ttl_{ttl}
+{}
+
+void ReadCache::rule(uint8_t slave, Space space, uint16_t addr, uint32_t count, mSecs ttl)
+{
+    ENSURE(0 < count, RuntimeError);
+    ENSURE(mSecs{0} <= ttl, RuntimeError);
+    rules_.push_back(Rule{slave, space, addr, addr + count, ttl});
+}
+
+ReadCache::mSecs ReadCache::ttl(uint8_t slave, Space space, uint32_t addr) const
+{
+    for(const auto &rule : rules_)
+    {
+        if(
+            (0 == rule.slave || slave == rule.slave)
+            && space == rule.space
+            && rule.begin <= addr && addr < rule.end) return rule.ttl;
+    }
+    return ttl_;
+}
+
+ReadCache::Parts ReadCache::parts(uint8_t slave, Space space, uint32_t begin, uint32_t end) const
+{
+    /* TTL changes only at rule boundaries */
+    std::vector<uint32_t> bounds{begin, end};
+
+    for(const auto &rule : rules_)
+    {
+        if(begin < rule.begin && rule.begin < end) bounds.push_back(rule.begin);
+        if(begin < rule.end && rule.end < end) bounds.push_back(rule.end);
+    }
+    std::sort(std::begin(bounds), std::end(bounds));
+    bounds.erase(std::unique(std::begin(bounds), std::end(bounds)), std::end(bounds));
+
+    Parts parts;
+
+    for(std::size_t i = 0; i + 1 < bounds.size(); ++i)
+    {
+        const auto ttl = this->ttl(slave, space, bounds[i]);
+
+        /* adjacent parts of the same TTL are stored as single range */
+        if(!parts.empty() && bounds[i] == parts.back().end && ttl == parts.back().ttl)
+        {
+            parts.back().end = bounds[i + 1];
+        }
+        else if(mSecs{0} != ttl) parts.push_back(Part{bounds[i], bounds[i + 1], ttl});
+    }
+    return parts;
+}
+
+uint64_t ReadCache::trim(Ranges &ranges, uint32_t begin, uint32_t end)
+{
+    uint64_t num = 0;
+    /* first range which may overlap: last one starting before begin */
+    auto i = ranges.upper_bound(begin);
+
+    if(std::begin(ranges) != i) --i;
+
+    while(std::end(ranges) != i && i->first < end)
+    {
+        if(i->second.end <= begin)
+        {
+            ++i;
+            continue;
+        }
+
+        const auto first = i->first;
+        auto range = std::move(i->second);
+
+        i = ranges.erase(i);
+        ++num;
+
+        /* head and tail outside of [begin, end) stay cached */
+        if(first < begin)
+        {
+            const auto head = std::next(std::begin(range.values), begin - first);
+
+            ranges.emplace(
+                first,
+                Range{begin, range.expires, std::vector<uint16_t>(std::begin(range.values), head)});
+        }
+        if(end < range.end)
+        {
+            const auto tail = std::next(std::begin(range.values), end - first);
+
+            i = ranges.emplace(
+                end,
+                Range{range.end, range.expires, std::vector<uint16_t>(tail, std::end(range.values))}).first;
+            break;
+        }
+    }
+    return num;
+}
+
+bool ReadCache::lookup(
+    const uint8_t *reqBegin, const uint8_t *const reqEnd,
+    uint8_t *repBegin, uint8_t *const repEnd,
+    Clock::time_point now)
+{
+    Access access;
+
+    if(!toRead(reqBegin, std::distance(reqBegin, reqEnd), access)) return false;
+
+    const auto count = access.end - access.begin;
+    const auto header = headerSize(access.space);
+    const auto size = header + payloadSize(access.space, count) + sizeof(CRC);
+    const auto memory = memory_.find(key(access.slave, access.space));
+
+    if(
+        std::distance(repBegin, repEnd) != std::ptrdiff_t(size)
+        || std::end(memory_) == memory)
+    {
+        ++stats_.misses;
+        return false;
+    }
+
+    auto &ranges = memory->second;
+    auto i = ranges.upper_bound(access.begin);
+
+    if(std::begin(ranges) != i) --i;
+
+    /* covered by contiguous fresh ranges */
+    for(auto addr = access.begin; addr < access.end; addr = i->second.end, ++i)
+    {
+        if(std::end(ranges) == i || addr < i->first || i->second.end <= addr)
+        {
+            ++stats_.misses;
+            return false;
+        }
+        if(now >= i->second.expires)
+        {
+            ranges.erase(i);
+            ++stats_.misses;
+            return false;
+        }
+    }
+
+    auto *const data = repBegin + header;
+
+    std::fill(repBegin, repEnd, UINT8_C(0));
+    if(ReadCache::Space::Bytes == access.space) std::copy(reqBegin, reqBegin + header, repBegin);
+    else
+    {
+        repBegin[0] = reqBegin[0];
+        repBegin[1] = reqBegin[1];
+        repBegin[2] = uint8_t(payloadSize(access.space, count));
+    }
+
+    i = ranges.upper_bound(access.begin);
+    --i;
+    for(auto addr = access.begin; addr < access.end; ++addr)
+    {
+        if(i->second.end <= addr) ++i;
+
+        const auto value = i->second.values[addr - i->first];
+        const auto n = addr - access.begin;
+
+        switch(access.space)
+        {
+            case Space::Coils:
+                /* packed, LSB first */
+                if(value) data[n >> 3] |= uint8_t(1u << (n & 0x7));
+                break;
+            case Space::Registers:
+                data[n << 1] = uint8_t(value >> 8);
+                data[(n << 1) + 1] = uint8_t(value);
+                break;
+            case Space::Bytes:
+                data[n] = uint8_t(value);
+                break;
+        }
+    }
+
+    const auto crc = calcCRC(repBegin, repEnd - sizeof(CRC));
+
+    *(repEnd - 2) = crc.lowByte();
+    *(repEnd - 1) = crc.highByte();
+    ++stats_.hits;
+    return true;
+}
+
+void ReadCache::store(
+    const uint8_t *reqBegin, const uint8_t *const reqEnd,
+    const uint8_t *repBegin, const uint8_t *const repEnd,
+    Clock::time_point timestamp)
+{
+    Access access;
+
+    if(!toRead(reqBegin, std::distance(reqBegin, reqEnd), access)) return;
+
+    const auto parts = this->parts(access.slave, access.space, access.begin, access.end);
+    const auto count = access.end - access.begin;
+    const auto header = headerSize(access.space);
+
+    if(parts.empty()) return;
+    ENSURE(
+        std::distance(repBegin, repEnd) == std::ptrdiff_t(header + payloadSize(access.space, count) + sizeof(CRC)),
+        RuntimeError);
+
+    std::vector<uint16_t> values(count, 0);
+    const auto *const data = repBegin + header;
+
+    for(uint32_t n = 0; n < count; ++n)
+    {
+        switch(access.space)
+        {
+            case Space::Coils: values[n] = (data[n >> 3] >> (n & 0x7)) & 0x1; break;
+            case Space::Registers: values[n] = word(data + (n << 1)); break;
+            case Space::Bytes: values[n] = data[n]; break;
+        }
+    }
+
+    auto &ranges = memory_[key(access.slave, access.space)];
+
+    /* newer data replaces overlapped part of older ranges (also where it is not cached) */
+    trim(ranges, access.begin, access.end);
+    for(const auto &part : parts)
+    {
+        const auto first = std::next(std::begin(values), part.begin - access.begin);
+        const auto last = std::next(std::begin(values), part.end - access.begin);
+
+        ranges.emplace(part.begin, Range{part.end, timestamp + part.ttl, std::vector<uint16_t>(first, last)});
+    }
+}
+
+void ReadCache::invalidate(const uint8_t *reqBegin, const uint8_t *const reqEnd)
+{
+    Access access;
+    const auto size = std::distance(reqBegin, reqEnd);
+
+    if(2 > size || toRead(reqBegin, size, access)) return;
+
+    if(toWrite(reqBegin, size, access))
+    {
+        if(access.begin < access.end)
+        {
+            invalidate(access.slave, access.space, access.begin, access.end - access.begin);
+        }
+        return;
+    }
+
+    /* unknown function - effect on slave memory is unknown */
+    for(auto i = std::begin(memory_); i != std::end(memory_);)
+    {
+        if(0 == reqBegin[0] || reqBegin[0] == (i->first >> 8))
+        {
+            stats_.invalidated += i->second.size();
+            i = memory_.erase(i);
+        }
+        else ++i;
+    }
+}
+
+void ReadCache::invalidate(uint8_t slave, Space space, uint16_t addr, uint32_t count)
+{
+    for(auto &memory : memory_)
+    {
+        /* broadcast (slave 0) is executed by every slave */
+        if(
+            key(slave, space) == memory.first
+            || (0 == slave && key(uint8_t(memory.first >> 8), space) == memory.first))
+        {
+            stats_.invalidated += trim(memory.second, addr, addr + count);
+        }
+    }
+}
+
+} /* RTU */
+} /* Modbus */
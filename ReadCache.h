@@ -0,0 +1,112 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <vector>
+
+#include "Transport.h"
+
+namespace Modbus {
+namespace RTU {
+
+/* Read-through cache of slave memory (see Master::cache()): successful reads
+ * (coils, registers, bytes) are stored per slave as address ranges which stay
+ * fresh for their TTL. Read request covered by fresh cached ranges (single
+ * one or contiguous sequence) is replied from cache without touching the bus,
+ * write request invalidates (trims) every cached range it overlaps - before
+ * it is transmitted, whatever its outcome.
+ *
+ * TTL of every address is given by first matching rule (slave, space, address
+ * range), default TTL otherwise - read spanning several rules is stored as
+ * several ranges. Zero TTL disables caching (of matching addresses).
+ * Cache works on complete ADUs - requests executed by Plan/Executor
+ * (bus_daemon, tcp_gateway) are served the same way as Master::rd*(). */
+class ReadCache
+{
+public:
+    using Clock = Transport::Clock;
+    using mSecs = Transport::mSecs;
+
+    enum class Space: uint8_t
+    {
+        Coils, Registers, Bytes
+    };
+
+    struct Stats
+    {
+        /* reads replied from cache */
+        uint64_t hits{0};
+        uint64_t misses{0};
+        /* cached ranges (or their parts) removed by writes */
+        uint64_t invalidated{0};
+    };
+private:
+    struct Rule
+    {
+        uint8_t slave; /* 0 - any */
+        Space space;
+        uint32_t begin;
+        uint32_t end;
+        mSecs ttl;
+    };
+
+    struct Range
+    {
+        uint32_t end;
+        Clock::time_point expires;
+        /* coil (0/1), register or byte per address */
+        std::vector<uint16_t> values;
+    };
+
+    /* non-overlapping ranges by begin address */
+    using Ranges = std::map<uint32_t, Range>;
+
+    /* part of read with single (non-zero) TTL */
+    struct Part
+    {
+        uint32_t begin;
+        uint32_t end;
+        mSecs ttl;
+    };
+
+    using Parts = std::vector<Part>;
+
+    mSecs ttl_;
+    std::vector<Rule> rules_;
+    /* by (slave, space) */
+    std::map<uint16_t, Ranges> memory_;
+    Stats stats_;
+
+    static uint16_t key(uint8_t slave, Space space) { return uint16_t((slave << 8) | uint8_t(space)); }
+    mSecs ttl(uint8_t slave, Space space, uint32_t addr) const;
+    /* [begin, end) split by TTL, parts not to be cached are left out */
+    Parts parts(uint8_t slave, Space space, uint32_t begin, uint32_t end) const;
+    /* remove [begin, end) from ranges, parts outside are kept */
+    uint64_t trim(Ranges &, uint32_t begin, uint32_t end);
+public:
+    explicit ReadCache(mSecs ttl);
+
+    /* TTL of [addr, addr + count) of slave (0 - any slave), rules are matched
+     * in order of addition */
+    void rule(uint8_t slave, Space space, uint16_t addr, uint32_t count, mSecs ttl);
+    /* reply to request ADU [reqBegin, reqEnd) is built (with CRC) into
+     * [repBegin, repEnd) if it is read covered by fresh ranges */
+    bool lookup(
+        const uint8_t *reqBegin, const uint8_t *const reqEnd,
+        uint8_t *repBegin, uint8_t *const repEnd,
+        Clock::time_point now);
+    /* data of successful read is stored (fresh since timestamp) */
+    void store(
+        const uint8_t *reqBegin, const uint8_t *const reqEnd,
+        const uint8_t *repBegin, const uint8_t *const repEnd,
+        Clock::time_point timestamp);
+    /* write request ADU: overlapped ranges are dropped (every slave if broadcast) */
+    void invalidate(const uint8_t *reqBegin, const uint8_t *const reqEnd);
+    void invalidate(uint8_t slave, Space space, uint16_t addr, uint32_t count);
+    void clear() { memory_.clear(); }
+
+    const Stats &stats() const { return stats_; }
+};
+
+} /* RTU */
+} /* Modbus */
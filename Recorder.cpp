@@ -0,0 +1,424 @@
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <map>
+
+#include "Ensure.h"
+#include "Frame.h"
+#include "Recorder.h"
+
+namespace Modbus {
+namespace RTU {
+namespace Series {
+namespace {
+
+const char MAGIC[4] = {'M', 'B', 'T', 'S'};
+constexpr const uint8_t VERSION = 1;
+/* file grows (and is mapped by writer) by segments of blocks */
+constexpr const uint32_t SEGMENT_BLOCKS = 256;
+
+uint64_t zigzag(int64_t value)
+{
+    return (uint64_t(value) << 1) ^ uint64_t(value >> 63);
+}
+
+int64_t unzigzag(uint64_t value)
+{
+    return int64_t(value >> 1) ^ -int64_t(value & 0x1);
+}
+
+void putVarint(std::vector<uint8_t> &dst, uint64_t value)
+{
+    for(; 0x7F < value; value >>= 7) dst.push_back(uint8_t(value | 0x80));
+    dst.push_back(uint8_t(value));
+}
+
+uint64_t getVarint(const uint8_t *&pos, const uint8_t *const end)
+{
+    uint64_t value = 0;
+
+    for(int shift = 0;; shift += 7)
+    {
+        ENSURE(pos != end && 64 > shift, RuntimeError);
+
+        const auto byte = *pos++;
+
+        value |= uint64_t(byte & 0x7F) << shift;
+        if(!(byte & 0x80)) return value;
+    }
+}
+
+} /* namespace */
+
+Cursor::Cursor(const uint8_t *block, uint16_t elementNum):
+    header_{*reinterpret_cast<const BlockHeader *>(block)},
+    pos_{block + sizeof(BlockHeader)},
+    end_{pos_ + std::min<std::size_t>(header_.size, BLOCK_DATA_SIZE)},
+    remaining_{header_.sampleNum},
+    timestamp_{header_.first},
+    values_(elementNum, 0)
+{}
+
+bool Cursor::next()
+{
+    if(!remaining_) return false;
+    --remaining_;
+
+    delta_ += unzigzag(getVarint(pos_, end_));
+    timestamp_ += delta_;
+
+    const auto changed = getVarint(pos_, end_);
+    int64_t index = -1;
+
+    for(uint64_t n = 0; n < changed; ++n)
+    {
+        index += int64_t(getVarint(pos_, end_)) + 1;
+        ENSURE(int64_t(values_.size()) > index, RuntimeError);
+        values_[index] = uint16_t(values_[index] + unzigzag(getVarint(pos_, end_)));
+    }
+    return true;
+}
+
+} /* Series */
+
+using namespace Series;
+
+SeriesWriter::SeriesWriter(
+    const std::string &path,
+    uint8_t slave, uint8_t fcode, uint16_t addr, uint16_t count, uint16_t elementNum):
+    path_{path},
+    state_{0, 0, std::vector<uint16_t>(elementNum, 0)}
+{
+    /* largest sample: timestamp, number of changes, every element changed */
+    ENSURE(0 < elementNum && std::size_t(2 * 10 + elementNum * (3 + 3)) <= BLOCK_DATA_SIZE, RuntimeError);
+
+    fd_ = ::open(path_.c_str(), O_RDWR | O_CREAT, 0644);
+    ENSURE(-1 != fd_, CRuntimeError);
+
+    struct stat st;
+
+    ENSURE(0 == ::fstat(fd_, &st), CRuntimeError);
+
+    const auto created = 0 == st.st_size;
+
+    if(created) ENSURE(0 == ::ftruncate(fd_, BLOCK_SIZE), CRuntimeError);
+    else ENSURE(BLOCK_SIZE <= st.st_size, RuntimeError);
+
+    auto *const header = ::mmap(nullptr, BLOCK_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+
+    ENSURE(MAP_FAILED != header, CRuntimeError);
+    header_ = static_cast<Header *>(header);
+
+    if(created)
+    {
+        std::memcpy(header_->magic, MAGIC, sizeof(MAGIC));
+        header_->version = VERSION;
+        header_->slave = slave;
+        header_->fcode = fcode;
+        header_->addr = addr;
+        header_->count = count;
+        header_->elementNum = elementNum;
+        header_->blockNum = 0;
+        return;
+    }
+
+    /* appending to series of different request would corrupt it */
+    ENSURE(
+        0 == std::memcmp(header_->magic, MAGIC, sizeof(MAGIC))
+        && VERSION == header_->version
+        && slave == header_->slave
+        && fcode == header_->fcode
+        && addr == header_->addr
+        && count == header_->count
+        && elementNum == header_->elementNum,
+        RuntimeError);
+
+    if(!header_->blockNum) return;
+
+    /* continue encoding of last block */
+    for(Cursor cursor{block(header_->blockNum - 1), elementNum}; cursor.next();)
+    {
+        state_.timestamp = cursor.timestamp();
+        state_.delta = cursor.delta();
+        state_.values = cursor.values();
+    }
+}
+
+SeriesWriter::~SeriesWriter()
+{
+    if(segment_) (void)::munmap(segment_, SEGMENT_BLOCKS * BLOCK_SIZE);
+    if(header_) (void)::munmap(header_, BLOCK_SIZE);
+    if(-1 != fd_) (void)::close(fd_);
+}
+
+uint8_t *SeriesWriter::block(uint32_t i)
+{
+    const auto segmentIndex = i / SEGMENT_BLOCKS;
+
+    if(!segment_ || segmentIndex != segmentIndex_)
+    {
+        const auto offset = off_t(BLOCK_SIZE) * (1 + off_t(segmentIndex) * SEGMENT_BLOCKS);
+        const auto size = off_t(SEGMENT_BLOCKS) * BLOCK_SIZE;
+        struct stat st;
+
+        if(segment_) (void)::munmap(segment_, size);
+        segment_ = nullptr;
+
+        /* new segment is zero filled (empty blocks) */
+        ENSURE(0 == ::fstat(fd_, &st), CRuntimeError);
+        if(offset + size > st.st_size) ENSURE(0 == ::ftruncate(fd_, offset + size), CRuntimeError);
+
+        auto *const segment = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, offset);
+
+        ENSURE(MAP_FAILED != segment, CRuntimeError);
+        segment_ = static_cast<uint8_t *>(segment);
+        segmentIndex_ = segmentIndex;
+    }
+    return segment_ + (i % SEGMENT_BLOCKS) * BLOCK_SIZE;
+}
+
+void SeriesWriter::encode(const State &state, int64_t timestamp, const uint16_t *values)
+{
+    const auto delta = timestamp - state.timestamp;
+    const auto elementNum = state.values.size();
+    uint64_t changed = 0;
+
+    sample_.clear();
+    putVarint(sample_, zigzag(delta - state.delta));
+
+    for(std::size_t k = 0; k < elementNum; ++k) changed += values[k] != state.values[k];
+    putVarint(sample_, changed);
+
+    int64_t index = -1;
+
+    for(std::size_t k = 0; k < elementNum && changed; ++k)
+    {
+        if(values[k] == state.values[k]) continue;
+
+        putVarint(sample_, uint64_t(int64_t(k) - index - 1));
+        putVarint(sample_, zigzag(int64_t(values[k]) - int64_t(state.values[k])));
+        index = int64_t(k);
+    }
+}
+
+void SeriesWriter::append(int64_t timestamp, const uint16_t *values)
+{
+    auto *current = header_->blockNum ? block(header_->blockNum - 1) : nullptr;
+    auto *blockHeader = reinterpret_cast<BlockHeader *>(current);
+
+    /* index (binary search) requires ordered timestamps */
+    timestamp = std::max(timestamp, state_.timestamp);
+
+    if(blockHeader && blockHeader->sampleNum)
+    {
+        encode(state_, timestamp, values);
+        if(blockHeader->size + sample_.size() > BLOCK_DATA_SIZE) blockHeader = nullptr;
+    }
+
+    if(!blockHeader)
+    {
+        current = block(header_->blockNum);
+        blockHeader = reinterpret_cast<BlockHeader *>(current);
+        std::memset(current, 0, BLOCK_SIZE);
+        ++header_->blockNum;
+    }
+
+    if(!blockHeader->sampleNum)
+    {
+        /* self-contained block: first sample is delta against 0 values */
+        std::fill(std::begin(state_.values), std::end(state_.values), 0);
+        state_.timestamp = timestamp;
+        state_.delta = 0;
+        blockHeader->first = timestamp;
+        encode(state_, timestamp, values);
+    }
+
+    std::memcpy(current + sizeof(BlockHeader) + blockHeader->size, sample_.data(), sample_.size());
+    state_.delta = timestamp - state_.timestamp;
+    state_.timestamp = timestamp;
+    std::copy(values, values + state_.values.size(), std::begin(state_.values));
+    /* sample is complete before it is accounted */
+    blockHeader->size += uint32_t(sample_.size());
+    blockHeader->last = timestamp;
+    ++blockHeader->sampleNum;
+}
+
+SeriesReader::SeriesReader(const std::string &path)
+{
+    const auto fd = ::open(path.c_str(), O_RDONLY);
+
+    ENSURE(-1 != fd, CRuntimeError);
+
+    struct stat st;
+    const auto statOk = 0 == ::fstat(fd, &st);
+
+    if(statOk && BLOCK_SIZE <= st.st_size)
+    {
+        size_ = std::size_t(st.st_size);
+
+        auto *const base = ::mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd, 0);
+
+        if(MAP_FAILED != base) base_ = static_cast<const uint8_t *>(base);
+    }
+    (void)::close(fd);
+    ENSURE(base_, RuntimeError);
+
+    const auto &header = *reinterpret_cast<const Header *>(base_);
+
+    ENSURE(
+        0 == std::memcmp(header.magic, MAGIC, sizeof(MAGIC))
+        && VERSION == header.version
+        && (1 + std::size_t(header.blockNum)) * BLOCK_SIZE <= size_,
+        RuntimeError);
+}
+
+SeriesReader::~SeriesReader()
+{
+    if(base_) (void)::munmap(const_cast<uint8_t *>(base_), size_);
+}
+
+const BlockHeader &SeriesReader::blockHeader(uint32_t i) const
+{
+    return *reinterpret_cast<const BlockHeader *>(base_ + (1 + std::size_t(i)) * BLOCK_SIZE);
+}
+
+SeriesReader::Info SeriesReader::info() const
+{
+    const auto &header = *reinterpret_cast<const Header *>(base_);
+    Info info{
+        header.slave, header.fcode, header.addr, header.count, header.elementNum,
+        header.blockNum, 0, sizeof(Header), 0, 0};
+
+    for(uint32_t i = 0; i < header.blockNum; ++i)
+    {
+        const auto &block = blockHeader(i);
+
+        if(!block.sampleNum) continue;
+        if(!info.sampleNum) info.first = block.first;
+        info.last = block.last;
+        info.sampleNum += block.sampleNum;
+        info.dataSize += sizeof(BlockHeader) + block.size;
+    }
+    return info;
+}
+
+void SeriesReader::blocks(int64_t from, int64_t to, uint32_t &begin, uint32_t &end) const
+{
+    const auto blockNum = reinterpret_cast<const Header *>(base_)->blockNum;
+    uint32_t first = 0, count = blockNum;
+
+    /* first block ending at or after from */
+    while(count)
+    {
+        const auto step = count / 2;
+
+        if(blockHeader(first + step).last < from)
+        {
+            first += step + 1;
+            count -= step + 1;
+        }
+        else count = step;
+    }
+    begin = first;
+
+    /* first block starting after to */
+    for(count = blockNum - first; count;)
+    {
+        const auto step = count / 2;
+
+        if(blockHeader(first + step).first <= to)
+        {
+            first += step + 1;
+            count -= step + 1;
+        }
+        else count = step;
+    }
+    end = first;
+}
+
+Cursor SeriesReader::cursor(uint32_t i) const
+{
+    const auto &header = *reinterpret_cast<const Header *>(base_);
+
+    ENSURE(header.blockNum > i, RuntimeError);
+    return Cursor{base_ + (1 + std::size_t(i)) * BLOCK_SIZE, header.elementNum};
+}
+
+Recorder::Recorder(const std::string &dir, const Plan &plan):
+    plan_{plan},
+    writers_(plan.size())
+{
+    ENSURE(0 == ::mkdir(dir.c_str(), 0755) || EEXIST == errno, CRuntimeError);
+
+    std::map<std::string, std::shared_ptr<SeriesWriter>> files;
+
+    for(std::size_t i = 0; i < plan.size(); ++i)
+    {
+        const auto &req = plan[i];
+        uint16_t elementNum = 0;
+
+        switch(req.fcode)
+        {
+            case FCODE_RD_COILS: elementNum = uint16_t((req.count + 7) >> 3); break;
+            case FCODE_RD_HOLDING_REGISTERS:
+            case FCODE_RD_BYTES: elementNum = req.count; break;
+            default: continue;
+        }
+
+        const auto path = dir + '/' + name(req.slave, req.fcode, req.addr, req.count);
+        auto &writer = files[path];
+
+        if(!writer)
+        {
+            writer = std::make_shared<SeriesWriter>(path, req.slave, req.fcode, req.addr, req.count, elementNum);
+        }
+        writers_[i] = writer;
+        values_.resize(std::max<std::size_t>(values_.size(), elementNum));
+    }
+}
+
+std::string Recorder::name(uint8_t slave, uint8_t fcode, uint16_t addr, uint16_t count)
+{
+    return
+        std::to_string(slave) + '-' + std::to_string(fcode) + '-'
+        + std::to_string(addr) + '-' + std::to_string(count) + ".series";
+}
+
+int64_t Recorder::now()
+{
+    using namespace std::chrono;
+
+    return duration_cast<milliseconds>(system_clock::now().time_since_epoch()).count();
+}
+
+void Recorder::record(const Executor &executor, std::size_t i, Status status, int64_t timestamp)
+{
+    ENSURE(writers_.size() > i, RuntimeError);
+
+    /* failed poll leaves gap in series */
+    if(!writers_[i] || Status::Ok != status) return;
+
+    const auto &req = plan_[i];
+    const auto *data = executor.dataBegin(i);
+    const auto size = std::size_t(executor.dataEnd(i) - data);
+
+    if(FCODE_RD_HOLDING_REGISTERS == req.fcode)
+    {
+        for(std::size_t n = 0; n < size / 2; ++n, data += 2)
+        {
+            values_[n] = uint16_t((uint16_t(data[0]) << 8) | data[1]);
+        }
+    }
+    else std::copy(data, data + size, std::begin(values_));
+
+    writers_[i]->append(timestamp, values_.data());
+}
+
+} /* RTU */
+} /* Modbus */
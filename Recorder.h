@@ -0,0 +1,187 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Plan.h"
+#include "Status.h"
+
+namespace Modbus {
+namespace RTU {
+
+/* Time series of single read request (slave, fcode, addr, count) stored in
+ * append-only file of fixed size blocks (first block is file header).
+ * Sample is timestamp (ms since epoch) and values of all elements (register,
+ * byte of packed coils or byte - same as result "value" array).
+ *
+ * Every block is self-contained (decoding starts at its beginning):
+ * - block header: timestamps of first and last sample, number of samples and
+ *   used size - together they form the index for time range lookup (binary
+ *   search, see SeriesReader::forEach())
+ * - timestamp: zigzag varint of delta-of-delta (fixed poll rate - 1 byte)
+ * - values: varint number of changed elements followed by (varint gap of
+ *   element index, zigzag varint of value delta) of every changed element,
+ *   every element of first sample of block is delta against 0
+ * Unchanged sample takes 2 bytes. File grows by segments of blocks which are
+ * memory mapped - appending sample is a copy to mapped memory. */
+namespace Series {
+
+constexpr const uint32_t BLOCK_SIZE = 4096;
+
+struct Header
+{
+    char magic[4];
+    uint8_t version;
+    uint8_t slave;
+    uint8_t fcode;
+    uint8_t reserved;
+    uint16_t addr;
+    uint16_t count;
+    uint16_t elementNum;
+    uint16_t reserved2;
+    /* blocks in use (excluding header) */
+    uint32_t blockNum;
+};
+
+struct BlockHeader
+{
+    int64_t first;
+    int64_t last;
+    uint32_t sampleNum;
+    /* of samples (excluding BlockHeader) */
+    uint32_t size;
+};
+
+constexpr const std::size_t BLOCK_DATA_SIZE = BLOCK_SIZE - sizeof(BlockHeader);
+
+/* sequential decoding of samples of single block */
+class Cursor
+{
+    const BlockHeader &header_;
+    const uint8_t *pos_;
+    const uint8_t *end_;
+    uint32_t remaining_;
+    int64_t timestamp_;
+    int64_t delta_{0};
+    std::vector<uint16_t> values_;
+public:
+    Cursor(const uint8_t *block, uint16_t elementNum);
+
+    /* false if there are no more samples */
+    bool next();
+    int64_t timestamp() const { return timestamp_; }
+    /* delta between last two samples */
+    int64_t delta() const { return delta_; }
+    const std::vector<uint16_t> &values() const { return values_; }
+};
+
+} /* Series */
+
+class SeriesWriter
+{
+    struct State
+    {
+        int64_t timestamp;
+        int64_t delta;
+        std::vector<uint16_t> values;
+    };
+
+    std::string path_;
+    int fd_{-1};
+    Series::Header *header_{nullptr};
+    uint8_t *segment_{nullptr};
+    uint32_t segmentIndex_{0};
+    State state_;
+    std::vector<uint8_t> sample_;
+
+    uint8_t *block(uint32_t i);
+    void encode(const State &, int64_t timestamp, const uint16_t *values);
+public:
+    /* existing file (of the same request) is appended to */
+    SeriesWriter(
+        const std::string &path,
+        uint8_t slave, uint8_t fcode, uint16_t addr, uint16_t count, uint16_t elementNum);
+    ~SeriesWriter();
+
+    SeriesWriter(const SeriesWriter &) = delete;
+    SeriesWriter &operator=(const SeriesWriter &) = delete;
+
+    /* values - elementNum values, timestamp going back is clamped */
+    void append(int64_t timestamp, const uint16_t *values);
+};
+
+class SeriesReader
+{
+    const uint8_t *base_{nullptr};
+    std::size_t size_{0};
+
+    const Series::BlockHeader &blockHeader(uint32_t i) const;
+public:
+    struct Info
+    {
+        uint8_t slave;
+        uint8_t fcode;
+        uint16_t addr;
+        uint16_t count;
+        uint16_t elementNum;
+        uint32_t blockNum;
+        uint64_t sampleNum;
+        /* encoded samples including file and block headers */
+        uint64_t dataSize;
+        int64_t first;
+        int64_t last;
+    };
+
+    explicit SeriesReader(const std::string &path);
+    ~SeriesReader();
+
+    SeriesReader(const SeriesReader &) = delete;
+    SeriesReader &operator=(const SeriesReader &) = delete;
+
+    Info info() const;
+    /* blocks [begin, end) which may contain samples of [from, to] */
+    void blocks(int64_t from, int64_t to, uint32_t &begin, uint32_t &end) const;
+    Series::Cursor cursor(uint32_t i) const;
+    /* f(int64_t timestamp, const std::vector<uint16_t> &values)
+     * for every sample in [from, to] */
+    template <typename F>
+    void forEach(int64_t from, int64_t to, F f) const
+    {
+        uint32_t begin, end;
+
+        blocks(from, to, begin, end);
+        for(auto i = begin; i < end; ++i)
+        {
+            for(auto cursor = this->cursor(i); cursor.next();)
+            {
+                if(to < cursor.timestamp()) return;
+                if(from <= cursor.timestamp()) f(cursor.timestamp(), cursor.values());
+            }
+        }
+    }
+};
+
+/* Recorder stage of poller: every successful read of Plan is appended to its
+ * own series file in directory (see name()) */
+class Recorder
+{
+    const Plan &plan_;
+    /* by plan request (nullptr for writes), identical reads share file */
+    std::vector<std::shared_ptr<SeriesWriter>> writers_;
+    std::vector<uint16_t> values_;
+public:
+    Recorder(const std::string &dir, const Plan &plan);
+
+    /* slave-fcode-addr-count.series */
+    static std::string name(uint8_t slave, uint8_t fcode, uint16_t addr, uint16_t count);
+    /* system clock, ms since epoch */
+    static int64_t now();
+
+    void record(const Executor &, std::size_t i, Status status, int64_t timestamp);
+};
+
+} /* RTU */
+} /* Modbus */
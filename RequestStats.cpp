@@ -0,0 +1,89 @@
+#include "Frame.h"
+#include "RequestStats.h"
+#include "Trace.h"
+
+namespace Modbus {
+namespace RTU {
+
+uint64_t RequestStats::errors() const
+{
+    uint64_t num = 0;
+
+    for(std::size_t i = 1; i < statuses.size(); ++i) num += statuses[i];
+    return num;
+}
+
+void RequestStats::merge(const RequestStats &other)
+{
+    latency.merge(other.latency);
+    queue.merge(other.queue);
+    response.merge(other.response);
+    for(std::size_t i = 0; i < statuses.size(); ++i) statuses[i] += other.statuses[i];
+    retries += other.retries;
+    payload += other.payload;
+}
+
+std::size_t payloadSize(const Plan::Request &req)
+{
+    switch(req.fcode)
+    {
+        case FCODE_RD_COILS:
+        case FCODE_RD_HOLDING_REGISTERS:
+        case FCODE_RD_BYTES:
+            return req.repSize - req.dataOffset - sizeof(CRC);
+        case FCODE_WR_COIL:
+        case FCODE_WR_REGISTER:
+            return 2;
+        case FCODE_WR_REGISTERS:
+            return req.count << 1;
+        case FCODE_WR_BYTES:
+            return req.count;
+    }
+    return 0;
+}
+
+void exec(
+    Master &master, Executor &executor, std::size_t i,
+    Transport::Clock::time_point intended,
+    RequestStats &stats)
+{
+    using namespace std::chrono;
+
+    const auto &req = executor.plan()[i];
+
+    /* empty write - nothing to execute */
+    if(!req.aduSize) return;
+
+    auto &clock = master.transport();
+
+    stats.queue.record(duration_cast<uSecs>(clock.now() - intended));
+
+    for(auto retryNum = req.retryNum;;)
+    {
+        const auto status = executor.attempt(i);
+
+        ++stats.statuses[std::size_t(status)];
+        if(Status::Ok == status)
+        {
+            stats.latency.record(master.timing().total());
+            stats.response.record(duration_cast<uSecs>(clock.now() - intended));
+            stats.payload += payloadSize(req);
+            return;
+        }
+
+        --retryNum;
+        TRACE(
+            TraceLevel::Warning,
+            " failed (", toString(status), "),"
+            " retryNum ", retryNum,
+            " addr ", int(req.slave),
+            " fcode ", int(req.fcode));
+
+        if(!retryNum) ensureOk(status);
+        ++stats.retries;
+        clock.sleepFor(duration_cast<uSecs>(req.timeout));
+    }
+}
+
+} /* RTU */
+} /* Modbus */
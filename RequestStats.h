@@ -0,0 +1,47 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include "Plan.h"
+#include "Status.h"
+#include "Timing.h"
+#include "Transport.h"
+
+namespace Modbus {
+namespace RTU {
+
+/* stats of single request of Plan (e.g. bw_test input script) */
+struct RequestStats
+{
+    /* service time of successful attempts */
+    Histogram latency;
+    /* intended start to actual start */
+    Histogram queue;
+    /* intended start to completion (queueing + retries + service) */
+    Histogram response;
+    /* status of every attempt */
+    std::array<uint64_t, STATUS_NUM> statuses{};
+    uint64_t retries{0};
+    /* data bytes (excluding ADU overhead) of successful transactions */
+    uint64_t payload{0};
+
+    uint64_t errors() const;
+    void merge(const RequestStats &other);
+};
+
+/* data carried by request (writes) or reply (reads) */
+std::size_t payloadSize(const Plan::Request &req);
+
+/* execute i-th request (with retries), every attempt is accounted,
+ * response time and queueing delay are measured on transport clock from
+ * intended start (so late requests are not omitted from latency).
+ * Failure of last attempt is reported with same exceptions as Master. */
+void exec(
+    Master &master, Executor &executor, std::size_t i,
+    Transport::Clock::time_point intended,
+    RequestStats &stats);
+
+} /* RTU */
+} /* Modbus */
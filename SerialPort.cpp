@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <cassert>
 #include <cstring>
 #include <iomanip>
@@ -10,6 +11,7 @@
 #include "Ensure.h"
 #include "SerialPort.h"
 #include "Trace.h"
+#include "TraceLevel.h"
 
 
 namespace {
@@ -60,7 +62,7 @@ void debug(
     const uint8_t *begin, const uint8_t *const end,
     const uint8_t *const curr)
 {
-    if(!dst) return;
+    if(!dst || !debugActive()) return;
 
     using namespace std::chrono;
 
@@ -119,7 +121,8 @@ SerialPort::~SerialPort()
 
     if(fdGuard_)
     {
-        flush();
+        /* destructor must not throw - other side may be gone (pty) */
+        (void)::tcflush(fdGuard_.fd(), TCIOFLUSH);
         (void)::tcsetattr(fdGuard_.fd(), TCSANOW, &settingsBackup_);
     }
 }
@@ -225,6 +228,8 @@ uint8_t *SerialPort::read(uint8_t *begin, const uint8_t *const end, mSecs timeou
     mSecs elapsed{0};
     auto curr = begin;
 
+    firstRxTimestamp_ = Clock::time_point{};
+
     while(curr != end && timeout >= elapsed)
     {
         auto r = ::poll(&events, 1, (timeout - elapsed).count());
@@ -238,6 +243,11 @@ uint8_t *SerialPort::read(uint8_t *begin, const uint8_t *const end, mSecs timeou
 
         validateSysCallResult(r);
         ENSURE(0 != r, RuntimeError);
+        const auto now = Clock::now();
+
+        if(begin == curr) firstRxTimestamp_ = now;
+        if(lastTxTimestamp_ > lastRxTimestamp_ || now - lastRxTimestamp_ >= silentInterval()) ++rxFrameCntr_;
+        lastRxTimestamp_ = now;
         std::advance(curr, r);
         rxCntr_ += r;
         rxTotalCntr_ += r;
@@ -281,6 +291,8 @@ const uint8_t *SerialPort::write(const uint8_t *begin, const uint8_t *const end,
 
         validateSysCallResult(r);
         ENSURE(0 != r, RuntimeError);
+        if(begin == curr) ++txFrameCntr_;
+        lastTxTimestamp_ = Clock::now();
         std::advance(curr, r);
         txCntr_ += r;
         txTotalCntr_ += r;
@@ -316,6 +328,79 @@ void SerialPort::txFlush(int fd)
     ENSURE(-1 != ::tcflush(fd, TCOFLUSH), CRuntimeError);
 }
 
+unsigned SerialPort::toBitRate(BaudRate baudRate)
+{
+    switch(baudRate)
+    {
+        case BaudRate::BR_1200: return 1200;
+        case BaudRate::BR_2400: return 2400;
+        case BaudRate::BR_4800: return 4800;
+        case BaudRate::BR_9600: return 9600;
+        case BaudRate::BR_19200: return 19200;
+        case BaudRate::BR_38400: return 38400;
+        case BaudRate::BR_57600: return 57600;
+        case BaudRate::BR_115200: return 115200;
+    }
+    ENSURE(false && "unsupported baud rate", RuntimeError);
+    return 0;
+}
+
+unsigned SerialPort::bitsPerChar(Parity parity, DataBits dataBits, StopBits stopBits)
+{
+    return
+        1 /* start */
+        + unsigned(dataBits)
+        + (Parity::None == parity ? 0 : 1)
+        + unsigned(stopBits);
+}
+
+SerialPort::uSecs SerialPort::wireTime(uint64_t charNum, unsigned bitsPerChar, unsigned bitRate)
+{
+    return uSecs(charNum * bitsPerChar * 1000000 / bitRate);
+}
+
+SerialPort::uSecs SerialPort::silentInterval(unsigned bitsPerChar, unsigned bitRate)
+{
+    if(19200 < bitRate) return uSecs{1750};
+    /* 3.5t = 7 * t / 2 */
+    return uSecs(uint64_t(7) * bitsPerChar * 1000000 / (2 * bitRate));
+}
+
+SerialPort::Occupancy SerialPort::occupancy(Clock::duration window) const
+{
+    using namespace std::chrono;
+
+    Occupancy result
+    {
+        window,
+        wireTime(txCntr_),
+        wireTime(rxCntr_),
+        silentInterval() * (rxFrameCntr_ + txFrameCntr_),
+        uSecs{0}
+    };
+
+    result.idle = std::max(uSecs{0}, duration_cast<uSecs>(window) - (result.tx + result.rx + result.gap));
+    return result;
+}
+
+double SerialPort::Occupancy::utilization() const
+{
+    using namespace std::chrono;
+
+    const auto w = duration_cast<uSecs>(window).count();
+
+    return w ? 100.0 * double((tx + rx).count()) / double(w) : 0.0;
+}
+
+double SerialPort::Occupancy::saturation() const
+{
+    using namespace std::chrono;
+
+    const auto w = duration_cast<uSecs>(window).count();
+
+    return w ? 100.0 * double((tx + rx + gap).count()) / double(w) : 0.0;
+}
+
 SerialPort::BaudRate toBaudRate(const std::string &rate)
 {
     using BaudRate = SerialPort::BaudRate;
@@ -327,7 +412,7 @@ SerialPort::BaudRate toBaudRate(const std::string &rate)
     else if("19200" == rate) return BaudRate::BR_19200;
     else if("38400" == rate) return BaudRate::BR_38400;
     else if("57600" == rate) return BaudRate::BR_57600;
-    else if("11520" == rate) return BaudRate::BR_115200;
+    else if("115200" == rate) return BaudRate::BR_115200;
 
     TRACE(TraceLevel::Warning, "unsupported rate, ", rate);
 
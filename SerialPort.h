@@ -7,9 +7,9 @@
 #include <termios.h>
 
 #include "FdGuard.h"
+#include "Transport.h"
 
-
-struct SerialPort
+struct SerialPort: public Transport
 {
     enum class BaudRate: speed_t
     {
@@ -27,10 +27,26 @@ struct SerialPort
     enum class DataBits {Five = 5, Six = 6, Seven = 7, Eight = 8};
     enum class StopBits {One = 1, Two = 2};
 
-    using uSecs = std::chrono::microseconds;
-    using mSecs = std::chrono::milliseconds;
-    using Clock = std::chrono::steady_clock;
     using Settings = struct termios;
+
+    /* how bus time (window) was spent, based on characters transmitted/received
+     * and actual character format (start + data + parity + stop bits) */
+    struct Occupancy
+    {
+        Clock::duration window;
+        /* wire time of transmitted/received characters */
+        uSecs tx;
+        uSecs rx;
+        /* mandatory silent interval (3.5t) before every frame */
+        uSecs gap;
+        /* remaining time - bus not used at all */
+        uSecs idle;
+
+        /* share of window when characters are on the wire, in percent */
+        double utilization() const;
+        /* wire + mandatory gaps, in percent - 100% is line saturation */
+        double saturation() const;
+    };
 private:
     std::ostream *debugTo_;
     BaudRate baudRate_;
@@ -40,10 +56,15 @@ private:
     FdGuard fdGuard_;
     Settings settingsBackup_;
     Clock::time_point lastTimestamp_;
+    Clock::time_point firstRxTimestamp_;
     uint64_t rxCntr_{0};
     uint64_t txCntr_{0};
     uint64_t rxTotalCntr_{0};
     uint64_t txTotalCntr_{0};
+    uint64_t rxFrameCntr_{0};
+    uint64_t txFrameCntr_{0};
+    Clock::time_point lastRxTimestamp_;
+    Clock::time_point lastTxTimestamp_;
 public:
     explicit SerialPort(
         FdGuard,
@@ -55,7 +76,7 @@ public:
         std::ostream *);
 
     SerialPort(const SerialPort &) = delete;
-    ~SerialPort();
+    ~SerialPort() override;
 
     SerialPort &operator=(const SerialPort &) = delete;
 
@@ -63,11 +84,13 @@ public:
     static void modifySettings(Settings &, BaudRate, Parity, DataBits, StopBits);
     static void setSettings(int fd, const Settings &);
 
+    /* for event loops (poll), see monitor sniffer mode */
+    int fd() const { return fdGuard_.fd(); }
     void getSettings(Settings &settings) const { getSettings(settings, fdGuard_.fd()); }
     void setSettings(const Settings &settings) { setSettings(fdGuard_.fd(), settings); }
 
-    uint8_t *read(uint8_t *begin, const uint8_t *const end, mSecs timeout);
-    const uint8_t *write(const uint8_t *begin, const uint8_t *const end, mSecs timeout);
+    uint8_t *read(uint8_t *begin, const uint8_t *const end, mSecs timeout) override;
+    const uint8_t *write(const uint8_t *begin, const uint8_t *const end, mSecs timeout) override;
 
     /* wait until data written is transmitted */
     static void drain(int fd);
@@ -75,21 +98,47 @@ public:
     static void rxFlush(int fd);
     static void txFlush(int fd);
 
-    void drain() { drain(fdGuard_.fd()); }
-    void flush() { flush(fdGuard_.fd()); }
+    void drain() override { drain(fdGuard_.fd()); }
+    void flush() override { flush(fdGuard_.fd()); }
     void rxFlush() { txFlush(fdGuard_.fd()); }
     void txFlush() { txFlush(fdGuard_.fd()); }
 
+    void debugTo(std::ostream *dst) override { debugTo_ = dst; }
+
     uint64_t rxCntr() const {return rxCntr_;}
     uint64_t txCntr() const {return txCntr_;}
 
+    /* frames: every write() is a frame, received data is a new frame
+     * if it follows transmission or silent interval */
+    uint64_t rxFrameCntr() const {return rxFrameCntr_;}
+    uint64_t txFrameCntr() const {return txFrameCntr_;}
+
     void clearCntrs()
     {
         rxCntr_ = 0;
         txCntr_ = 0;
+        rxFrameCntr_ = 0;
+        txFrameCntr_ = 0;
     }
 
     uint64_t rxTotalCntr() const {return rxTotalCntr_;}
+
+    /* character format: start + data + parity + stop bits */
+    unsigned bitsPerChar() const { return bitsPerChar(parity_, dataBits_, stopBits_); }
+    static unsigned bitsPerChar(Parity, DataBits, StopBits);
+    unsigned bitRate() const { return toBitRate(baudRate_); }
+    /* wire time of charNum characters */
+    uSecs wireTime(uint64_t charNum) const { return wireTime(charNum, bitsPerChar(), bitRate()); }
+    static uSecs wireTime(uint64_t charNum, unsigned bitsPerChar, unsigned bitRate);
+    /* 3.5t, fixed 1750us above 19200bps (MODBUS over serial line V1.02) */
+    uSecs silentInterval() const { return silentInterval(bitsPerChar(), bitRate()); }
+    static uSecs silentInterval(unsigned bitsPerChar, unsigned bitRate);
+    /* occupancy of window based on counters (since clearCntrs()) */
+    Occupancy occupancy(Clock::duration window) const;
+
+    static unsigned toBitRate(BaudRate);
+
+    Clock::time_point firstRxTimestamp() const override { return firstRxTimestamp_; }
     uint64_t txTotalCntr() const {return txTotalCntr_;}
 };
 
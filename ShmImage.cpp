@@ -0,0 +1,283 @@
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <new>
+
+#include "Ensure.h"
+#include "FdGuard.h"
+#include "Frame.h"
+#include "ShmImage.h"
+
+namespace Modbus {
+namespace RTU {
+namespace {
+
+constexpr const std::size_t ALIGNMENT = 64;
+
+std::size_t align(std::size_t size)
+{
+    return (size + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+}
+
+/* decoded size of request data */
+std::size_t dataSize(const Plan::Request &req)
+{
+    return FCODE_RD_HOLDING_REGISTERS == req.fcode ? req.count * sizeof(uint16_t) : req.count;
+}
+
+uint8_t *map(int fd, std::size_t size, bool writable)
+{
+    auto *const base = ::mmap(
+        nullptr, size, writable ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, fd, 0);
+
+    ENSURE(MAP_FAILED != base, CRuntimeError);
+    return static_cast<uint8_t *>(base);
+}
+
+} /* namespace */
+
+ShmImage::ShmImage(const std::string &name, const Plan &plan):
+    name_{name},
+    writer_{true},
+    blockOf_(plan.size(), npos)
+{
+    std::size_t blockNum = 0;
+
+    for(std::size_t i = 0; i < plan.size(); ++i)
+    {
+        if(isRead(plan[i].fcode)) blockOf_[i] = blockNum++;
+    }
+
+    std::size_t offset = align(sizeof(Header) + blockNum * sizeof(Block));
+
+    size_ = offset;
+    for(std::size_t i = 0; i < plan.size(); ++i)
+    {
+        if(npos != blockOf_[i]) size_ += align(dataSize(plan[i]));
+    }
+    ENSURE(UINT32_MAX > size_, RuntimeError);
+
+    /* new segment - readers of previous one are not affected by new layout */
+    remove(name_);
+
+    FdGuard fdGuard{::shm_open(name_.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644)};
+
+    ENSURE(fdGuard, CRuntimeError);
+    ENSURE(0 == ::ftruncate(fdGuard.fd(), off_t(size_)), CRuntimeError);
+    base_ = map(fdGuard.fd(), size_, true);
+
+    /* segment is zero filled: Quality::None, Status::Ok */
+    auto *const header = new (base_) Header;
+
+    header->version = VERSION;
+    header->blockNum = uint32_t(blockNum);
+    header->size = uint32_t(size_);
+    header->heartbeat.store(0, std::memory_order_relaxed);
+    header->cycles.store(0, std::memory_order_relaxed);
+
+    for(std::size_t i = 0; i < plan.size(); ++i)
+    {
+        if(npos == blockOf_[i]) continue;
+
+        const auto &req = plan[i];
+        auto *const block = new (&blockAt(blockOf_[i])) Block;
+
+        block->seq.store(0, std::memory_order_relaxed);
+        block->offset = uint32_t(offset);
+        block->size = uint32_t(dataSize(req));
+        block->addr = req.addr;
+        block->count = req.count;
+        block->slave = req.slave;
+        block->fcode = req.fcode;
+        offset += align(block->size);
+    }
+
+    /* readers check magic - layout is complete */
+    std::atomic_thread_fence(std::memory_order_release);
+    header->magic = MAGIC;
+}
+
+ShmImage::ShmImage(const std::string &name):
+    name_{name},
+    writer_{false}
+{
+    FdGuard fdGuard{::shm_open(name_.c_str(), O_RDONLY, 0)};
+    struct stat st;
+
+    ENSURE(fdGuard, CRuntimeError);
+    ENSURE(0 == ::fstat(fdGuard.fd(), &st), CRuntimeError);
+    ENSURE(sizeof(Header) <= std::size_t(st.st_size), RuntimeError);
+    size_ = std::size_t(st.st_size);
+    base_ = map(fdGuard.fd(), size_, false);
+
+    const auto &header = this->header();
+
+    if(MAGIC != header.magic || VERSION != header.version || size_ != header.size)
+    {
+        (void)::munmap(base_, size_);
+        ENSURE(false && "invalid shared memory image", RuntimeError);
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+}
+
+ShmImage::~ShmImage()
+{
+    if(base_) (void)::munmap(base_, size_);
+}
+
+bool ShmImage::isRead(uint8_t fcode)
+{
+    return
+        FCODE_RD_COILS == fcode
+        || FCODE_RD_HOLDING_REGISTERS == fcode
+        || FCODE_RD_BYTES == fcode;
+}
+
+uint64_t ShmImage::now()
+{
+    using namespace std::chrono;
+
+    return uint64_t(duration_cast<nanoseconds>(system_clock::now().time_since_epoch()).count());
+}
+
+void ShmImage::remove(const std::string &name)
+{
+    ENSURE(0 == ::shm_unlink(name.c_str()) || ENOENT == errno, CRuntimeError);
+}
+
+void ShmImage::publish(const Executor &executor, std::size_t i, Status status)
+{
+    ENSURE(writer_, RuntimeError);
+    ENSURE(blockOf_.size() > i, RuntimeError);
+
+    if(npos == blockOf_[i]) return;
+
+    auto &block = blockAt(blockOf_[i]);
+    auto &state = block.state;
+    const auto timestamp = now();
+    const auto seq = block.seq.load(std::memory_order_relaxed);
+
+    block.seq.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    state.polled = timestamp;
+    state.status = status;
+    if(Status::Ok == status)
+    {
+        const auto *src = executor.dataBegin(i);
+        auto *const dst = base_ + block.offset;
+
+        switch(block.fcode)
+        {
+            case FCODE_RD_HOLDING_REGISTERS:
+            {
+                auto *const reg = reinterpret_cast<uint16_t *>(dst);
+
+                for(std::size_t n = 0; n < block.count; ++n, src += 2)
+                {
+                    reg[n] = uint16_t((uint16_t(src[0]) << 8) | src[1]);
+                }
+                break;
+            }
+            case FCODE_RD_COILS:
+            {
+                /* packed, LSB first */
+                for(std::size_t n = 0; n < block.count; ++n)
+                {
+                    dst[n] = (src[n >> 3] >> (n & 0x7)) & 0x1;
+                }
+                break;
+            }
+            default:
+                std::memcpy(dst, src, block.size);
+                break;
+        }
+        state.updated = timestamp;
+        state.failures = 0;
+        state.quality = Quality::Good;
+    }
+    else
+    {
+        ++state.failures;
+        if(Quality::None != state.quality) state.quality = Quality::Stale;
+    }
+
+    block.seq.store(seq + 2, std::memory_order_release);
+}
+
+void ShmImage::heartbeat()
+{
+    ENSURE(writer_, RuntimeError);
+
+    header().cycles.fetch_add(1, std::memory_order_relaxed);
+    header().heartbeat.store(now(), std::memory_order_release);
+}
+
+std::size_t ShmImage::find(uint8_t slave, uint8_t fcode, uint16_t addr) const
+{
+    for(std::size_t i = 0; i < blockNum(); ++i)
+    {
+        const auto &block = blockAt(i);
+
+        if(
+            slave == block.slave
+            && fcode == block.fcode
+            && addr >= block.addr
+            && uint32_t(addr) < uint32_t(block.addr) + block.count) return i;
+    }
+    return npos;
+}
+
+uint32_t ShmImage::readBegin(std::size_t i) const
+{
+    const auto &block = blockAt(i);
+
+    for(;;)
+    {
+        const auto seq = block.seq.load(std::memory_order_acquire);
+
+        /* odd - write in progress (short, bounded by block size) */
+        if(!(seq & 0x1)) return seq;
+    }
+}
+
+bool ShmImage::readRetry(std::size_t i, uint32_t seq) const
+{
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return seq != blockAt(i).seq.load(std::memory_order_relaxed);
+}
+
+ShmImage::State ShmImage::read(std::size_t i, uint8_t *dst) const
+{
+    const auto &block = blockAt(i);
+    State state;
+    uint32_t seq;
+
+    do
+    {
+        seq = readBegin(i);
+        std::memcpy(dst, base_ + block.offset, block.size);
+        state = block.state;
+    }
+    while(readRetry(i, seq));
+    return state;
+}
+
+const char *toString(ShmImage::Quality quality)
+{
+    switch(quality)
+    {
+        case ShmImage::Quality::None: return "none";
+        case ShmImage::Quality::Good: return "good";
+        case ShmImage::Quality::Stale: return "stale";
+    }
+    return "unknown";
+}
+
+} /* RTU */
+} /* Modbus */
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Plan.h"
+#include "Status.h"
+
+namespace Modbus {
+namespace RTU {
+
+/* Image of polled data in POSIX shared memory (shm_open name e.g. "/modbus"):
+ * one block per read request of Plan (registers, coils or bytes of single
+ * slave), written by single poller process and read by any number of local
+ * processes without locks and without touching the bus.
+ *
+ * Every block is guarded by its own seqlock: writer makes sequence odd,
+ * updates block and makes it even again, reader retries if sequence was odd
+ * or changed meanwhile (see readBegin()/readRetry()). Readers never block
+ * writer and never write to segment (mapped read-only).
+ *
+ * Data is decoded: registers are native uint16_t, coils one byte (0/1) each,
+ * bytes as received. Data of last successful poll is kept on failure
+ * (Quality::Stale). Timestamps are ns since epoch (system clock). */
+class ShmImage
+{
+public:
+    static constexpr const uint32_t MAGIC = 0x4D425348; /* MBSH */
+    static constexpr const uint32_t VERSION = 1;
+    static constexpr const std::size_t npos = std::size_t(-1);
+
+    enum class Quality: uint8_t
+    {
+        None, /* not polled yet */
+        Good, /* last poll succeeded */
+        Stale /* last poll failed, data of previous successful poll */
+    };
+
+    struct alignas(64) Header
+    {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t blockNum;
+        uint32_t size;
+        /* end of last complete poll cycle - poller is alive */
+        std::atomic<uint64_t> heartbeat;
+        std::atomic<uint64_t> cycles;
+    };
+
+    /* mutable part of block (guarded by seqlock) */
+    struct State
+    {
+        uint64_t updated; /* last successful poll */
+        uint64_t polled; /* last poll */
+        uint32_t failures; /* consecutive */
+        Quality quality;
+        Status status; /* of last poll */
+    };
+
+    /* cache line per block - writer does not invalidate neighbouring blocks */
+    struct alignas(64) Block
+    {
+        std::atomic<uint32_t> seq;
+        uint32_t offset; /* of data from segment begin */
+        uint32_t size; /* of data */
+        uint16_t addr;
+        uint16_t count;
+        uint8_t slave;
+        uint8_t fcode;
+        State state;
+    };
+private:
+    std::string name_;
+    bool writer_;
+    uint8_t *base_{nullptr};
+    std::size_t size_{0};
+    /* plan request -> block (npos for writes) */
+    std::vector<std::size_t> blockOf_;
+
+    Header &header() const { return *reinterpret_cast<Header *>(base_); }
+    Block &blockAt(std::size_t i) const { return reinterpret_cast<Block *>(base_ + sizeof(Header))[i]; }
+public:
+    /* writer: segment is (re)created for read requests of plan,
+     * readers of previous segment keep their (no longer updated) mapping */
+    ShmImage(const std::string &name, const Plan &plan);
+    /* reader */
+    explicit ShmImage(const std::string &name);
+    ~ShmImage();
+
+    ShmImage(const ShmImage &) = delete;
+    ShmImage &operator=(const ShmImage &) = delete;
+
+    static bool isRead(uint8_t fcode);
+    /* timestamp of now */
+    static uint64_t now();
+    /* segment is removed, existing mappings stay valid */
+    static void remove(const std::string &name);
+
+    /* writer: store result of i-th request of executed plan */
+    void publish(const Executor &, std::size_t i, Status status);
+    /* writer: end of poll cycle */
+    void heartbeat();
+
+    std::size_t blockNum() const { return header().blockNum; }
+    uint64_t lastHeartbeat() const { return header().heartbeat.load(std::memory_order_acquire); }
+    uint64_t cycles() const { return header().cycles.load(std::memory_order_acquire); }
+    /* first block of slave/fcode containing addr or npos */
+    std::size_t find(uint8_t slave, uint8_t fcode, uint16_t addr) const;
+
+    /* immutable part of block (slave, fcode, addr, count, size) */
+    const Block &block(std::size_t i) const { return blockAt(i); }
+    /* zero-copy access, valid only between readBegin() and readRetry() == false:
+     *  do { seq = image.readBegin(i); v = image.data(i)[n]; } while(image.readRetry(i, seq)); */
+    const uint8_t *data(std::size_t i) const { return base_ + blockAt(i).offset; }
+    const uint16_t *registers(std::size_t i) const { return reinterpret_cast<const uint16_t *>(data(i)); }
+    /* as data(), valid only if readRetry() == false */
+    State state(std::size_t i) const { return blockAt(i).state; }
+    uint32_t readBegin(std::size_t i) const;
+    bool readRetry(std::size_t i, uint32_t seq) const;
+    /* consistent copy of block data (block(i).size bytes) and state */
+    State read(std::size_t i, uint8_t *dst) const;
+};
+
+const char *toString(ShmImage::Quality);
+
+} /* RTU */
+} /* Modbus */
@@ -0,0 +1,521 @@
+#include <algorithm>
+#include <iomanip>
+
+#include "Ensure.h"
+#include "Frame.h"
+#include "Slave.h"
+#include "Trace.h"
+
+namespace Modbus {
+namespace RTU {
+namespace {
+
+constexpr const std::size_t ADU_MAX_SIZE = 256;
+/* remaining part of request has to follow its first bytes without (long) gap */
+constexpr const mSecs frameTimeout{10};
+
+uint8_t lowByte(uint16_t word) { return word & 0xFF; }
+uint8_t highByte(uint16_t word) { return word >> 8; }
+
+/* ECODE_* carry 0x80 flag, exception code in reply is without it */
+uint8_t toExceptionCode(uint8_t ecode) { return ecode & 0x7F; }
+
+template <typename T>
+bool inRange(const std::vector<T> &mem, std::size_t addr, std::size_t count = 1)
+{
+    return addr + count <= mem.size();
+}
+
+} /* namespace */
+
+Slave::Image::Image(const Profile &profile):
+    coils(std::min(profile.coilNum, MEM_SIZE), UINT8_C(0)),
+    registers(std::min(profile.registerNum, MEM_SIZE), UINT16_C(0)),
+    bytes(std::min(profile.byteNum, MEM_SIZE), UINT8_C(0))
+{}
+
+Slave::Slave(Addr addr, Profile profile):
+    addr_{addr},
+    profile_{profile},
+    image_{profile_}
+{
+    ENSURE(addr_.min <= addr_.value, RuntimeError);
+    ENSURE(0.0 <= profile_.dropRate && 1.0 >= profile_.dropRate, RuntimeError);
+    ENSURE(0.0 <= profile_.deadRate && 1.0 >= profile_.deadRate, RuntimeError);
+}
+
+void Slave::exception(ByteSeq &rep, uint8_t fcode, uint8_t ecode)
+{
+    ++exceptionCntr_;
+    rep = {addr_.value, uint8_t(fcode | 0x80), toExceptionCode(ecode)};
+}
+
+void Slave::execute(const uint8_t *const req, const uint8_t *const end, ByteSeq &rep)
+{
+    const auto size = std::size_t(end - req);
+    const auto fcode = req[1];
+    const auto word = [req](std::size_t i) { return uint16_t(req[i] << 8 | req[i + 1]); };
+    auto &image = image_;
+
+    switch(fcode)
+    {
+        case FCODE_RD_COILS:
+        {
+            const auto addr = word(2), count = word(4);
+
+            if(6 != size || 0 == count || 2000 < count) return exception(rep, fcode, ECODE_ILLEGAL_DATA_VALUE);
+            if(!inRange(image.coils, addr, count)) return exception(rep, fcode, ECODE_ILLEGAL_DATA_ADDRESS);
+
+            const auto byteCount = (count >> 3) + (count & 0x7 ? 1 : 0);
+
+            rep = {addr_.value, fcode, uint8_t(byteCount)};
+            rep.resize(rep.size() + byteCount, UINT8_C(0));
+            for(std::size_t i = 0; i < count; ++i)
+            {
+                if(image.coils[addr + i]) rep[3 + (i >> 3)] |= 1 << (i & 0x7);
+            }
+            break;
+        }
+        case FCODE_RD_HOLDING_REGISTERS:
+        {
+            const auto addr = word(2), count = word(4);
+
+            if(6 != size || 0 == count || 125 < count) return exception(rep, fcode, ECODE_ILLEGAL_DATA_VALUE);
+            if(!inRange(image.registers, addr, count)) return exception(rep, fcode, ECODE_ILLEGAL_DATA_ADDRESS);
+
+            rep = {addr_.value, fcode, uint8_t(count << 1)};
+            for(std::size_t i = 0; i < count; ++i)
+            {
+                rep.push_back(highByte(image.registers[addr + i]));
+                rep.push_back(lowByte(image.registers[addr + i]));
+            }
+            break;
+        }
+        case FCODE_WR_COIL:
+        {
+            const auto addr = word(2), value = word(4);
+
+            if(6 != size || (0xFF00 != value && 0x0000 != value)) return exception(rep, fcode, ECODE_ILLEGAL_DATA_VALUE);
+            if(!inRange(image.coils, addr)) return exception(rep, fcode, ECODE_ILLEGAL_DATA_ADDRESS);
+
+            image.coils[addr] = 0xFF00 == value;
+            rep.assign(req, req + 6);
+            break;
+        }
+        case FCODE_WR_REGISTER:
+        {
+            const auto addr = word(2);
+
+            if(6 != size) return exception(rep, fcode, ECODE_ILLEGAL_DATA_VALUE);
+            if(!inRange(image.registers, addr)) return exception(rep, fcode, ECODE_ILLEGAL_DATA_ADDRESS);
+
+            image.registers[addr] = word(4);
+            rep.assign(req, req + 6);
+            break;
+        }
+        case FCODE_WR_REGISTERS:
+        {
+            const auto addr = word(2), count = word(4);
+            const auto byteCount = req[6];
+
+            if(
+                0 == count || 123 < count
+                || std::size_t(count << 1) != byteCount
+                || 7u + byteCount != size)
+            {
+                return exception(rep, fcode, ECODE_ILLEGAL_DATA_VALUE);
+            }
+            if(!inRange(image.registers, addr, count)) return exception(rep, fcode, ECODE_ILLEGAL_DATA_ADDRESS);
+
+            for(std::size_t i = 0; i < count; ++i) image.registers[addr + i] = word(7 + (i << 1));
+            rep.assign(req, req + 6);
+            break;
+        }
+        case FCODE_RD_BYTES:
+        {
+            const auto addr = word(2);
+            const auto count = req[4];
+
+            if(5 != size || 0 == count || 250 <= count) return exception(rep, fcode, ECODE_ILLEGAL_DATA_VALUE);
+            if(!inRange(image.bytes, addr, count)) return exception(rep, fcode, ECODE_ILLEGAL_DATA_ADDRESS);
+
+            rep.assign(req, req + 5);
+            rep.insert(std::end(rep), &image.bytes[addr], &image.bytes[addr] + count);
+            break;
+        }
+        case FCODE_WR_BYTES:
+        {
+            const auto addr = word(2);
+            const auto count = req[4];
+
+            if(0 == count || 250 <= count || 5u + count != size) return exception(rep, fcode, ECODE_ILLEGAL_DATA_VALUE);
+            if(!inRange(image.bytes, addr, count)) return exception(rep, fcode, ECODE_ILLEGAL_DATA_ADDRESS);
+
+            std::copy(req + 5, req + 5 + count, &image.bytes[addr]);
+            rep.assign(req, req + 5);
+            break;
+        }
+        default:
+            return exception(rep, fcode, ECODE_ILLEGAL_FUNCTION);
+    }
+}
+
+const char *toString(Fault fault)
+{
+    switch(fault)
+    {
+        case Fault::Flip: return "flip";
+        case Fault::Drop: return "drop";
+        case Fault::Truncate: return "truncate";
+        case Fault::Gap: return "gap";
+        case Fault::Duplicate: return "duplicate";
+        case Fault::Echo: return "echo";
+    }
+    return "unknown";
+}
+
+Fault toFault(const std::string &name)
+{
+    for(std::size_t i = 0; i < FAULT_NUM; ++i)
+    {
+        if(name == toString(Fault(i))) return Fault(i);
+    }
+    ENSURE(false && "unsupported fault", RuntimeError);
+    return Fault::Flip;
+}
+
+Bus::Bus(uint32_t seed):
+    port_{nullptr},
+    random_{seed},
+    req_(ADU_MAX_SIZE, UINT8_C(0))
+{
+    /* duplicated byte */
+    rep_.reserve(ADU_MAX_SIZE + 1);
+}
+
+Bus::Bus(Transport &port, uint32_t seed):
+    Bus{seed}
+{
+    port_ = &port;
+}
+
+Slave &Bus::add(Addr addr, Slave::Profile profile)
+{
+    ENSURE(!slaves_.count(addr.value), RuntimeError);
+
+    auto &slave = slaves_.emplace(addr.value, Slave{addr, profile}).first->second;
+
+    slave.dead(std::bernoulli_distribution{profile.deadRate}(random_));
+    return slave;
+}
+
+Slave &Bus::slave(Addr addr)
+{
+    const auto i = slaves_.find(addr.value);
+
+    ENSURE(std::end(slaves_) != i, RuntimeError);
+    return i->second;
+}
+
+/* Request size is known from fcode (and byte count for WR_REGISTERS/WR_BYTES),
+ * so request is complete as soon as last byte is received. Unknown requests
+ * are read until silence. */
+const uint8_t *Bus::readRequest(mSecs timeout)
+{
+    const auto begin = req_.data();
+    const auto end = begin + req_.size();
+    auto curr = port_->read(begin, begin + 2 /* slave + fcode */, timeout);
+
+    if(begin == curr) return nullptr;
+
+    const auto readUntil =
+        [&](std::size_t size)
+        {
+            /* byte count of WR_REGISTERS/WR_BYTES may exceed ADU */
+            if(req_.size() < size) return false;
+            if(std::size_t(curr - begin) < size) curr = port_->read(curr, begin + size, frameTimeout);
+            return begin + size == curr;
+        };
+
+    const auto discard =
+        [&]()
+        {
+            port_->flush();
+            return nullptr;
+        };
+
+    if(!readUntil(2)) return discard();
+
+    switch(begin[1])
+    {
+        case FCODE_RD_COILS:
+        case FCODE_RD_HOLDING_REGISTERS:
+        case FCODE_WR_COIL:
+        case FCODE_WR_REGISTER:
+            if(!readUntil(8)) return discard();
+            break;
+        case FCODE_RD_BYTES:
+            if(!readUntil(7)) return discard();
+            break;
+        case FCODE_WR_REGISTERS:
+            if(!readUntil(7) || !readUntil(7 + begin[6] + sizeof(CRC))) return discard();
+            break;
+        case FCODE_WR_BYTES:
+            if(!readUntil(5) || !readUntil(5 + begin[4] + sizeof(CRC))) return discard();
+            break;
+        default:
+            curr = port_->read(curr, end, frameTimeout);
+            break;
+    }
+    return curr;
+}
+
+Bus::uSecs Bus::responseTime(const Slave::Profile &profile)
+{
+    using Distribution = Slave::Profile::Distribution;
+
+    if(uSecs{0} == profile.jitter) return profile.turnaround;
+
+    const auto jitter = double(profile.jitter.count());
+    const auto delay =
+        Distribution::Exponential == profile.distribution
+        ? std::exponential_distribution<double>{1.0 / jitter}(random_)
+        : std::uniform_real_distribution<double>{0.0, jitter}(random_);
+
+    return profile.turnaround + uSecs{int64_t(delay)};
+}
+
+bool Bus::inject(Fault fault)
+{
+    const auto rate = faults_[fault];
+
+    if(0.0 >= rate || !std::bernoulli_distribution{rate}(random_)) return false;
+    ++faultCntrs_[std::size_t(fault)];
+    return true;
+}
+
+void Bus::flip(Slave::ByteSeq::iterator begin, Slave::ByteSeq::iterator end)
+{
+    const auto bit =
+        std::uniform_int_distribution<std::size_t>{0, std::size_t(end - begin) * 8 - 1}(random_);
+
+    begin[bit >> 3] ^= 1 << (bit & 0x7);
+}
+
+void Bus::reply(Slave &slave, std::size_t reqSize)
+{
+    const auto crc = calcCRC(rep_.data(), rep_.data() + rep_.size());
+
+    rep_.push_back(crc.lowByte());
+    rep_.push_back(crc.highByte());
+
+    /* echo is (almost) immediate - it is transmitted by adapter */
+    if(inject(Fault::Echo)) chunks_.push_back(Chunk{uSecs{0}, req_.data(), req_.data() + reqSize});
+
+    const auto delay = responseTime(slave.profile());
+
+    if(inject(Fault::Drop)) return;
+    if(inject(Fault::Flip)) flip(std::begin(rep_), std::end(rep_));
+    if(inject(Fault::Duplicate))
+    {
+        const auto i = std::uniform_int_distribution<std::size_t>{0, rep_.size() - 1}(random_);
+
+        rep_.insert(std::next(std::begin(rep_), i), rep_[i]);
+    }
+
+    const auto begin = rep_.data();
+    auto end = begin + rep_.size();
+
+    if(inject(Fault::Truncate))
+    {
+        end = begin + std::uniform_int_distribution<std::size_t>{1, rep_.size() - 1}(random_);
+    }
+
+    if(1 < end - begin && inject(Fault::Gap))
+    {
+        const auto split =
+            begin + std::uniform_int_distribution<std::ptrdiff_t>{1, end - begin - 1}(random_);
+
+        chunks_.push_back(Chunk{delay, begin, split});
+        chunks_.push_back(Chunk{faults_.gap, split, end});
+    }
+    else chunks_.push_back(Chunk{delay, begin, end});
+}
+
+bool Bus::dispatch(std::size_t size, Clock::time_point now)
+{
+    chunks_.clear();
+    ++frameCntr_;
+
+    if(size < 2 + sizeof(CRC)) return false;
+
+    if(inject(Fault::Flip)) flip(std::begin(req_), std::next(std::begin(req_), size));
+
+    const auto begin = req_.data();
+    const auto end = begin + size;
+    const auto crc = calcCRC(begin, end - sizeof(CRC));
+
+    /* invalid frames are ignored - master will timeout */
+    if(crc.lowByte() != end[-2] || crc.highByte() != end[-1])
+    {
+        ++crcErrorCntr_;
+        return false;
+    }
+
+    const auto pduEnd = end - sizeof(CRC);
+
+    if(0 == begin[0])
+    {
+        for(auto &i : slaves_)
+        {
+            if(i.second.dead()) continue;
+            ++i.second.requestCntr_;
+            i.second.execute(begin, pduEnd, rep_);
+        }
+        return true;
+    }
+
+    const auto i = slaves_.find(begin[0]);
+
+    if(std::end(slaves_) == i || i->second.dead())
+    {
+        ++absentCntr_;
+        return false;
+    }
+
+    auto &slave = i->second;
+
+    if(Clock::time_point{} != slave.lastRequest_)
+    {
+        slave.pollInterval_.record(std::chrono::duration_cast<uSecs>(now - slave.lastRequest_));
+    }
+    slave.lastRequest_ = now;
+    ++slave.requestCntr_;
+
+    if(std::bernoulli_distribution{slave.profile().dropRate}(random_))
+    {
+        ++slave.dropCntr_;
+        return true;
+    }
+
+    rep_.clear();
+    slave.execute(begin, pduEnd, rep_);
+    reply(slave, size);
+    return true;
+}
+
+const Bus::Chunks &Bus::process(const uint8_t *begin, const uint8_t *end, Clock::time_point now)
+{
+    const auto size = std::min(std::size_t(end - begin), req_.size());
+
+    std::copy(begin, begin + size, std::begin(req_));
+    dispatch(size, now);
+    return chunks_;
+}
+
+bool Bus::serve(mSecs timeout)
+{
+    ENSURE(port_, RuntimeError);
+
+    const auto end = readRequest(timeout);
+
+    if(!end) return false;
+
+    const auto served = dispatch(std::size_t(end - req_.data()), Clock::now());
+
+    for(const auto &chunk : chunks_)
+    {
+        if(uSecs{0} < chunk.delay) std::this_thread::sleep_for(chunk.delay);
+
+        const auto r = port_->write(chunk.begin, chunk.end, mSecs{100});
+
+        if(chunk.end != r) TRACE(TraceLevel::Warning, "reply not transmitted");
+    }
+    return served;
+}
+
+void Bus::dump(std::ostream &os) const
+{
+    const auto flags = os.flags();
+
+    os
+        << std::dec
+        << "frames " << frameCntr_
+        << " crc errors " << crcErrorCntr_
+        << " absent " << absentCntr_;
+    for(std::size_t i = 0; i < FAULT_NUM; ++i)
+    {
+        if(faultCntrs_[i]) os << ' ' << toString(Fault(i)) << ' ' << faultCntrs_[i];
+    }
+    os << '\n';
+
+    for(const auto &i : slaves_)
+    {
+        const auto &slave = i.second;
+        const auto &h = slave.pollInterval();
+
+        os
+            << "slave " << std::setw(3) << int(i.first)
+            << (slave.dead() ? " dead" : "")
+            << " requests " << slave.requestCntr()
+            << " exceptions " << slave.exceptionCntr()
+            << " drops " << slave.dropCntr()
+            << " interval p50 " << h.percentile(0.5).count()
+            << " p99 " << h.percentile(0.99).count()
+            << " max " << h.max().count() << "us\n";
+    }
+    os << std::flush;
+    os.flags(flags);
+}
+
+Simulator::Simulator(
+    const Profiles &profiles,
+    const Faults &faults,
+    uint32_t seed,
+    SerialPort::BaudRate baudRate,
+    SerialPort::DataBits dataBits,
+    SerialPort::StopBits stopBits):
+    pty_{createPseudoTerminal(baudRate, SerialPort::Parity::None, dataBits, stopBits)},
+    bus_{pty_.master, seed}
+{
+    for(const auto &i : profiles) bus_.add(Addr{i.first}, i.second);
+    bus_.faults(faults);
+
+    thread_ =
+        std::thread
+        {
+            [this]()
+            {
+                while(!stop_)
+                {
+                    try
+                    {
+                        bus_.serve(mSecs{10});
+                    }
+                    catch(const std::exception &except)
+                    {
+                        TRACE(TraceLevel::Error, except.what());
+                        std::this_thread::sleep_for(mSecs{10});
+                    }
+                }
+            }
+        };
+}
+
+Simulator::Simulator(Addr addr, Slave::uSecs turnaround):
+    Simulator{Profiles{{addr.value, Slave::Profile{turnaround}}}}
+{}
+
+Simulator::~Simulator()
+{
+    stop();
+}
+
+void Simulator::stop()
+{
+    stop_ = true;
+    if(thread_.joinable()) thread_.join();
+}
+
+} /* RTU */
+} /* Modbus */
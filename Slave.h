@@ -0,0 +1,256 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <ostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Master.h"
+#include "PseudoSerial.h"
+#include "SerialPort.h"
+#include "Timing.h"
+
+namespace Modbus {
+namespace RTU {
+
+class Bus;
+
+/* Modbus RTU slave (server) model: requests are executed against in-memory
+ * image, supported:
+ * RD_COILS (1), RD_HOLDING_REGISTERS (3), WR_COIL (5), WR_REGISTER (6),
+ * WR_REGISTERS (16), RD_BYTES (65), WR_BYTES (66).
+ * Invalid requests are replied with exception (as real device would do).
+ * Slave is served by Bus - it owns serial port and dispatches requests. */
+class Slave
+{
+public:
+    using uSecs = std::chrono::microseconds;
+    using ByteSeq = std::vector<uint8_t>;
+
+    static constexpr const std::size_t MEM_SIZE = 0x10000;
+
+    struct Profile
+    {
+        enum class Distribution : uint8_t
+        {
+            /* turnaround + [0, jitter] */
+            Uniform,
+            /* turnaround + exponential with mean jitter (long tail) */
+            Exponential
+        };
+
+        uSecs turnaround{0};
+        uSecs jitter{0};
+        Distribution distribution{Distribution::Uniform};
+        /* probability that request is not replied (flaky device) */
+        double dropRate{0.0};
+        /* probability that device is dead (never replies),
+         * decided once when slave is added to Bus */
+        double deadRate{0.0};
+        /* memory map: addresses [0, N) are valid, rest is replied with
+         * ILLEGAL_DATA_ADDRESS */
+        std::size_t coilNum{MEM_SIZE};
+        std::size_t registerNum{MEM_SIZE};
+        std::size_t byteNum{MEM_SIZE};
+    };
+
+    struct Image
+    {
+        /* single byte (0/1) per coil */
+        std::vector<uint8_t> coils;
+        std::vector<uint16_t> registers;
+        /* RD_BYTES/WR_BYTES byte-addressable space */
+        std::vector<uint8_t> bytes;
+
+        explicit Image(const Profile &);
+    };
+private:
+    friend class Bus;
+
+    Addr addr_;
+    Profile profile_;
+    Image image_;
+    bool dead_{false};
+    uint64_t requestCntr_{0};
+    uint64_t exceptionCntr_{0};
+    uint64_t dropCntr_{0};
+    /* time between consecutive requests - regularity of polling */
+    Histogram pollInterval_;
+    std::chrono::steady_clock::time_point lastRequest_{};
+
+    void exception(ByteSeq &rep, uint8_t fcode, uint8_t ecode);
+public:
+    Slave(Addr addr, Profile profile);
+
+    Addr addr() const { return addr_; }
+    Image &image() { return image_; }
+    const Image &image() const { return image_; }
+    Profile &profile() { return profile_; }
+    const Profile &profile() const { return profile_; }
+    bool dead() const { return dead_; }
+    void dead(bool value) { dead_ = value; }
+
+    /* execute request [begin, end) (slave + PDU, without CRC),
+     * reply (without CRC) is stored in rep */
+    void execute(const uint8_t *begin, const uint8_t *end, ByteSeq &rep);
+
+    uint64_t requestCntr() const { return requestCntr_; }
+    uint64_t exceptionCntr() const { return exceptionCntr_; }
+    uint64_t dropCntr() const { return dropCntr_; }
+    const Histogram &pollInterval() const { return pollInterval_; }
+};
+
+/* faults injected by Bus - line noise and misbehaving adapters */
+enum class Fault : uint8_t
+{
+    /* single random bit of request (ignored by slave) or reply (CRC error) is flipped */
+    Flip,
+    /* reply is not transmitted */
+    Drop,
+    /* only random prefix of reply is transmitted */
+    Truncate,
+    /* reply is transmitted in two parts separated by Faults::gap */
+    Gap,
+    /* random byte of reply is transmitted twice */
+    Duplicate,
+    /* request is echoed back before reply (adapter without echo suppression) */
+    Echo
+};
+
+constexpr const std::size_t FAULT_NUM = 6;
+
+const char *toString(Fault);
+Fault toFault(const std::string &);
+
+struct Faults
+{
+    /* per frame probability of every fault, faults are independent */
+    std::array<double, FAULT_NUM> rates{};
+    /* injected inter-character gap */
+    std::chrono::microseconds gap{2000};
+
+    double &operator[](Fault fault) { return rates[std::size_t(fault)]; }
+    double operator[](Fault fault) const { return rates[std::size_t(fault)]; }
+};
+
+/* Simulated Modbus RTU segment: any number of slaves (addresses 1-247)
+ * sharing single serial port, every slave has its own profile (response
+ * time distribution, dead/flaky probability and memory map).
+ * Frames with invalid CRC or addressed to absent slaves are ignored,
+ * broadcast (address 0) writes are executed by every slave without reply.
+ * Faults are injected on top of slave profiles, same seeded generator is used.
+ * Slaves are not synchronized - access them only when bus is not serving. */
+class Bus
+{
+public:
+    using uSecs = Slave::uSecs;
+    using Clock = std::chrono::steady_clock;
+    using Slaves = std::map<uint8_t, Slave>;
+
+    /* part of reply - [begin, end) transmitted after delay */
+    struct Chunk
+    {
+        uSecs delay;
+        const uint8_t *begin;
+        const uint8_t *end;
+    };
+
+    using Chunks = std::vector<Chunk>;
+private:
+    Transport *port_;
+    Slaves slaves_;
+    std::mt19937 random_;
+    Slave::ByteSeq req_;
+    Slave::ByteSeq rep_;
+    Faults faults_;
+    Chunks chunks_;
+    std::array<uint64_t, FAULT_NUM> faultCntrs_{};
+    uint64_t frameCntr_{0};
+    uint64_t crcErrorCntr_{0};
+    uint64_t absentCntr_{0};
+
+    const uint8_t *readRequest(mSecs timeout);
+    uSecs responseTime(const Slave::Profile &);
+    bool inject(Fault);
+    void flip(Slave::ByteSeq::iterator begin, Slave::ByteSeq::iterator end);
+    void reply(Slave &, std::size_t reqSize);
+    bool dispatch(std::size_t reqSize, Clock::time_point now);
+public:
+    /* without port requests are only processed (see process()) */
+    explicit Bus(uint32_t seed = std::mt19937::default_seed);
+    explicit Bus(Transport &port, uint32_t seed = std::mt19937::default_seed);
+
+    Bus(const Bus &) = delete;
+    Bus &operator=(const Bus &) = delete;
+
+    Slave &add(Addr addr, Slave::Profile profile = Slave::Profile{});
+    Slave &slave(Addr addr);
+    const Slaves &slaves() const { return slaves_; }
+    /* (re)bind to port e.g. next TCP connection, nullptr unbinds */
+    void port(Transport *port) { port_ = port; }
+    void faults(const Faults &faults) { faults_ = faults; }
+    const Faults &faults() const { return faults_; }
+
+    /* wait (up to timeout) for single request and execute it,
+     * returns false if no valid request addressed to present slave was received */
+    bool serve(mSecs timeout);
+    /* execute request [begin, end) (complete ADU) received at now, reply
+     * (and injected faults) is returned as chunks to be transmitted,
+     * valid until next request */
+    const Chunks &process(const uint8_t *begin, const uint8_t *end, Clock::time_point now);
+
+    uint64_t frameCntr() const { return frameCntr_; }
+    uint64_t crcErrorCntr() const { return crcErrorCntr_; }
+    /* requests addressed to absent slaves (e.g. probe scanning) */
+    uint64_t absentCntr() const { return absentCntr_; }
+    uint64_t faultCntr(Fault fault) const { return faultCntrs_[std::size_t(fault)]; }
+    /* one line per slave: requests, exceptions, drops and poll interval */
+    void dump(std::ostream &) const;
+};
+
+/* Bus bound to pseudo terminal and served on its own thread,
+ * device() can be opened by Master (local stand-in for real devices
+ * in tests and benchmarks). Pseudo terminals do not support parity,
+ * so Master has to use Parity::None. */
+class Simulator
+{
+public:
+    /* key: slave address */
+    using Profiles = std::map<uint8_t, Slave::Profile>;
+private:
+    PseudoTerminal pty_;
+    Bus bus_;
+    std::atomic<bool> stop_{false};
+    std::thread thread_;
+public:
+    Simulator(
+        const Profiles &profiles,
+        const Faults &faults = Faults{},
+        uint32_t seed = std::mt19937::default_seed,
+        SerialPort::BaudRate baudRate = SerialPort::BaudRate::BR_19200,
+        SerialPort::DataBits dataBits = SerialPort::DataBits::Eight,
+        SerialPort::StopBits stopBits = SerialPort::StopBits::One);
+    /* single slave */
+    Simulator(Addr addr, Slave::uSecs turnaround = Slave::uSecs{0});
+    ~Simulator();
+
+    /* stop serving - bus can be safely inspected afterwards */
+    void stop();
+
+    Simulator(const Simulator &) = delete;
+    Simulator &operator=(const Simulator &) = delete;
+
+    const std::string &device() const { return pty_.slave.path(); }
+    /* image and counters, see Bus */
+    Bus &bus() { return bus_; }
+    Slave &slave(Addr addr) { return bus_.slave(addr); }
+};
+
+} /* RTU */
+} /* Modbus */
@@ -0,0 +1,344 @@
+#include <algorithm>
+#include <iomanip>
+
+#include "Frame.h"
+#include "Sniffer.h"
+
+namespace Modbus {
+namespace RTU {
+namespace {
+
+uint16_t word(const uint8_t *data)
+{
+    return uint16_t((uint16_t(data[0]) << 8) | data[1]);
+}
+
+bool validCRC(const uint8_t *data, std::size_t size)
+{
+    if(2 + sizeof(CRC) > size) return false;
+
+    const auto crc = calcCRC(data, data + size - sizeof(CRC));
+
+    return crc.lowByte() == data[size - 2] && crc.highByte() == data[size - 1];
+}
+
+const char *fcodeName(uint8_t fcode)
+{
+    switch(fcode & 0x7F)
+    {
+        case FCODE_RD_COILS: return "RD_COILS";
+        case FCODE_RD_HOLDING_REGISTERS: return "RD_HOLDING_REGISTERS";
+        case FCODE_WR_COIL: return "WR_COIL";
+        case FCODE_WR_REGISTER: return "WR_REGISTER";
+        case FCODE_WR_REGISTERS: return "WR_REGISTERS";
+        case FCODE_RD_BYTES: return "RD_BYTES";
+        case FCODE_WR_BYTES: return "WR_BYTES";
+        default: break;
+    }
+    return "UNKNOWN";
+}
+
+void hex(std::ostream &os, const uint8_t *begin, const uint8_t *const end)
+{
+    for(; begin != end; ++begin) os << ' ' << std::setw(2) << int(*begin);
+}
+
+void registers(std::ostream &os, const uint8_t *begin, const uint8_t *const end)
+{
+    for(; begin + 1 < end; begin += 2) os << ' ' << std::setw(4) << word(begin);
+}
+
+/* fields of valid frame (without slave, fcode and CRC) */
+void decode(std::ostream &os, const uint8_t *data, std::size_t size, bool reply)
+{
+    const auto *const end = data + size - sizeof(CRC);
+
+    os << std::hex << std::setfill('0');
+    if(reply && (data[1] & 0x80))
+    {
+        os << " exception " << std::setw(2) << int(data[2]);
+        return;
+    }
+
+    switch(data[1])
+    {
+        case FCODE_RD_COILS:
+        case FCODE_RD_HOLDING_REGISTERS:
+            if(reply && FCODE_RD_COILS == data[1]) hex(os << " coils", data + 3, end);
+            else if(reply) registers(os << " registers", data + 3, end);
+            else os << " addr " << std::setw(4) << word(data + 2) << std::dec << " count " << word(data + 4);
+            break;
+        case FCODE_WR_COIL:
+            os << " addr " << std::setw(4) << word(data + 2) << (data[4] ? " on" : " off");
+            break;
+        case FCODE_WR_REGISTER:
+            os << " addr " << std::setw(4) << word(data + 2) << " value " << std::setw(4) << word(data + 4);
+            break;
+        case FCODE_WR_REGISTERS:
+            os << " addr " << std::setw(4) << word(data + 2) << std::dec << " count " << word(data + 4);
+            if(!reply) registers(os << std::hex << " registers", data + 7, end);
+            break;
+        case FCODE_RD_BYTES:
+        case FCODE_WR_BYTES:
+            /* RD_BYTES reply and WR_BYTES request carry data */
+            os << " addr " << std::setw(4) << word(data + 2) << std::dec << " count " << int(data[4]);
+            if(reply == (FCODE_RD_BYTES == data[1])) hex(os << std::hex << " bytes", data + 5, end);
+            break;
+        default:
+            hex(os << " data", data + 2, end);
+            break;
+    }
+}
+
+} /* namespace */
+
+Sniffer::Sniffer(uSecs charTime): charTime_{charTime}
+{}
+
+std::size_t Sniffer::requestSize(const uint8_t *data, std::size_t size)
+{
+    if(2 > size) return 0;
+
+    switch(data[1])
+    {
+        case FCODE_RD_COILS:
+        case FCODE_RD_HOLDING_REGISTERS:
+        case FCODE_WR_COIL:
+        case FCODE_WR_REGISTER:
+            return 8;
+        case FCODE_RD_BYTES:
+            return 7;
+        case FCODE_WR_REGISTERS:
+            return 7 > size ? 0 : 7 + data[6] + sizeof(CRC);
+        case FCODE_WR_BYTES:
+            return 5 > size ? 0 : 5 + data[4] + sizeof(CRC);
+        default:
+            break;
+    }
+    return 0;
+}
+
+std::size_t Sniffer::replySize(const uint8_t *data, std::size_t size)
+{
+    if(2 > size) return 0;
+    if(data[1] & 0x80) return 3 + sizeof(CRC);
+
+    switch(data[1])
+    {
+        case FCODE_RD_COILS:
+        case FCODE_RD_HOLDING_REGISTERS:
+            return 3 > size ? 0 : 3 + data[2] + sizeof(CRC);
+        case FCODE_WR_COIL:
+        case FCODE_WR_REGISTER:
+        case FCODE_WR_REGISTERS:
+            return 8;
+        case FCODE_RD_BYTES:
+            /* header echoes request: slave, fcode, address, count */
+            return 5 > size ? 0 : 5 + data[4] + sizeof(CRC);
+        case FCODE_WR_BYTES:
+            return 5 + sizeof(CRC);
+        default:
+            break;
+    }
+    return 0;
+}
+
+bool Sniffer::matches(const uint8_t *data, std::size_t size) const
+{
+    return
+        pending_ && 2 <= size
+        && request_.slave == data[0]
+        && (request_.fcode == data[1] || (request_.fcode | 0x80) == data[1]);
+}
+
+std::size_t Sniffer::validSize(const uint8_t *data, std::size_t size) const
+{
+    /* frame of pending slave may be its reply or (retry) next request,
+     * reply of request which was not seen is reported as unpaired */
+    const std::size_t candidates[] =
+    {
+        matches(data, size) ? replySize(data, size) : 0,
+        requestSize(data, size),
+        replySize(data, size)
+    };
+
+    for(const auto candidate : candidates)
+    {
+        if(candidate && candidate <= size && validCRC(data, candidate)) return candidate;
+    }
+    return 0;
+}
+
+std::size_t Sniffer::segment(
+    const uint8_t *data, std::size_t size,
+    Clock::time_point begin, Clock::time_point end,
+    bool complete)
+{
+    const auto *const first = data;
+
+    if(Clock::time_point{} == origin_) origin_ = begin;
+
+    /* incomplete segment: every frame processed is wholly received */
+    while(size && (complete || MAX_FRAME_SIZE < size))
+    {
+        auto frameSize = validSize(data, size);
+
+        /* valid frame of unknown function */
+        if(!frameSize && complete && validCRC(data, size)) frameSize = size;
+        if(!frameSize)
+        {
+            /* garbage (noise, frame started before sniffer) until next valid frame */
+            const auto limit = complete ? size : size - MAX_FRAME_SIZE;
+
+            frameSize = 1;
+            while(frameSize < limit && !validSize(data + frameSize, size - frameSize)) ++frameSize;
+        }
+
+        const auto last = complete && frameSize == size;
+        const auto wire = charTime_ * int64_t(frameSize);
+        const auto frameEnd = last ? end : begin + wire;
+
+        /* timestamps of merged frames are estimated from wire time */
+        frame(data, frameSize, last ? std::max(begin, end - wire) : begin, frameEnd);
+        data += frameSize;
+        size -= frameSize;
+        begin = frameEnd;
+    }
+    return std::size_t(data - first);
+}
+
+void Sniffer::frame(const uint8_t *data, std::size_t size, Clock::time_point begin, Clock::time_point end)
+{
+    using namespace std::chrono;
+
+    ++stats_.frames;
+    stats_.bytes += size;
+
+    if(!validCRC(data, size))
+    {
+        ++stats_.crcErrors;
+        /* corrupted reply - request is done */
+        if(matches(data, size))
+        {
+            ++slaves_[request_.slave].crcErrors;
+            pending_ = false;
+        }
+        print("crc", false, data, size, begin);
+        return;
+    }
+
+    if(matches(data, size) && replySize(data, size) == size)
+    {
+        auto &slave = slaves_[request_.slave];
+        const auto turnaround = duration_cast<uSecs>(std::max(begin - request_.end, Clock::duration{0}));
+
+        ++slave.replies;
+        if(data[1] & 0x80) ++slave.exceptions;
+        slave.turnaround.record(turnaround);
+        pending_ = false;
+        print("rep", true, data, size, begin, turnaround.count());
+        return;
+    }
+
+    /* reply of request which was not seen */
+    if(requestSize(data, size) != size && replySize(data, size) == size)
+    {
+        ++stats_.unpaired;
+        print("rep?", true, data, size, begin);
+        return;
+    }
+
+    if(pending_) ++slaves_[request_.slave].noReplies;
+    pending_ = false;
+
+    if(0 == data[0])
+    {
+        ++stats_.broadcasts;
+        print("bcast", false, data, size, begin);
+        return;
+    }
+
+    ++slaves_[data[0]].requests;
+    pending_ = true;
+    request_ = Pending{data[0], data[1], end};
+    print("req", false, data, size, begin);
+}
+
+void Sniffer::print(
+    const char *what, bool reply,
+    const uint8_t *data, std::size_t size,
+    Clock::time_point timestamp, int64_t turnaround)
+{
+    using namespace std::chrono;
+
+    if(!os_) return;
+
+    auto &os = *os_;
+    const auto flags = os.flags();
+    const auto fill = os.fill();
+    const auto elapsed = duration_cast<uSecs>(timestamp - origin_).count();
+
+    os
+        << std::dec << std::setfill('0')
+        << elapsed / 1000000 << '.' << std::setw(6) << elapsed % 1000000
+        << ' ' << what;
+
+    if(validCRC(data, size))
+    {
+        os << " slave " << int(data[0]) << ' ' << fcodeName(data[1]);
+        decode(os, data, size, reply);
+    }
+    else hex(os << " size " << size << std::hex, data, data + size);
+    if(0 <= turnaround) os << std::dec << " turnaround " << turnaround << "us";
+    os << '\n';
+
+    os.fill(fill);
+    os.flags(flags);
+}
+
+void Sniffer::dump(std::ostream &os, Clock::duration window) const
+{
+    using namespace std::chrono;
+
+    const auto flags = os.flags();
+    const auto precision = os.precision();
+    const auto seconds = std::max(duration_cast<duration<double>>(window).count(), 1e-6);
+
+    os
+        << std::dec
+        << "frames " << stats_.frames
+        << " bytes " << stats_.bytes
+        << " crc errors " << stats_.crcErrors
+        << " broadcasts " << stats_.broadcasts
+        << " unpaired " << stats_.unpaired
+        << '\n';
+
+    for(const auto &i : slaves_)
+    {
+        const auto &slave = i.second;
+        const auto &h = slave.turnaround;
+
+        os
+            << "slave " << int(i.first)
+            << " requests " << slave.requests
+            << " rate " << std::fixed << std::setprecision(1) << slave.requests / seconds << "/s"
+            << " replies " << slave.replies
+            << " exceptions " << slave.exceptions
+            << " no replies " << slave.noReplies
+            << " crc errors " << slave.crcErrors
+            << '\n'
+            << "  turnaround"
+            << " n " << h.count()
+            << " min " << h.min().count()
+            << " mean " << h.mean().count()
+            << " p50 " << h.percentile(0.5).count()
+            << " p99 " << h.percentile(0.99).count()
+            << " max " << h.max().count() << "us\n";
+    }
+    os << std::flush;
+    os.precision(precision);
+    os.flags(flags);
+}
+
+} /* RTU */
+} /* Modbus */
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <ostream>
+
+#include "Timing.h"
+
+namespace Modbus {
+namespace RTU {
+
+/* Passive decoding of bus traffic (monitor sniffer mode).
+ *
+ * Input is received data split into segments by silent interval (3.5t).
+ * Segment is usually single frame, but with coarse receive timing (USB
+ * adapters, pty) or fully loaded line several frames may end up in one
+ * segment - so segment is split further by frame size known from fcode (as
+ * Bus::readRequest()), split is accepted only if CRC of the frame is valid.
+ * Bytes which do not form valid frame are skipped up to next valid frame.
+ *
+ * Frames are paired: frame of slave of pending request with the same fcode
+ * (or its exception) is the reply, any other frame is next request. Request
+ * not followed by its reply is counted as no reply. */
+class Sniffer
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    /* MODBUS over serial line V1.02 - RTU ADU */
+    static constexpr const std::size_t MAX_FRAME_SIZE = 256;
+
+    struct SlaveStats
+    {
+        uint64_t requests{0};
+        uint64_t replies{0};
+        uint64_t exceptions{0};
+        uint64_t noReplies{0};
+        /* replies with invalid CRC */
+        uint64_t crcErrors{0};
+        /* end of request to beginning of reply */
+        Histogram turnaround;
+    };
+
+    struct Stats
+    {
+        uint64_t frames{0};
+        uint64_t bytes{0};
+        /* frames with invalid CRC (or too short) */
+        uint64_t crcErrors{0};
+        uint64_t broadcasts{0};
+        /* valid replies of requests which were not seen */
+        uint64_t unpaired{0};
+    };
+private:
+    struct Pending
+    {
+        uint8_t slave;
+        uint8_t fcode;
+        Clock::time_point end;
+    };
+
+    uSecs charTime_;
+    std::ostream *os_{nullptr};
+    Stats stats_;
+    std::map<uint8_t, SlaveStats> slaves_;
+    bool pending_{false};
+    Pending request_{};
+    Clock::time_point origin_{};
+
+    /* size of valid frame at data (0 - none) */
+    std::size_t validSize(const uint8_t *data, std::size_t size) const;
+    /* slave and fcode (or exception) of pending request */
+    bool matches(const uint8_t *data, std::size_t size) const;
+    void frame(const uint8_t *data, std::size_t size, Clock::time_point begin, Clock::time_point end);
+    /* single line: time since first segment, what, decoded valid frame
+     * (or hex dump), turnaround (if not negative) */
+    void print(
+        const char *what, bool reply,
+        const uint8_t *data, std::size_t size,
+        Clock::time_point timestamp, int64_t turnaround = -1);
+public:
+    /* charTime - wire time of single character (frame timestamps within segment) */
+    explicit Sniffer(uSecs charTime);
+
+    /* decoded frames are written to os (nullptr - stats only) */
+    void output(std::ostream *os) { os_ = os; }
+
+    /* data received between two silent intervals, begin - estimated time of
+     * its first byte on the wire, end - when last byte was received.
+     * Incomplete segment (no silence yet, data keeps coming) is processed
+     * only up to last MAX_FRAME_SIZE bytes - number of bytes processed is
+     * returned, rest is expected again at beginning of next call. */
+    std::size_t segment(
+        const uint8_t *data, std::size_t size,
+        Clock::time_point begin, Clock::time_point end,
+        bool complete = true);
+
+    const Stats &stats() const { return stats_; }
+    const std::map<uint8_t, SlaveStats> &slaves() const { return slaves_; }
+    /* totals and one line per slave, request rate over window */
+    void dump(std::ostream &, Clock::duration window) const;
+
+    /* expected size of complete frame (0 - unknown fcode or header incomplete) */
+    static std::size_t requestSize(const uint8_t *data, std::size_t size);
+    static std::size_t replySize(const uint8_t *data, std::size_t size);
+};
+
+} /* RTU */
+} /* Modbus */
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace Modbus {
+namespace RTU {
+
+/* result of single transaction (request + reply) */
+enum class Status : uint8_t
+{
+    Ok,
+    Request, /* request not (completely) transmitted */
+    Timeout, /* no reply */
+    CRC, /* invalid (or partial) reply */
+    Exception, /* slave replied with exception */
+    Reply /* reply does not match request */
+};
+
+constexpr const std::size_t STATUS_NUM = 6;
+
+inline
+const char *toString(Status status)
+{
+    switch(status)
+    {
+        case Status::Ok: return "ok";
+        case Status::Request: return "request";
+        case Status::Timeout: return "timeout";
+        case Status::CRC: return "crc";
+        case Status::Exception: return "exception";
+        case Status::Reply: return "reply";
+    }
+    return "unknown";
+}
+
+} /* RTU */
+} /* Modbus */
@@ -0,0 +1,319 @@
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <iomanip>
+#include <memory>
+
+#include "Ensure.h"
+#include "TcpPort.h"
+#include "Trace.h"
+#include "TraceLevel.h"
+
+namespace {
+
+constexpr const char *const SCHEME = "tcp://";
+
+void validateSysCallResult(int r)
+{
+    const auto interrupred = -1 == r && EINTR == errno;
+    const auto valid = -1 != r || interrupred;
+    ENSURE(valid, CRuntimeError);
+    if(-1 == r) TRACE(TraceLevel::Trace, strerror(errno));
+}
+
+void setNonBlocking(int fd)
+{
+    const auto flags = ::fcntl(fd, F_GETFL);
+
+    ENSURE(-1 != flags, CRuntimeError);
+    ENSURE(-1 != ::fcntl(fd, F_SETFL, flags | O_NONBLOCK), CRuntimeError);
+}
+
+void setOption(int fd, int level, int name)
+{
+    const int enable = 1;
+
+    ENSURE(-1 != ::setsockopt(fd, level, name, &enable, sizeof(enable)), CRuntimeError);
+}
+
+using AddrInfo = std::unique_ptr<addrinfo, decltype(&::freeaddrinfo)>;
+
+AddrInfo resolve(const std::string &host, uint16_t port, bool passive)
+{
+    addrinfo hints;
+    addrinfo *result = nullptr;
+
+    std::memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_flags = passive ? AI_PASSIVE : 0;
+
+    const auto r =
+        ::getaddrinfo(
+            host.empty() ? nullptr : host.c_str(),
+            std::to_string(port).c_str(),
+            &hints, &result);
+
+    ENSURE(0 == r && result, RuntimeError);
+    return AddrInfo{result, &::freeaddrinfo};
+}
+
+/* wait for single event, false on timeout */
+bool wait(int fd, short event, Transport::mSecs timeout)
+{
+    struct pollfd events = {fd, event, short(0)};
+    const auto r = ::poll(&events, 1, timeout.count());
+
+    validateSysCallResult(r);
+    return 0 < r && (events.revents & (event | POLLERR | POLLHUP));
+}
+
+FdGuard connect(const std::string &host, uint16_t port, Transport::mSecs timeout)
+{
+    const auto info = resolve(host, port, false);
+
+    for(auto i = info.get(); i; i = i->ai_next)
+    {
+        FdGuard fdGuard{::socket(i->ai_family, i->ai_socktype, i->ai_protocol)};
+
+        ENSURE(fdGuard, CRuntimeError);
+        setNonBlocking(fdGuard.fd());
+
+        if(-1 == ::connect(fdGuard.fd(), i->ai_addr, i->ai_addrlen))
+        {
+            if(EINPROGRESS != errno || !wait(fdGuard.fd(), POLLOUT, timeout)) continue;
+
+            int error = 0;
+            socklen_t size = sizeof(error);
+
+            ENSURE(
+                -1 != ::getsockopt(fdGuard.fd(), SOL_SOCKET, SO_ERROR, &error, &size),
+                CRuntimeError);
+            if(0 != error) continue;
+        }
+        return fdGuard;
+    }
+    ENSURE(false && "connection failed", RuntimeError);
+    return FdGuard{-1};
+}
+
+FdGuard connect(const std::string &device, Transport::mSecs timeout)
+{
+    std::string host;
+    uint16_t port;
+
+    TcpPort::parse(device, host, port);
+    return connect(host, port, timeout);
+}
+
+FdGuard listen(const std::string &host, uint16_t port)
+{
+    const auto info = resolve(host, port, true);
+    const auto i = info.get();
+    FdGuard fdGuard{::socket(i->ai_family, i->ai_socktype, i->ai_protocol)};
+
+    ENSURE(fdGuard, CRuntimeError);
+    setOption(fdGuard.fd(), SOL_SOCKET, SO_REUSEADDR);
+    ENSURE(-1 != ::bind(fdGuard.fd(), i->ai_addr, i->ai_addrlen), CRuntimeError);
+    ENSURE(-1 != ::listen(fdGuard.fd(), SOMAXCONN), CRuntimeError);
+    return fdGuard;
+}
+
+FdGuard listen(const std::string &address)
+{
+    const auto colon = address.rfind(':');
+    const auto host = std::string::npos == colon ? std::string{} : address.substr(0, colon);
+    const auto port = std::stoul(std::string::npos == colon ? address : address.substr(colon + 1));
+
+    ENSURE(UINT16_MAX >= port, RuntimeError);
+    return listen(host, uint16_t(port));
+}
+
+void debug(
+    std::ostream *dst,
+    const char *tag,
+    const uint8_t *begin, const uint8_t *const end,
+    const uint8_t *const curr)
+{
+    if(!dst || !debugActive()) return;
+
+    const auto flags = dst->flags();
+
+    (*dst) << tag << " (" << curr - begin << ")";
+    for(auto i = begin; i != curr; ++i)
+    {
+        (*dst) << ' ' << std::hex << std::setw(2) << std::setfill('0') << int(*i);
+    }
+    if(curr == begin && begin != end) (*dst) << " timeout";
+    (*dst) << '\n';
+    dst->flags(flags);
+}
+
+} /* namespace */
+
+TcpPort::TcpPort(FdGuard fdGuard, std::ostream *debugTo):
+    debugTo_{debugTo},
+    fdGuard_{std::move(fdGuard)}
+{
+    ENSURE(fdGuard_, RuntimeError);
+    configure(fdGuard_.fd());
+}
+
+TcpPort::TcpPort(const std::string &host, uint16_t port, mSecs timeout, std::ostream *debugTo):
+    TcpPort{connect(host, port, timeout), debugTo}
+{}
+
+TcpPort::TcpPort(const std::string &device, mSecs timeout, std::ostream *debugTo):
+    TcpPort{connect(device, timeout), debugTo}
+{}
+
+void TcpPort::configure(int fd)
+{
+    setNonBlocking(fd);
+    setOption(fd, IPPROTO_TCP, TCP_NODELAY);
+}
+
+bool TcpPort::isDevice(const std::string &device)
+{
+    return 0 == device.compare(0, std::strlen(SCHEME), SCHEME);
+}
+
+void TcpPort::parse(const std::string &device, std::string &host, uint16_t &port)
+{
+    ENSURE(isDevice(device), RuntimeError);
+
+    const auto address = device.substr(std::strlen(SCHEME));
+    const auto colon = address.rfind(':');
+
+    ENSURE(std::string::npos != colon && 0 < colon, RuntimeError);
+
+    const auto value = std::stoul(address.substr(colon + 1));
+
+    ENSURE(0 < value && UINT16_MAX >= value, RuntimeError);
+    host = address.substr(0, colon);
+    port = uint16_t(value);
+}
+
+uint8_t *TcpPort::read(uint8_t *begin, const uint8_t *const end, mSecs timeout)
+{
+    ENSURE(fdGuard_, RuntimeError);
+    ENSURE(mSecs{0} <= timeout, RuntimeError);
+
+    using namespace std::chrono;
+
+    const auto startTimestamp = Clock::now();
+    mSecs elapsed{0};
+    auto curr = begin;
+
+    firstRxTimestamp_ = Clock::time_point{};
+
+    while(curr != end && timeout >= elapsed)
+    {
+        const auto ready = wait(fdGuard_.fd(), POLLIN, timeout - elapsed);
+
+        elapsed = duration_cast<mSecs>(Clock::now() - startTimestamp);
+        if(!ready) continue;
+
+        const auto r = ::recv(fdGuard_.fd(), curr, end - curr, 0);
+
+        if(-1 == r && (EAGAIN == errno || EWOULDBLOCK == errno)) continue;
+        validateSysCallResult(int(r));
+        ENSURE(0 != r && "connection closed", RuntimeError);
+        if(-1 == r) continue;
+        if(begin == curr) firstRxTimestamp_ = Clock::now();
+        std::advance(curr, r);
+        rxCntr_ += r;
+    }
+
+    debug(debugTo_, __FUNCTION__, begin, end, curr);
+    return curr;
+}
+
+const uint8_t *TcpPort::write(const uint8_t *begin, const uint8_t *const end, mSecs timeout)
+{
+    ENSURE(fdGuard_, RuntimeError);
+    ENSURE(mSecs{0} <= timeout, RuntimeError);
+
+    using namespace std::chrono;
+
+    const auto startTimestamp = Clock::now();
+    mSecs elapsed{0};
+    auto curr = begin;
+
+    while(curr != end && timeout >= elapsed)
+    {
+        /* socket buffer is large enough for any ADU - poll only if it is full */
+        const auto r = ::send(fdGuard_.fd(), curr, end - curr, MSG_NOSIGNAL);
+
+        if(-1 == r && (EAGAIN == errno || EWOULDBLOCK == errno))
+        {
+            wait(fdGuard_.fd(), POLLOUT, timeout - elapsed);
+            elapsed = duration_cast<mSecs>(Clock::now() - startTimestamp);
+            continue;
+        }
+        validateSysCallResult(int(r));
+        if(-1 == r) continue;
+        std::advance(curr, r);
+        txCntr_ += r;
+    }
+
+    debug(debugTo_, __FUNCTION__, begin, end, curr);
+    return curr;
+}
+
+void TcpPort::flush()
+{
+    ENSURE(fdGuard_, RuntimeError);
+
+    uint8_t buf[256];
+
+    for(;;)
+    {
+        const auto r = ::recv(fdGuard_.fd(), buf, sizeof(buf), MSG_DONTWAIT);
+
+        if(-1 == r && (EAGAIN == errno || EWOULDBLOCK == errno)) return;
+        validateSysCallResult(int(r));
+        ENSURE(0 != r && "connection closed", RuntimeError);
+    }
+}
+
+TcpListener::TcpListener(const std::string &host, uint16_t port):
+    fdGuard_{listen(host, port)}
+{}
+
+TcpListener::TcpListener(const std::string &address):
+    fdGuard_{listen(address)}
+{}
+
+uint16_t TcpListener::port() const
+{
+    sockaddr_storage addr;
+    socklen_t size = sizeof(addr);
+
+    ENSURE(
+        -1 != ::getsockname(fdGuard_.fd(), reinterpret_cast<sockaddr *>(&addr), &size),
+        CRuntimeError);
+    if(AF_INET6 == addr.ss_family)
+    {
+        return ntohs(reinterpret_cast<const sockaddr_in6 *>(&addr)->sin6_port);
+    }
+    return ntohs(reinterpret_cast<const sockaddr_in *>(&addr)->sin_port);
+}
+
+FdGuard TcpListener::accept(Transport::mSecs timeout)
+{
+    if(!wait(fdGuard_.fd(), POLLIN, timeout)) return FdGuard{-1};
+
+    const auto fd = ::accept(fdGuard_.fd(), nullptr, nullptr);
+
+    validateSysCallResult(fd);
+    return FdGuard{fd};
+}
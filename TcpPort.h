@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+#include "FdGuard.h"
+#include "Transport.h"
+
+/* Raw RTU frames tunnelled over TCP (serial device servers in "raw socket"
+ * mode). TCP preserves byte order and paces nothing, so Master skips
+ * inter-frame silent interval and drain (see Transport::paced()).
+ * Device name: tcp://host:port */
+class TcpPort: public Transport
+{
+    std::ostream *debugTo_;
+    FdGuard fdGuard_;
+    Clock::time_point firstRxTimestamp_;
+    uint64_t rxCntr_{0};
+    uint64_t txCntr_{0};
+public:
+    /* connected socket */
+    explicit TcpPort(FdGuard, std::ostream * = nullptr);
+    explicit TcpPort(const std::string &device, mSecs timeout, std::ostream * = nullptr);
+    explicit TcpPort(const std::string &host, uint16_t port, mSecs timeout, std::ostream * = nullptr);
+
+    TcpPort(const TcpPort &) = delete;
+    TcpPort &operator=(const TcpPort &) = delete;
+
+    static bool isDevice(const std::string &device);
+    /* non-blocking, without delay (Nagle) - frames are short */
+    static void configure(int fd);
+    /* tcp://host:port -> host, port */
+    static void parse(const std::string &device, std::string &host, uint16_t &port);
+
+    /* connection closed by peer is RuntimeError */
+    uint8_t *read(uint8_t *begin, const uint8_t *const end, mSecs timeout) override;
+    const uint8_t *write(const uint8_t *begin, const uint8_t *const end, mSecs timeout) override;
+    /* written data is handed to kernel, nothing to wait for */
+    void drain() override {}
+    /* discard data already received */
+    void flush() override;
+    Clock::time_point firstRxTimestamp() const override { return firstRxTimestamp_; }
+    void debugTo(std::ostream *dst) override { debugTo_ = dst; }
+    bool paced() const override { return false; }
+
+    int fd() const { return fdGuard_.fd(); }
+    uint64_t rxCntr() const { return rxCntr_; }
+    uint64_t txCntr() const { return txCntr_; }
+};
+
+/* listening socket e.g. simulated device server (see slave_sim -l) */
+class TcpListener
+{
+    FdGuard fdGuard_;
+public:
+    /* port 0 - any free port, see port() */
+    TcpListener(const std::string &host, uint16_t port);
+    /* [host:]port, all interfaces if host is omitted */
+    explicit TcpListener(const std::string &address);
+
+    uint16_t port() const;
+    /* connected socket or invalid FdGuard if timeout expired */
+    FdGuard accept(Transport::mSecs timeout);
+    int fd() const { return fdGuard_.fd(); }
+};
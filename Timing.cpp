@@ -0,0 +1,141 @@
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+
+#include "Timing.h"
+
+namespace Modbus {
+namespace RTU {
+
+std::size_t Histogram::toIndex(uint64_t value)
+{
+    value = std::min(value, (UINT64_C(1) << (MAX_BITS + 1)) - 1);
+
+    if(SUB_NUM > value) return value;
+
+    unsigned msb = 0;
+
+    for(auto v = value; v >>= 1;) ++msb;
+
+    const auto shift = msb - SUB_BITS;
+
+    return SUB_NUM + shift * SUB_NUM + ((value >> shift) - SUB_NUM);
+}
+
+uint64_t Histogram::toValue(std::size_t i)
+{
+    if(SUB_NUM > i) return i;
+
+    const auto shift = (i - SUB_NUM) / SUB_NUM;
+    const auto sub = (i - SUB_NUM) % SUB_NUM;
+
+    return ((SUB_NUM + sub) << shift) + (UINT64_C(1) << shift) - 1;
+}
+
+void Histogram::record(uSecs value)
+{
+    const auto v = uint64_t(std::max<int64_t>(0, value.count()));
+
+    ++buckets_[toIndex(v)];
+    ++count_;
+    sum_ += v;
+    min_ = std::min(min_, v);
+    max_ = std::max(max_, v);
+}
+
+void Histogram::merge(const Histogram &other)
+{
+    for(std::size_t i = 0; i < BUCKET_NUM; ++i) buckets_[i] += other.buckets_[i];
+    count_ += other.count_;
+    sum_ += other.sum_;
+    min_ = std::min(min_, other.min_);
+    max_ = std::max(max_, other.max_);
+}
+
+uSecs Histogram::percentile(double q) const
+{
+    if(!count_) return uSecs{0};
+
+    const auto rank =
+        std::min(count_, std::max(UINT64_C(1), uint64_t(std::ceil(q * double(count_)))));
+    uint64_t acc = 0;
+
+    for(std::size_t i = 0; i < BUCKET_NUM; ++i)
+    {
+        acc += buckets_[i];
+        if(rank <= acc) return uSecs(std::min(toValue(i), max_));
+    }
+    return uSecs(max_);
+}
+
+const char *toString(TimingStats::Phase phase)
+{
+    using Phase = TimingStats::Phase;
+
+    switch(phase)
+    {
+        case Phase::Gap: return "gap";
+        case Phase::Flush: return "flush";
+        case Phase::Write: return "write";
+        case Phase::Drain: return "drain";
+        case Phase::Turnaround: return "turnaround";
+        case Phase::Receive: return "receive";
+        case Phase::CRC: return "crc";
+        case Phase::Total: return "total";
+    }
+    return "unknown";
+}
+
+void TimingStats::record(const Timing &timing)
+{
+    auto &entry = entries_[uint16_t(timing.slave) << 8 | timing.fcode];
+    const uSecs values[PHASE_NUM] =
+    {
+        timing.gap,
+        timing.flush,
+        timing.write,
+        timing.drain,
+        timing.turnaround,
+        timing.receive,
+        timing.crc,
+        timing.total()
+    };
+
+    for(std::size_t i = 0; i < PHASE_NUM; ++i) entry.phases[i].record(values[i]);
+    ++entry.statuses[std::size_t(timing.status)];
+}
+
+void TimingStats::dump(std::ostream &os) const
+{
+    const auto flags = os.flags();
+
+    os << std::dec;
+    for(const auto &i : entries_)
+    {
+        os << "slave " << int(slave(i.first)) << " fcode " << int(fcode(i.first));
+        for(std::size_t j = 0; j < STATUS_NUM; ++j)
+        {
+            if(i.second.statuses[j]) os << ' ' << toString(Status(j)) << ' ' << i.second.statuses[j];
+        }
+        os << '\n';
+
+        for(std::size_t j = 0; j < PHASE_NUM; ++j)
+        {
+            const auto &h = i.second.phases[j];
+
+            os
+                << "  " << std::setw(10) << std::left << toString(Phase(j)) << std::right
+                << " n " << h.count()
+                << " min " << h.min().count()
+                << " mean " << h.mean().count()
+                << " p50 " << h.percentile(0.5).count()
+                << " p99 " << h.percentile(0.99).count()
+                << " max " << h.max().count() << "us\n";
+        }
+    }
+    os << std::flush;
+    os.flags(flags);
+}
+
+} /* RTU */
+} /* Modbus */
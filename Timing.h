@@ -0,0 +1,112 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <ostream>
+
+#include "Status.h"
+
+namespace Modbus {
+namespace RTU {
+
+using uSecs = std::chrono::microseconds;
+
+/* Log-linear (HDR like) histogram of durations (us):
+ * every power of 2 range is split into 2^SUB_BITS equal buckets,
+ * so relative error of reported values is below 1/2^SUB_BITS (~6%).
+ * Fixed size, recording is constant time without allocation. */
+class Histogram
+{
+public:
+    static constexpr const unsigned SUB_BITS = 4;
+    static constexpr const unsigned SUB_NUM = 1u << SUB_BITS;
+    /* values above 2^MAX_BITS us (~67s) are clamped */
+    static constexpr const unsigned MAX_BITS = 26;
+    static constexpr const std::size_t BUCKET_NUM = (MAX_BITS - SUB_BITS + 1) * SUB_NUM + SUB_NUM;
+private:
+    std::array<uint32_t, BUCKET_NUM> buckets_{};
+    uint64_t count_{0};
+    uint64_t sum_{0};
+    uint64_t min_{UINT64_MAX};
+    uint64_t max_{0};
+
+    static std::size_t toIndex(uint64_t value);
+    /* highest value which falls into i-th bucket */
+    static uint64_t toValue(std::size_t i);
+public:
+    void record(uSecs value);
+    void merge(const Histogram &);
+    void clear() { *this = Histogram{}; }
+
+    uint64_t count() const { return count_; }
+    uSecs min() const { return uSecs(count_ ? min_ : 0); }
+    uSecs max() const { return uSecs(max_); }
+    uSecs mean() const { return uSecs(count_ ? sum_ / count_ : 0); }
+    /* q in [0, 1] e.g. 0.99 */
+    uSecs percentile(double q) const;
+};
+
+/* breakdown of single transaction (request + reply) */
+struct Timing
+{
+    uint8_t slave;
+    uint8_t fcode;
+    Status status;
+    /* wait for inter-frame silent interval */
+    uSecs gap;
+    uSecs flush;
+    uSecs write;
+    /* wait until request is transmitted (tcdrain) */
+    uSecs drain;
+    /* end of transmission to first reply byte (slave processing),
+     * whole timeout if there is no reply */
+    uSecs turnaround;
+    /* first to last reply byte */
+    uSecs receive;
+    uSecs crc;
+
+    uSecs total() const { return gap + flush + write + drain + turnaround + receive + crc; }
+};
+
+/* Timing aggregated per slave and fcode */
+class TimingStats
+{
+public:
+    enum class Phase : uint8_t
+    {
+        Gap, Flush, Write, Drain, Turnaround, Receive, CRC, Total
+    };
+
+    static constexpr const std::size_t PHASE_NUM = 8;
+
+    struct Entry
+    {
+        std::array<Histogram, PHASE_NUM> phases;
+        std::array<uint64_t, STATUS_NUM> statuses{};
+
+        const Histogram &operator[](Phase phase) const { return phases[std::size_t(phase)]; }
+    };
+
+    /* key: slave << 8 | fcode */
+    using Entries = std::map<uint16_t, Entry>;
+private:
+    Entries entries_;
+public:
+    void record(const Timing &);
+    void clear() { entries_.clear(); }
+
+    const Entries &entries() const { return entries_; }
+    /* one line per slave/fcode/phase: count, min, mean, p50, p99, max */
+    void dump(std::ostream &) const;
+
+    static uint8_t slave(uint16_t key) { return key >> 8; }
+    static uint8_t fcode(uint16_t key) { return key & 0xFF; }
+};
+
+const char *toString(TimingStats::Phase);
+
+} /* RTU */
+} /* Modbus */
@@ -0,0 +1,19 @@
+#include <atomic>
+
+#include "TraceLevel.h"
+
+namespace {
+
+std::atomic<TraceLevel> activeTraceLevel{TraceLevel::Info};
+
+} /* namespace */
+
+TraceLevel traceLevel()
+{
+    return activeTraceLevel.load(std::memory_order_relaxed);
+}
+
+void traceLevel(TraceLevel level)
+{
+    activeTraceLevel.store(level, std::memory_order_relaxed);
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include "Trace.h"
+
+/* debug output (hex dumps, timing) is compiled out with DISABLE_DEBUG_DUMP
+ * (make NO_DEBUG_DUMP=1), independently of ENABLE_TRACE */
+#ifdef DISABLE_DEBUG_DUMP
+constexpr const bool debugEnabled = false;
+#else
+constexpr const bool debugEnabled = true;
+#endif
+
+/* active trace level (default Info) - debug output is formatted only if
+ * Debug level is active, tools set it with -v */
+TraceLevel traceLevel();
+void traceLevel(TraceLevel);
+
+inline bool debugActive()
+{
+    return debugEnabled && int(TraceLevel::Debug) <= int(traceLevel());
+}
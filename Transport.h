@@ -0,0 +1,39 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <thread>
+
+/* Byte stream between Master and slave(s) together with its time source:
+ * real devices run on wall clock, simulated ones may run on virtual clock
+ * (see VirtualPort) - so Master never calls steady_clock/sleep_for directly. */
+class Transport
+{
+public:
+    using uSecs = std::chrono::microseconds;
+    using mSecs = std::chrono::milliseconds;
+    using Clock = std::chrono::steady_clock;
+
+    virtual ~Transport() = default;
+
+    /* read until [begin, end) is filled or timeout expires,
+     * end of received data is returned */
+    virtual uint8_t *read(uint8_t *begin, const uint8_t *const end, mSecs timeout) = 0;
+    virtual const uint8_t *write(const uint8_t *begin, const uint8_t *const end, mSecs timeout) = 0;
+    /* wait until data written is transmitted */
+    virtual void drain() = 0;
+    /* discard received (and not yet transmitted) data */
+    virtual void flush() = 0;
+    /* when first byte was received by last read() (epoch if nothing was received) */
+    virtual Clock::time_point firstRxTimestamp() const = 0;
+    /* nullptr disables debug output */
+    virtual void debugTo(std::ostream *) {}
+    /* characters are paced by (serial) line: frames are delimited by silent
+     * interval and written data has to be drained before reply is awaited.
+     * Stream transports (e.g. RTU over TCP) frame on their own. */
+    virtual bool paced() const { return true; }
+
+    virtual Clock::time_point now() const { return Clock::now(); }
+    virtual void sleepFor(uSecs duration) { std::this_thread::sleep_for(duration); }
+};
@@ -0,0 +1,174 @@
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <limits>
+
+#include "Ensure.h"
+#include "UnixSocket.h"
+
+namespace UnixSocket {
+namespace {
+
+using Clock = Transport::Clock;
+
+/* no single request/reply comes close to it */
+constexpr const uint32_t MESSAGE_MAX_SIZE = 16 * 1024 * 1024;
+
+sockaddr_un toAddr(const std::string &path)
+{
+    sockaddr_un addr;
+
+    std::memset(&addr, 0, sizeof(addr));
+    ENSURE(!path.empty() && sizeof(addr.sun_path) > path.size(), RuntimeError);
+    addr.sun_family = AF_UNIX;
+    std::memcpy(addr.sun_path, path.c_str(), path.size());
+    return addr;
+}
+
+/* wait for event until deadline, false if it expired */
+bool wait(int fd, short event, Clock::time_point deadline)
+{
+    using namespace std::chrono;
+
+    for(;;)
+    {
+        const auto remaining = duration_cast<mSecs>(deadline - Clock::now());
+
+        if(mSecs{0} > remaining) return false;
+
+        struct pollfd events = {fd, event, short(0)};
+        /* deadline may be time_point::max() - wait without limit */
+        const auto r =
+            ::poll(
+                &events, 1,
+                int(std::min<mSecs::rep>(remaining.count(), std::numeric_limits<int>::max())));
+
+        if(-1 == r && EINTR == errno) continue;
+        ENSURE(-1 != r, CRuntimeError);
+        if(0 < r) return true;
+    }
+}
+
+/* false if connection is closed before anything was read */
+bool read(int fd, uint8_t *begin, uint8_t *const end, Clock::time_point deadline)
+{
+    const auto first = begin;
+
+    while(begin != end)
+    {
+        ENSURE(wait(fd, POLLIN, deadline), RuntimeError);
+
+        const auto r = ::recv(fd, begin, end - begin, 0);
+
+        if(-1 == r && EINTR == errno) continue;
+        ENSURE(-1 != r, CRuntimeError);
+        if(0 == r)
+        {
+            ENSURE(first == begin && "connection closed", RuntimeError);
+            return false;
+        }
+        begin += r;
+    }
+    return true;
+}
+
+void write(int fd, const uint8_t *begin, const uint8_t *const end, Clock::time_point deadline)
+{
+    while(begin != end)
+    {
+        ENSURE(wait(fd, POLLOUT, deadline), RuntimeError);
+
+        const auto r = ::send(fd, begin, end - begin, MSG_NOSIGNAL);
+
+        if(-1 == r && EINTR == errno) continue;
+        ENSURE(-1 != r, CRuntimeError);
+        begin += r;
+    }
+}
+
+} /* namespace */
+
+FdGuard listen(const std::string &path)
+{
+    const auto addr = toAddr(path);
+    struct stat info;
+
+    if(0 == ::stat(path.c_str(), &info) && S_ISSOCK(info.st_mode)) (void)::unlink(path.c_str());
+
+    FdGuard fdGuard{::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0)};
+
+    ENSURE(fdGuard, CRuntimeError);
+    ENSURE(
+        -1 != ::bind(fdGuard.fd(), reinterpret_cast<const sockaddr *>(&addr), sizeof(addr)),
+        CRuntimeError);
+    ENSURE(-1 != ::listen(fdGuard.fd(), SOMAXCONN), CRuntimeError);
+    return fdGuard;
+}
+
+FdGuard connect(const std::string &path)
+{
+    const auto addr = toAddr(path);
+    FdGuard fdGuard{::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0)};
+
+    ENSURE(fdGuard, CRuntimeError);
+    ENSURE(
+        -1 != ::connect(fdGuard.fd(), reinterpret_cast<const sockaddr *>(&addr), sizeof(addr)),
+        CRuntimeError);
+    return fdGuard;
+}
+
+FdGuard accept(int fd, mSecs timeout)
+{
+    if(!wait(fd, POLLIN, Clock::now() + timeout)) return FdGuard{-1};
+
+    const auto r = ::accept4(fd, nullptr, nullptr, SOCK_CLOEXEC);
+
+    if(-1 == r && EINTR == errno) return FdGuard{-1};
+    ENSURE(-1 != r, CRuntimeError);
+    return FdGuard{r};
+}
+
+void send(int fd, const ByteSeq &message, mSecs timeout)
+{
+    ENSURE(MESSAGE_MAX_SIZE >= message.size(), RuntimeError);
+
+    const auto deadline = Clock::now() + timeout;
+    const auto size = uint32_t(message.size());
+    const uint8_t header[] =
+    {
+        uint8_t(size >> 24), uint8_t(size >> 16), uint8_t(size >> 8), uint8_t(size)
+    };
+
+    write(fd, header, header + sizeof(header), deadline);
+    write(fd, message.data(), message.data() + message.size(), deadline);
+}
+
+bool receive(int fd, ByteSeq &message, mSecs timeout, mSecs idle)
+{
+    /* connection may be quiet between messages for any time (negative idle) */
+    ENSURE(
+        wait(fd, POLLIN, mSecs{0} > idle ? Clock::time_point::max() : Clock::now() + idle),
+        RuntimeError);
+
+    const auto deadline = Clock::now() + timeout;
+    uint8_t header[4];
+
+    if(!read(fd, header, header + sizeof(header), deadline)) return false;
+
+    const auto size =
+        uint32_t(header[0]) << 24 | uint32_t(header[1]) << 16
+        | uint32_t(header[2]) << 8 | uint32_t(header[3]);
+
+    ENSURE(MESSAGE_MAX_SIZE >= size, RuntimeError);
+    message.resize(size);
+    ENSURE(read(fd, message.data(), message.data() + message.size(), deadline), RuntimeError);
+    return true;
+}
+
+} /* UnixSocket */
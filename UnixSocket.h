@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "FdGuard.h"
+#include "Transport.h"
+
+/* Unix domain (stream) socket carrying length prefixed messages
+ * (4 bytes, big-endian) e.g. requests to bus_daemon */
+namespace UnixSocket {
+
+using mSecs = Transport::mSecs;
+using ByteSeq = std::vector<uint8_t>;
+
+/* stale socket (left by killed daemon) is removed */
+FdGuard listen(const std::string &path);
+FdGuard connect(const std::string &path);
+/* connected socket or invalid FdGuard if timeout expired */
+FdGuard accept(int fd, mSecs timeout);
+void send(int fd, const ByteSeq &message, mSecs timeout);
+/* false if connection was closed (between messages). Beginning of message is
+ * awaited up to idle (negative - no limit), timeout applies to the message
+ * once it started to arrive */
+bool receive(int fd, ByteSeq &message, mSecs timeout, mSecs idle = mSecs{-1});
+
+} /* UnixSocket */
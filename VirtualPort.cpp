@@ -0,0 +1,119 @@
+#include <algorithm>
+#include <iomanip>
+
+#include "Ensure.h"
+#include "TraceLevel.h"
+#include "VirtualPort.h"
+
+namespace Modbus {
+namespace RTU {
+namespace {
+
+void debug(
+    std::ostream *dst,
+    const char *tag,
+    Transport::Clock::time_point now,
+    const uint8_t *begin, const uint8_t *const end,
+    const uint8_t *const curr)
+{
+    if(!dst || !debugActive()) return;
+
+    using namespace std::chrono;
+
+    const auto flags = dst->flags();
+
+    (*dst) << tag << ' '
+        << duration_cast<microseconds>(now.time_since_epoch()).count() << "us ("
+        << curr - begin << ")";
+    for(auto i = begin; i != curr; ++i)
+    {
+        (*dst) << ' ' << std::hex << std::setw(2) << std::setfill('0') << int(*i);
+    }
+    if(curr == begin && begin != end) (*dst) << " timeout";
+    (*dst) << '\n';
+    dst->flags(flags);
+}
+
+} /* namespace */
+
+VirtualPort::VirtualPort(
+    Bus &bus,
+    BaudRate baudRate, Parity parity, DataBits dataBits, StopBits stopBits)
+    :
+        bus_(bus),
+        charTime_{
+            std::chrono::nanoseconds{
+                uint64_t(1000000000)
+                * SerialPort::bitsPerChar(parity, dataBits, stopBits)
+                / SerialPort::toBitRate(baudRate)}},
+        /* 3.5t, fixed 1750us above 19200bps - as SerialPort::silentInterval() */
+        silentInterval_{
+            19200 < SerialPort::toBitRate(baudRate)
+            ? Clock::duration{uSecs{1750}}
+            : charTime_ * 7 / 2},
+        /* virtual clock starts at 1s - epoch is 'never' for timestamps */
+        now_{std::chrono::seconds{1}},
+        txEnd_{now_}
+{
+}
+
+uint8_t *VirtualPort::read(uint8_t *begin, const uint8_t *const end, mSecs timeout)
+{
+    ENSURE(mSecs{0} <= timeout, RuntimeError);
+
+    const auto deadline = now_ + timeout;
+    auto curr = begin;
+
+    firstRxTimestamp_ = Clock::time_point{};
+    while(curr != end && !rx_.empty() && deadline >= rx_.front().first)
+    {
+        now_ = std::max(now_, rx_.front().first);
+        if(begin == curr) firstRxTimestamp_ = now_;
+        *curr++ = rx_.front().second;
+        rx_.pop_front();
+        ++rxCntr_;
+    }
+    if(curr != end) now_ = deadline;
+
+    debug(debugTo_, __FUNCTION__, now_, begin, end, curr);
+    return curr;
+}
+
+const uint8_t *VirtualPort::write(const uint8_t *begin, const uint8_t *const end, mSecs timeout)
+{
+    ENSURE(mSecs{0} <= timeout, RuntimeError);
+
+    /* characters are queued behind data not transmitted yet (no drain()) */
+    txEnd_ = std::max(now_, txEnd_) + charTime_ * (end - begin);
+    txCntr_ += uint64_t(end - begin);
+
+    /* slave recognizes end of request after silent interval */
+    auto t = txEnd_ + silentInterval_;
+
+    for(const auto &chunk : bus_.process(begin, end, t))
+    {
+        t += chunk.delay;
+        for(auto i = chunk.begin; i != chunk.end; ++i)
+        {
+            t += charTime_;
+            rx_.emplace_back(t, *i);
+        }
+    }
+
+    debug(debugTo_, __FUNCTION__, now_, begin, end, end);
+    return end;
+}
+
+void VirtualPort::drain()
+{
+    now_ = std::max(now_, txEnd_);
+}
+
+void VirtualPort::flush()
+{
+    /* received characters are discarded, the ones still on the wire are not */
+    while(!rx_.empty() && now_ >= rx_.front().first) rx_.pop_front();
+}
+
+} /* RTU */
+} /* Modbus */
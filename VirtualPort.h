@@ -0,0 +1,68 @@
+#pragma once
+
+#include <deque>
+#include <utility>
+
+#include "SerialPort.h"
+#include "Slave.h"
+#include "Transport.h"
+
+namespace Modbus {
+namespace RTU {
+
+/* In-memory Transport on virtual clock, requests are processed by Bus (its
+ * slaves, profiles and faults) without any serial port or thread.
+ * Every character takes wire time of configured character format in both
+ * directions, slave response time, read timeouts and Master inter-frame gaps
+ * only advance the clock - so hours of bus traffic are simulated in
+ * milliseconds and results are deterministic for given Bus seed. */
+class VirtualPort: public Transport
+{
+public:
+    using BaudRate = SerialPort::BaudRate;
+    using Parity = SerialPort::Parity;
+    using DataBits = SerialPort::DataBits;
+    using StopBits = SerialPort::StopBits;
+private:
+    Bus &bus_;
+    /* wire time of single character */
+    Clock::duration charTime_;
+    /* 3.5t - slave detects end of request after it */
+    Clock::duration silentInterval_;
+    Clock::time_point now_;
+    /* end of transmission of data written so far */
+    Clock::time_point txEnd_;
+    Clock::time_point firstRxTimestamp_;
+    /* reply bytes with their arrival time */
+    std::deque<std::pair<Clock::time_point, uint8_t>> rx_;
+    std::ostream *debugTo_{nullptr};
+    uint64_t rxCntr_{0};
+    uint64_t txCntr_{0};
+public:
+    VirtualPort(
+        Bus &bus,
+        BaudRate baudRate = BaudRate::BR_19200,
+        Parity parity = Parity::None,
+        DataBits dataBits = DataBits::Eight,
+        StopBits stopBits = StopBits::One);
+
+    VirtualPort(const VirtualPort &) = delete;
+    VirtualPort &operator=(const VirtualPort &) = delete;
+
+    uint8_t *read(uint8_t *begin, const uint8_t *const end, mSecs timeout) override;
+    const uint8_t *write(const uint8_t *begin, const uint8_t *const end, mSecs timeout) override;
+    void drain() override;
+    void flush() override;
+    Clock::time_point firstRxTimestamp() const override { return firstRxTimestamp_; }
+    void debugTo(std::ostream *dst) override { debugTo_ = dst; }
+
+    Clock::time_point now() const override { return now_; }
+    void sleepFor(uSecs duration) override { now_ += duration; }
+
+    Clock::duration charTime() const { return charTime_; }
+    uint64_t rxCntr() const { return rxCntr_; }
+    uint64_t txCntr() const { return txCntr_; }
+};
+
+} /* RTU */
+} /* Modbus */
@@ -0,0 +1,265 @@
+#include <poll.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <fstream>
+#include <iostream>
+#include <list>
+#include <vector>
+
+#include "Ensure.h"
+#include "Master.h"
+#include "Plan.h"
+#include "TraceLevel.h"
+#include "UnixSocket.h"
+#include "json.h"
+
+namespace {
+
+void help(const char *argv0, const char *message = nullptr)
+{
+    if(message) std::cout << "WARNING: " << message << '\n';
+
+    std::cout
+        << argv0
+        << " -d device"
+        << " -u socket_path"
+        << " [-r rate]"
+        << " [-p parity(O/E/N)]"
+        << " [-c cache_ttl_ms]"
+        << " [-C cache_rules.json]"
+        << " [-v (debug)]"
+        << std::endl;
+}
+
+using namespace Modbus::RTU;
+
+/* request has to arrive completely once it started (client may be idle
+ * between requests for any time) */
+constexpr const mSecs ioTimeout{1000};
+
+volatile std::sig_atomic_t stopRequested = 0;
+volatile std::sig_atomic_t statsRequested = 0;
+
+void onStopSignal(int)
+{
+    stopRequested = 1;
+}
+
+void onStatsSignal(int)
+{
+    statsRequested = 1;
+}
+
+void dumpCacheStats(std::ostream &os, const ReadCache &cache)
+{
+    const auto &stats = cache.stats();
+
+    os
+        << "cache hits " << stats.hits
+        << " misses " << stats.misses
+        << " invalidated " << stats.invalidated << '\n';
+}
+
+/* request: {"format" : "json|cbor|msgpack", "input" : [requests]}
+ * reply: {"output" : [results]} or {"error" : "message"}
+ * (both CBOR encoded - binary values of cbor/msgpack format are preserved),
+ * requests and results are the same as in master_cli batch mode */
+JSON::json execute(Master &master, const JSON::json &request)
+{
+    const auto format = JSON::toFormat(request.at("format").get<std::string>());
+    /* validate and encode all requests before touching the bus */
+    const auto plan = JSON::compile(request.at("input"));
+    Executor executor{master, plan};
+    auto output = JSON::json::array();
+
+    for(std::size_t i = 0; i < plan.size(); ++i)
+    {
+        executor.exec(i);
+        output.push_back(JSON::result(executor, i, format));
+    }
+    return JSON::json{{"output", output}};
+}
+
+/* single request (array of requests) of connection - port is used by it
+ * only for its duration, false if connection was closed */
+bool serve(Master &master, int fd, uint64_t &served, uint64_t &failed)
+{
+    UnixSocket::ByteSeq message;
+
+    if(!UnixSocket::receive(fd, message, ioTimeout)) return false;
+
+    JSON::json reply;
+
+    try
+    {
+        reply = execute(master, JSON::json::from_cbor(message));
+        ++served;
+    }
+    catch(const std::exception &except)
+    {
+        reply = JSON::json{{"error", except.what()}};
+        ++failed;
+    }
+    UnixSocket::send(fd, JSON::json::to_cbor(reply), ioTimeout);
+    return true;
+}
+
+} /* namespace */
+
+int main(int argc, char *argv[])
+{
+    std::string device, path, rate = "19200", parity = "E", rules;
+    long ttl = -1;
+    bool verbose = false;
+
+    for(int c; -1 != (c = ::getopt(argc, argv, "hd:u:r:p:c:C:v"));)
+    {
+        switch(c)
+        {
+            case 'h':
+                help(argv[0]);
+                return EXIT_SUCCESS;
+                break;
+            case 'd':
+                device = optarg ? optarg : "";
+                break;
+            case 'u':
+                path = optarg ? optarg : "";
+                break;
+            case 'r':
+                rate = optarg ? optarg : "";
+                break;
+            case 'p':
+                parity = optarg ? optarg : "";
+                break;
+            case 'c':
+                ttl = optarg ? ::atol(optarg) : 0;
+                break;
+            case 'C':
+                rules = optarg ? optarg : "";
+                break;
+            case 'v':
+                verbose = true;
+                traceLevel(TraceLevel::Debug);
+                break;
+            case ':':
+            case '?':
+            default:
+                help(argv[0], "geopt() failure");
+                return EXIT_FAILURE;
+                break;
+        }
+    }
+
+    if(device.empty() || path.empty())
+    {
+        help(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    try
+    {
+        /* port is opened and configured once, kept open between requests
+         * (reopened by Master after device failure) */
+        Master master
+        {
+            device,
+            toBaudRate(rate),
+            toParity(parity),
+            SerialPort::DataBits::Eight,
+            SerialPort::StopBits::One
+        };
+        const auto listener = UnixSocket::listen(path);
+        uint64_t served = 0, failed = 0;
+        /* reads repeated by clients within TTL are not executed again */
+        ReadCache cache{mSecs{std::max(0l, ttl)}};
+
+        if(!rules.empty())
+        {
+            std::ifstream ifile{rules, std::ios::binary};
+
+            ENSURE(ifile, RuntimeError);
+            JSON::configure(cache, JSON::load(ifile, JSON::Format::JSON));
+        }
+        if(0 <= ttl || !rules.empty()) master.cache(&cache);
+        master.debug(verbose);
+        /* fail early if device can not be opened */
+        (void)master.transport();
+        std::signal(SIGINT, onStopSignal);
+        std::signal(SIGTERM, onStopSignal);
+        std::signal(SIGUSR1, onStatsSignal);
+        std::signal(SIGPIPE, SIG_IGN);
+
+        /* any number of connections (e.g. cron jobs and long lived -s
+         * clients): every round each connection with pending request gets one
+         * request served, so access to the port is serialized per request
+         * and no client is starved */
+        std::list<FdGuard> connections;
+        std::vector<struct pollfd> events;
+
+        while(!stopRequested)
+        {
+            events.assign(1, pollfd{listener.fd(), POLLIN, 0});
+            for(const auto &connection : connections) events.push_back(pollfd{connection.fd(), POLLIN, 0});
+
+            const auto r = ::poll(events.data(), events.size(), 100);
+
+            ENSURE(-1 != r || EINTR == errno, CRuntimeError);
+
+            auto client = std::begin(connections);
+
+            for(std::size_t i = 1; i < events.size(); ++i)
+            {
+                auto open = true;
+
+                if(0 < r && events[i].revents)
+                {
+                    try
+                    {
+                        open = serve(master, client->fd(), served, failed);
+                    }
+                    catch(const std::exception &except)
+                    {
+                        /* client misbehaved (timeout, closed connection) */
+                        TRACE(TraceLevel::Warning, except.what());
+                        open = false;
+                    }
+                }
+                client = open ? std::next(client) : connections.erase(client);
+            }
+
+            if(0 < r && events[0].revents)
+            {
+                auto connection = UnixSocket::accept(listener.fd(), mSecs{0});
+
+                if(connection) connections.push_back(std::move(connection));
+            }
+
+            if(statsRequested)
+            {
+                statsRequested = 0;
+                std::cerr << "served " << served << " failed " << failed << '\n';
+                dumpCacheStats(std::cerr, cache);
+                master.timingStats().dump(std::cerr);
+            }
+        }
+        (void)::unlink(path.c_str());
+        std::cerr << "served " << served << " failed " << failed << '\n';
+        dumpCacheStats(std::cerr, cache);
+    }
+    catch(const std::exception &except)
+    {
+        TRACE(TraceLevel::Error, except.what());
+        return EXIT_FAILURE;
+    }
+    catch(...)
+    {
+        TRACE(TraceLevel::Error, "unsupported exception");
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -1,13 +1,25 @@
 #include <unistd.h>
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <csignal>
 #include <fstream>
 #include <iomanip>
 #include <iostream>
+#include <memory>
+#include <mutex>
+#include <random>
 #include <thread>
 
 #include "Ensure.h"
 #include "Except.h"
 #include "Master.h"
+#include "Plan.h"
+#include "RequestStats.h"
+#include "TcpPort.h"
+#include "Timing.h"
+#include "TraceLevel.h"
 #include "json.h"
 
 void help(const char *argv0, const char *message = nullptr)
@@ -16,57 +28,536 @@ void help(const char *argv0, const char *message = nullptr)
 
     std::cout
         << argv0
-        << " -d device - input.json -t time_window_in_seconds"
+        << " -d device -i input.json [-d device -i input.json ...] -t time_window_in_seconds"
+        << " [-r rate]"
+        << " [-p parity(O/E/N)]"
+        << " [-n number_of_windows]"
+        << " [-q requests_per_second | -u bus_load_percent]"
+        << " [-a arrivals(fixed/poisson)]"
+        << " [-w ramp_up_delay_in_seconds]"
+        << " [-o summary_output]"
+        << " [-f summary_format(json/csv)]"
+        << " [-v (debug)]"
+        << " [-l frame_log.bin]"
         << std::endl;
 }
 
-void exec(const std::string &device, const Modbus::RTU::JSON::json &input, int t)
+/* frame log is dumped on error and on SIGUSR1:
+ * as binary file if -l is given (see flog_dump), as text to stderr otherwise */
+std::string frameLogName;
+/* incremented on every SIGUSR1 - every port dumps its own log */
+std::atomic<unsigned> frameLogRequested{0};
+/* SIGINT/SIGTERM - stop and write summary */
+std::atomic<bool> stopRequested{false};
+/* ports report from their own threads */
+std::mutex outputMutex;
+
+void onFrameLogSignal(int)
+{
+    ++frameLogRequested;
+}
+
+void onStopSignal(int)
+{
+    stopRequested = true;
+}
+
+void dumpFrameLog(const Modbus::RTU::Master &master, const std::string &name)
+{
+    if(name.empty())
+    {
+        std::lock_guard<std::mutex> lock{outputMutex};
+        master.frameLog().dump(std::cerr);
+    }
+    else master.frameLog().store(name);
+}
+
+using RequestStats = Modbus::RTU::RequestStats;
+using Stats = std::vector<RequestStats>;
+using Seconds = std::chrono::duration<double>;
+
+/* single device driven by its own thread with its own script */
+struct Port
+{
+    std::size_t index;
+    std::string device;
+    Modbus::RTU::Plan plan;
+    /* ramp up: port starts after delay, so interference of every
+     * additional port can be observed */
+    std::chrono::steady_clock::duration delay;
+    Stats total;
+    Seconds elapsed{0};
+    std::atomic<uint64_t> completed{0};
+    std::atomic<bool> done{false};
+
+    Port(std::size_t i, std::string dev, Modbus::RTU::Plan p, std::chrono::steady_clock::duration d):
+        index{i},
+        device{std::move(dev)},
+        plan{std::move(p)},
+        delay{d},
+        total(plan.size())
+    {}
+};
+
+using Ports = std::vector<std::unique_ptr<Port>>;
+
+/* number of ports issuing requests right now */
+std::atomic<unsigned> activePorts{0};
+
+constexpr const double PERCENTILES[] = {0.5, 0.9, 0.99, 0.999};
+constexpr const char *const PERCENTILE_NAMES[] = {"p50", "p90", "p99", "p99.9"};
+
+void print(std::ostream &os, const char *name, const Modbus::RTU::Histogram &h)
+{
+    os << ' ' << name;
+    for(std::size_t j = 0; j < std::size(PERCENTILES); ++j)
+    {
+        os << ' ' << PERCENTILE_NAMES[j] << ' ' << h.percentile(PERCENTILES[j]).count();
+    }
+    os << " max " << h.max().count() << "us";
+}
+
+Modbus::RTU::JSON::json toJSON(const Modbus::RTU::Histogram &h)
+{
+    Modbus::RTU::JSON::json output =
+    {
+        {"min", h.min().count()},
+        {"mean", h.mean().count()},
+        {"max", h.max().count()}
+    };
+
+    for(std::size_t j = 0; j < std::size(PERCENTILES); ++j)
+    {
+        output[PERCENTILE_NAMES[j]] = h.percentile(PERCENTILES[j]).count();
+    }
+    return output;
+}
+
+void print(std::ostream &os, const Modbus::RTU::Plan &plan, const Stats &stats, Seconds elapsed)
+{
+    const auto flags = os.flags();
+
+    for(std::size_t i = 0; i < plan.size(); ++i)
+    {
+        const auto &s = stats[i];
+
+        os
+            << "  [" << i << "] slave " << int(plan[i].slave) << " fcode " << int(plan[i].fcode)
+            << " n " << s.latency.count()
+            << " tps " << std::fixed << std::setprecision(1) << double(s.latency.count()) / elapsed.count();
+        print(os, "service", s.latency);
+        os << " retries " << s.retries;
+        for(std::size_t j = 1; j < s.statuses.size(); ++j)
+        {
+            if(s.statuses[j]) os << ' ' << toString(Modbus::RTU::Status(j)) << ' ' << s.statuses[j];
+        }
+        os << "\n     ";
+        print(os, "queue", s.queue);
+        print(os, "response", s.response);
+        os << '\n';
+    }
+    os.flags(flags);
+}
+
+Modbus::RTU::JSON::json toJSON(const Modbus::RTU::Plan &plan, const Stats &stats, Seconds elapsed)
+{
+    using json = Modbus::RTU::JSON::json;
+
+    auto requests = json::array();
+
+    for(std::size_t i = 0; i < plan.size(); ++i)
+    {
+        const auto &s = stats[i];
+        json errors = json::object();
+
+        for(std::size_t j = 1; j < s.statuses.size(); ++j)
+        {
+            errors[toString(Modbus::RTU::Status(j))] = s.statuses[j];
+        }
+
+        requests.push_back(
+            {
+                {"index", i},
+                {"slave", plan[i].slave},
+                {"fcode", plan[i].fcode},
+                {"addr", plan[i].addr},
+                {"count", plan[i].count},
+                {"transactions", s.latency.count()},
+                {"tps", double(s.latency.count()) / elapsed.count()},
+                {"latency_us", toJSON(s.latency)},
+                {"queue_us", toJSON(s.queue)},
+                {"response_us", toJSON(s.response)},
+                {"errors", errors},
+                {"retries", s.retries},
+                {"payload_bytes", s.payload}
+            });
+    }
+    return requests;
+}
+
+/* all requests of all ports */
+RequestStats aggregate(const Ports &ports)
+{
+    RequestStats stats;
+
+    for(const auto &port : ports)
+    {
+        for(const auto &s : port->total) stats.merge(s);
+    }
+    return stats;
+}
+
+void storeJSON(std::ostream &os, const Ports &ports, Seconds elapsed)
+{
+    using json = Modbus::RTU::JSON::json;
+
+    auto output = json::array();
+
+    for(const auto &port : ports)
+    {
+        output.push_back(
+            {
+                {"index", port->index},
+                {"device", port->device},
+                {"duration_s", port->elapsed.count()},
+                {"requests", toJSON(port->plan, port->total, port->elapsed)}
+            });
+    }
+
+    const auto total = aggregate(ports);
+
+    os
+        << json
+        {
+            {"duration_s", elapsed.count()},
+            {"ports", output},
+            {
+                "aggregate",
+                {
+                    {"transactions", total.latency.count()},
+                    {"tps", double(total.latency.count()) / elapsed.count()},
+                    {"latency_us", toJSON(total.latency)},
+                    {"response_us", toJSON(total.response)},
+                    {"errors", total.errors()},
+                    {"retries", total.retries}
+                }
+            }
+        }.dump(2) << std::endl;
+}
+
+void storeCSV(std::ostream &os, const Ports &ports)
+{
+    os << "port,device,index,slave,fcode,addr,count,transactions,tps,min_us,mean_us";
+    for(const auto name : PERCENTILE_NAMES) os << ',' << name << "_us";
+    os << ",max_us";
+    for(const auto name : PERCENTILE_NAMES) os << ",queue_" << name << "_us";
+    os << ",queue_max_us";
+    for(const auto name : PERCENTILE_NAMES) os << ",response_" << name << "_us";
+    os << ",response_max_us,retries,payload_bytes";
+    for(std::size_t j = 1; j < Modbus::RTU::STATUS_NUM; ++j) os << ',' << toString(Modbus::RTU::Status(j));
+    os << '\n';
+
+    for(const auto &port : ports)
+    {
+        const auto &plan = port->plan;
+
+        for(std::size_t i = 0; i < plan.size(); ++i)
+        {
+            const auto &s = port->total[i];
+
+            os
+                << port->index << ',' << port->device
+                << ',' << i << ',' << int(plan[i].slave) << ',' << int(plan[i].fcode)
+                << ',' << plan[i].addr << ',' << plan[i].count
+                << ',' << s.latency.count()
+                << ',' << double(s.latency.count()) / port->elapsed.count()
+                << ',' << s.latency.min().count()
+                << ',' << s.latency.mean().count();
+            for(const auto q : PERCENTILES) os << ',' << s.latency.percentile(q).count();
+            os << ',' << s.latency.max().count();
+            for(const auto q : PERCENTILES) os << ',' << s.queue.percentile(q).count();
+            os << ',' << s.queue.max().count();
+            for(const auto q : PERCENTILES) os << ',' << s.response.percentile(q).count();
+            os << ',' << s.response.max().count() << ',' << s.retries << ',' << s.payload;
+            for(std::size_t j = 1; j < s.statuses.size(); ++j) os << ',' << s.statuses[j];
+            os << '\n';
+        }
+    }
+    os << std::flush;
+}
+
+void store(const std::string &oname, const std::string &format, const Ports &ports, Seconds elapsed)
+{
+    std::ofstream ofile;
+
+    if(!oname.empty() && "-" != oname)
+    {
+        ofile.open(oname);
+        ENSURE(ofile, RuntimeError);
+    }
+
+    std::ostream &os = ofile.is_open() ? ofile : std::cout;
+
+    if("csv" == format) storeCSV(os, ports);
+    else storeJSON(os, ports, elapsed);
+}
+
+uint64_t payloadSize(const Stats &stats)
+{
+    uint64_t size = 0;
+
+    for(const auto &s : stats) size += s.payload;
+    return size;
+}
+
+/* open-loop load: requests are issued at (fixed or Poisson) arrival times
+ * independent of completion of previous ones */
+struct Load
+{
+    enum class Arrivals {Fixed, Poisson};
+
+    /* requests per second, 0 - closed-loop */
+    double rate{0};
+    /* target bus load - wire time + silent intervals (percent), converted to rate */
+    double utilization{0};
+    Arrivals arrivals{Arrivals::Fixed};
+
+    bool openLoop() const { return 0 < rate || 0 < utilization; }
+};
+
+struct Options
+{
+    SerialPort::BaudRate baudRate{SerialPort::BaudRate::BR_19200};
+    SerialPort::Parity parity{SerialPort::Parity::Even};
+    int t{1};
+    int n{0};
+    bool verbose{false};
+    std::string oname;
+    std::string format{"json"};
+    Load load;
+};
+
+/* rate which gives target utilization - based on wire time
+ * of request and reply (plus mandatory silent intervals) of every request in plan */
+double toRate(const SerialPort &dev, const Modbus::RTU::Plan &plan, double utilization)
+{
+    using namespace std::chrono;
+
+    SerialPort::uSecs busy{0};
+
+    for(std::size_t i = 0; i < plan.size(); ++i)
+    {
+        busy += dev.wireTime(plan[i].aduSize + plan[i].repSize) + 2 * dev.silentInterval();
+    }
+    ENSURE(0 < busy.count(), RuntimeError);
+    return utilization / 100.0 * double(plan.size()) / duration_cast<Seconds>(busy).count();
+}
+
+class Schedule
+{
+    std::chrono::steady_clock::duration fixed_;
+    std::exponential_distribution<double> poisson_;
+    std::mt19937_64 gen_{std::random_device{}()};
+    Load::Arrivals arrivals_;
+    std::chrono::steady_clock::time_point next_;
+public:
+    Schedule(double rate, Load::Arrivals arrivals):
+        fixed_{std::chrono::duration_cast<std::chrono::steady_clock::duration>(Seconds{1.0 / rate})},
+        poisson_{rate},
+        arrivals_{arrivals},
+        next_{std::chrono::steady_clock::now()}
+    {}
+
+    /* intended start of next request */
+    std::chrono::steady_clock::time_point next()
+    {
+        using namespace std::chrono;
+
+        const auto curr = next_;
+
+        next_ +=
+            Load::Arrivals::Fixed == arrivals_
+            ? fixed_
+            : duration_cast<steady_clock::duration>(Seconds{poisson_(gen_)});
+        return curr;
+    }
+};
+
+/* dev - nullptr for stream transport (TCP): no line counters */
+void report(
+    std::ostream &os, const Port &port, const SerialPort *dev,
+    const Stats &interval, std::chrono::steady_clock::duration diff)
+{
+    using namespace std::chrono;
+
+    os << "port " << port.index << ' ' << port.device << " (active " << activePorts << ")\n";
+    if(!dev)
+    {
+        print(os, port.plan, interval, duration_cast<Seconds>(diff));
+        return;
+    }
+
+    const auto occupancy = dev->occupancy(diff);
+    const auto window = duration_cast<Seconds>(diff).count();
+    const auto bits = dev->bitsPerChar();
+    const auto wireSize = dev->rxCntr() + dev->txCntr();
+    const auto flags = os.flags();
+
+    os << std::fixed << std::setprecision(0);
+    os << "rx " << double(dev->rxCntr() * bits) / window << "bps";
+    os << " tx " << double(dev->txCntr() * bits) / window << "bps";
+    os << std::setprecision(1);
+    os << " utilization " << occupancy.utilization() << '%';
+    os << " saturation " << occupancy.saturation() << '%';
+    os << " gap " << duration_cast<milliseconds>(occupancy.gap).count() << "ms";
+    os << " idle " << duration_cast<milliseconds>(occupancy.idle).count() << "ms";
+    os << " efficiency " << (wireSize ? 100.0 * double(payloadSize(interval)) / double(wireSize) : 0.0) << '%';
+    os << std::setprecision(4);
+    os << " rx_total " << double(dev->rxTotalCntr() * bits) / (1024 * 1024) << "Mbit";
+    os << " tx_total " << double(dev->txTotalCntr() * bits) / (1024 * 1024) << "Mbit\n";
+    os.flags(flags);
+    print(os, port.plan, interval, duration_cast<Seconds>(diff));
+}
+
+/* drive single port until stopped (or -n windows) */
+void run(Port &port, const Options &options)
 {
     using namespace Modbus;
     using namespace std::chrono;
 
+    const auto &plan = port.plan;
+    const auto &load = options.load;
+    const auto logName =
+        frameLogName.empty() || 0 == port.index
+        ? frameLogName
+        : frameLogName + '.' + std::to_string(port.index);
     auto err = false;
+    auto windowNum = 0;
+    auto frameLogSeen = frameLogRequested.load();
+    Stats interval(plan.size());
+    /* latency of first window and number of ports active at that time,
+     * rise of latency when more ports become active is reported as interference */
+    RTU::uSecs baseline{0};
+    unsigned baselineActive = 0;
+
+    for(auto delay = port.delay; !stopRequested && steady_clock::duration{0} < delay;)
+    {
+        const auto step = std::min<steady_clock::duration>(delay, milliseconds{100});
+
+        std::this_thread::sleep_for(step);
+        delay -= step;
+    }
+
+    const auto startTimestamp = steady_clock::now();
 
-    for(uint64_t i = 0;; ++i)
+    ++activePorts;
+    for(uint64_t i = 0; !stopRequested; ++i)
     {
-        std::cout << "loop " << i << std::endl;
+        {
+            std::lock_guard<std::mutex> lock{outputMutex};
+            std::cout << "port " << port.index << ' ' << port.device << " loop " << i << std::endl;
+        }
         try
         {
-            Modbus::RTU::Master master{device.c_str()};
+            Modbus::RTU::Master master{port.device, options.baudRate, options.parity};
+            master.debug(options.verbose);
+            Modbus::RTU::Executor executor{master, plan};
+            /* line counters (occupancy, -u) - serial device only */
+            auto *const dev = master.transport().paced() ? &master.device() : nullptr;
 
-            auto timestamp = steady_clock::now();
+            const auto rate =
+                0 < load.rate ? load.rate
+                : 0 < load.utilization && dev ? toRate(*dev, plan, load.utilization)
+                : 0.0;
 
-            for(;;)
+            if(load.openLoop())
             {
-                Modbus::RTU::JSON::json output;
+                std::lock_guard<std::mutex> lock{outputMutex};
+                std::cout
+                    << "port " << port.index << ' ' << port.device
+                    << " open-loop " << std::fixed << std::setprecision(1) << rate << "req/s "
+                    << (Load::Arrivals::Fixed == load.arrivals ? "fixed" : "poisson")
+                    << std::defaultfloat << std::endl;
+            }
 
-                for(const auto &data : input)
+            /* arrivals restart after reconnect - backlog is not carried over */
+            std::unique_ptr<Schedule> schedule;
+
+            if(load.openLoop()) schedule = std::make_unique<Schedule>(rate, load.arrivals);
+
+            auto timestamp = steady_clock::now();
+
+            while(!stopRequested)
+            {
+                for(std::size_t j = 0; j < plan.size() && !stopRequested; ++j)
                 {
-                    Modbus::RTU::JSON::dispatch(master, data, output);
+                    auto intended = steady_clock::now();
+
+                    if(schedule)
+                    {
+                        intended = schedule->next();
+                        std::this_thread::sleep_until(intended);
+                    }
 
+                    try
+                    {
+                        exec(master, executor, j, intended, interval[j]);
+                        ++port.completed;
+                    }
+                    catch(...)
+                    {
+                        dumpFrameLog(master, logName);
+                        throw;
+                    }
+
+                    if(frameLogSeen != frameLogRequested)
+                    {
+                        frameLogSeen = frameLogRequested;
+                        dumpFrameLog(master, logName);
+                    }
                     if(err) err = false;
                     /* (silent interval) at least 3.5t character delay ~ 1750us @ 19200bps */
-                    std::this_thread::sleep_for(std::chrono::microseconds(1750));
+                    if(!schedule) std::this_thread::sleep_for(std::chrono::microseconds(1750));
                 }
                 const auto now = steady_clock::now();
                 const auto diff = now - timestamp;
-                const auto diffInS = duration_cast<seconds>(diff);
 
-                if(duration_cast<milliseconds>(diff) > milliseconds{1000 * t})
+                if(duration_cast<milliseconds>(diff) > milliseconds{1000 * options.t})
                 {
-                    const auto flags = std::cout.flags();
-                    std::cout << "rx " << std::fixed << std::setprecision(0) << double(master.device().rxCntr() * 11) / diffInS.count() << "bps";
-                    std::cout << " tx " << std::fixed << std::setprecision(0) << double(master.device().txCntr() * 11) / diffInS.count() << "bps";
-                    std::cout << " rx_total " << std::fixed << std::setprecision(4) << double(master.device().rxTotalCntr() * 11) / (1024 * 1024) << "Mbit";
-                    std::cout << " tx_total " << std::fixed << std::setprecision(4) << double(master.device().txTotalCntr() * 11) / (1024 * 1024) << "Mbit\n";
-                    std::cout.flags(flags);
+                    const auto active = activePorts.load();
+                    RequestStats window;
+
+                    for(const auto &s : interval) window.merge(s);
+
+                    const auto p50 = window.latency.percentile(0.5);
 
+                    std::lock_guard<std::mutex> lock{outputMutex};
+
+                    report(std::cout, port, dev, interval, diff);
+                    if(!baselineActive && window.latency.count())
+                    {
+                        baseline = p50;
+                        baselineActive = active;
+                    }
+                    else if(active > baselineActive && p50 > baseline + baseline / 4)
+                    {
+                        std::cout
+                            << "port " << port.index << ' ' << port.device
+                            << " interference: p50 " << p50.count() << "us with " << active
+                            << " ports active vs. " << baseline.count() << "us with " << baselineActive
+                            << '\n';
+                    }
+                    std::cout << std::flush;
+
+                    for(std::size_t j = 0; j < plan.size(); ++j) port.total[j].merge(interval[j]);
+                    interval.assign(plan.size(), RequestStats{});
                     timestamp = now;
-                    master.device().clearCntrs();
-                }
+                    if(dev) dev->clearCntrs();
 
-                //std::cout << duration_cast<milliseconds>(diff).count() << "ms\n";
+                    if(0 < options.n && options.n <= ++windowNum) break;
+                }
             }
+            if(0 < options.n && options.n <= windowNum) break;
         }
         catch(const RTU::TimeoutError &except)
         {
@@ -86,14 +577,97 @@ void exec(const std::string &device, const Modbus::RTU::JSON::json &input, int t
             break;
         }
     }
+    --activePorts;
+
+    /* partial (last) window */
+    for(std::size_t j = 0; j < plan.size(); ++j) port.total[j].merge(interval[j]);
+    port.elapsed = duration_cast<Seconds>(steady_clock::now() - startTimestamp);
+    port.done = true;
+}
+
+/* every port runs on its own thread, aggregate throughput is reported
+ * every window until all ports are done */
+void exec(Ports &ports, const Options &options)
+{
+    using namespace std::chrono;
+
+    const auto startTimestamp = steady_clock::now();
+    std::vector<std::thread> threads;
+
+    for(auto &port : ports) threads.emplace_back(run, std::ref(*port), std::cref(options));
+
+    uint64_t completed = 0;
+    auto timestamp = startTimestamp;
+
+    for(;;)
+    {
+        std::this_thread::sleep_for(milliseconds{100});
+
+        const auto done =
+            std::all_of(
+                std::begin(ports), std::end(ports),
+                [](const std::unique_ptr<Port> &port) { return bool(port->done); });
+
+        if(done) break;
+
+        const auto now = steady_clock::now();
+        const auto diff = duration_cast<Seconds>(now - timestamp);
+
+        if(1 == ports.size() || diff < seconds{options.t}) continue;
+
+        uint64_t curr = 0;
+
+        for(const auto &port : ports) curr += port->completed;
+
+        std::lock_guard<std::mutex> lock{outputMutex};
+        std::cout
+            << "aggregate active " << activePorts << '/' << ports.size()
+            << " tps " << std::fixed << std::setprecision(1) << double(curr - completed) / diff.count()
+            << std::defaultfloat << std::endl;
+        completed = curr;
+        timestamp = now;
+    }
+
+    for(auto &thread : threads) thread.join();
+
+    const auto elapsed = duration_cast<Seconds>(steady_clock::now() - startTimestamp);
+
+    for(const auto &port : ports)
+    {
+        std::cout
+            << "summary port " << port->index << ' ' << port->device
+            << ' ' << std::fixed << std::setprecision(1) << port->elapsed.count() << "s\n"
+            << std::defaultfloat;
+        print(std::cout, port->plan, port->total, port->elapsed);
+    }
+
+    if(1 < ports.size())
+    {
+        const auto total = aggregate(ports);
+
+        std::cout
+            << "summary aggregate " << ports.size() << " ports "
+            << std::fixed << std::setprecision(1) << elapsed.count() << "s"
+            << " n " << total.latency.count()
+            << " tps " << double(total.latency.count()) / elapsed.count()
+            << std::defaultfloat;
+        print(std::cout, "service", total.latency);
+        print(std::cout, "response", total.response);
+        std::cout << " retries " << total.retries << " errors " << total.errors() << '\n';
+    }
+    std::cout << std::flush;
+
+    if(!options.oname.empty()) store(options.oname, options.format, ports, elapsed);
 }
 
 int main(int argc, char *argv[])
 {
-    std::string device, iname;
-    int t = 1;
+    std::vector<std::string> devices, inames;
+    std::string rate = "19200", parity = "E", arrivals = "fixed";
+    double ramp = 0;
+    Options options;
 
-    for(int c; -1 != (c = ::getopt(argc, argv, "hd:i:t:"));)
+    for(int c; -1 != (c = ::getopt(argc, argv, "hd:i:t:r:p:n:o:f:vl:q:u:a:w:"));)
     {
         switch(c)
         {
@@ -102,13 +676,47 @@ int main(int argc, char *argv[])
                 return EXIT_SUCCESS;
                 break;
             case 'd':
-                device = optarg ? optarg : "";
+                devices.push_back(optarg ? optarg : "");
                 break;
             case 'i':
-                iname = optarg ? optarg : "";
+                inames.push_back(optarg ? optarg : "");
                 break;
             case 't':
-                t = optarg ? ::atoi(optarg) : 1;
+                options.t = optarg ? ::atoi(optarg) : 1;
+                break;
+            case 'r':
+                rate = optarg ? optarg : "";
+                break;
+            case 'p':
+                parity = optarg ? optarg : "";
+                break;
+            case 'n':
+                options.n = optarg ? ::atoi(optarg) : 0;
+                break;
+            case 'o':
+                options.oname = optarg ? optarg : "";
+                break;
+            case 'f':
+                options.format = optarg ? optarg : "";
+                break;
+            case 'v':
+                options.verbose = true;
+                traceLevel(TraceLevel::Debug);
+                break;
+            case 'l':
+                frameLogName = optarg ? optarg : "";
+                break;
+            case 'q':
+                options.load.rate = optarg ? ::atof(optarg) : 0;
+                break;
+            case 'u':
+                options.load.utilization = optarg ? ::atof(optarg) : 0;
+                break;
+            case 'a':
+                arrivals = optarg ? optarg : "";
+                break;
+            case 'w':
+                ramp = optarg ? ::atof(optarg) : 0;
                 break;
             case ':':
             case '?':
@@ -119,22 +727,60 @@ int main(int argc, char *argv[])
         }
     }
 
-    if(device.empty() || iname.empty() || 0 >= t)
+    const auto validDevices =
+        !devices.empty()
+        && std::none_of(std::begin(devices), std::end(devices), [](const std::string &d) { return d.empty(); });
+    /* single script can be shared by all devices */
+    const auto validInputs =
+        (1 == inames.size() || devices.size() == inames.size())
+        && std::none_of(std::begin(inames), std::end(inames), [](const std::string &i) { return i.empty(); });
+
+    if(
+        !validDevices || !validInputs
+        || 0 >= options.t || 0 > options.n || 0 > ramp
+        || ("json" != options.format && "csv" != options.format)
+        || 0 > options.load.rate
+        || 0 > options.load.utilization || 100 < options.load.utilization
+        /* bus load is derived from line settings */
+        || (
+            0 < options.load.utilization
+            && std::any_of(std::begin(devices), std::end(devices), TcpPort::isDevice))
+        || ("fixed" != arrivals && "poisson" != arrivals))
     {
         help(argv[0]);
         return EXIT_FAILURE;
     }
 
+    options.load.arrivals = "poisson" == arrivals ? Load::Arrivals::Poisson : Load::Arrivals::Fixed;
+
     try
     {
-        Modbus::RTU::JSON::json input;
+        options.baudRate = toBaudRate(rate);
+        options.parity = toParity(parity);
 
-        if("-" == iname) std::cin >> input;
-        else std::ifstream(iname) >> input;
+        std::vector<Modbus::RTU::JSON::json> inputs(inames.size());
 
-        ENSURE(input.is_array(), RuntimeError);
+        for(std::size_t i = 0; i < inames.size(); ++i)
+        {
+            if("-" == inames[i]) std::cin >> inputs[i];
+            else std::ifstream(inames[i]) >> inputs[i];
+        }
+
+        Ports ports;
+
+        for(std::size_t i = 0; i < devices.size(); ++i)
+        {
+            ports.push_back(
+                std::make_unique<Port>(
+                    i, devices[i],
+                    Modbus::RTU::JSON::compile(inputs[1 == inputs.size() ? 0 : i]),
+                    std::chrono::duration_cast<std::chrono::steady_clock::duration>(Seconds{ramp * double(i)})));
+        }
 
-        exec(device, input, t);
+        std::signal(SIGUSR1, onFrameLogSignal);
+        std::signal(SIGINT, onStopSignal);
+        std::signal(SIGTERM, onStopSignal);
+        exec(ports, options);
     }
     catch(const std::exception &except)
     {
@@ -0,0 +1,331 @@
+#include <unistd.h>
+
+#include <array>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+#include "Ensure.h"
+#include "Master.h"
+#include "Plan.h"
+#include "Slave.h"
+#include "Timing.h"
+#include "VirtualPort.h"
+#include "json.h"
+
+namespace {
+
+void help(const char *argv0, const char *message = nullptr)
+{
+    if(message) std::cout << "WARNING: " << message << '\n';
+
+    std::cout
+        << argv0
+        << " -i input.json|-"
+        << " [-n transactions_per_rate]"
+        << " [-e error_rates(e.g. 0,0.01,0.1)]"
+        << " [-k faults(flip,drop,truncate,gap,duplicate,echo)]"
+        << " [-g gap_us]"
+        << " [-t turnaround_us]"
+        << " [-r rate]"
+        << " [-s seed]"
+        << " [-V (virtual time)]"
+        << " [-o summary.csv|-]"
+        << std::endl;
+}
+
+using namespace Modbus::RTU;
+using Seconds = std::chrono::duration<double>;
+
+constexpr const double PERCENTILES[] = {0.5, 0.9, 0.99, 0.999};
+constexpr const char *const PERCENTILE_NAMES[] = {"p50", "p90", "p99", "p99.9"};
+
+/* results for single error rate */
+struct Result
+{
+    double rate;
+    uint64_t requests{0};
+    uint64_t ok{0};
+    /* every attempt (including retries) */
+    uint64_t attempts{0};
+    std::array<uint64_t, STATUS_NUM> statuses{};
+    std::array<uint64_t, FAULT_NUM> faults{};
+    /* request start to completion (including retries) of successful requests */
+    Histogram latency;
+    Seconds elapsed{0};
+
+    double tps() const { return elapsed.count() > 0 ? double(ok) / elapsed.count() : 0.0; }
+};
+
+std::vector<std::string> split(const std::string &list)
+{
+    std::vector<std::string> items;
+    std::istringstream is{list};
+
+    for(std::string item; std::getline(is, item, ',');) items.push_back(item);
+    return items;
+}
+
+void measure(Result &result, Master &master, const Plan &plan, uint64_t num)
+{
+    /* transport clock - virtual one advances only with simulated bus time */
+    auto &clock = master.transport();
+    Executor executor{master, plan};
+    const auto begin = clock.now();
+
+    for(uint64_t n = 0; n < num; ++n)
+    {
+        const auto i = n % plan.size();
+        const auto start = clock.now();
+        auto status = Status::Request;
+
+        for(int retry = 0; retry < plan[i].retryNum && Status::Ok != status; ++retry)
+        {
+            status = executor.attempt(i);
+            ++result.attempts;
+            ++result.statuses[std::size_t(status)];
+        }
+
+        ++result.requests;
+        if(Status::Ok == status)
+        {
+            ++result.ok;
+            result.latency.record(std::chrono::duration_cast<uSecs>(clock.now() - start));
+        }
+    }
+
+    result.elapsed = clock.now() - begin;
+}
+
+Result run(
+    const Plan &plan,
+    const Simulator::Profiles &profiles,
+    const Faults &faults,
+    double rate,
+    uint32_t seed,
+    SerialPort::BaudRate baudRate,
+    uint64_t num,
+    bool virtualTime)
+{
+    Result result;
+
+    result.rate = rate;
+
+    /* fresh bus (and device) for every rate - nothing is left in buffers */
+    if(virtualTime)
+    {
+        Bus bus{seed};
+
+        for(const auto &i : profiles) bus.add(Addr{i.first}, i.second);
+        bus.faults(faults);
+
+        VirtualPort port{bus, baudRate};
+        Master master{port};
+
+        measure(result, master, plan, num);
+        for(std::size_t i = 0; i < FAULT_NUM; ++i) result.faults[i] = bus.faultCntr(Fault(i));
+    }
+    else
+    {
+        Simulator sim{profiles, faults, seed, baudRate};
+        Master master{sim.device(), baudRate, SerialPort::Parity::None};
+
+        measure(result, master, plan, num);
+        sim.stop();
+        for(std::size_t i = 0; i < FAULT_NUM; ++i) result.faults[i] = sim.bus().faultCntr(Fault(i));
+    }
+    return result;
+}
+
+void print(std::ostream &os, const Result &result)
+{
+    const auto flags = os.flags();
+    const auto &h = result.latency;
+
+    os
+        << std::fixed << std::setprecision(4)
+        << "rate " << result.rate
+        << std::setprecision(1)
+        << " n " << result.requests
+        << " ok " << (result.requests ? 100.0 * double(result.ok) / double(result.requests) : 0.0) << '%'
+        << " tps " << result.tps()
+        << std::setprecision(2)
+        << " attempts/req " << (result.requests ? double(result.attempts) / double(result.requests) : 0.0)
+        << "\n  latency";
+    for(std::size_t j = 0; j < std::size(PERCENTILES); ++j)
+    {
+        os << ' ' << PERCENTILE_NAMES[j] << ' ' << h.percentile(PERCENTILES[j]).count();
+    }
+    os << " max " << h.max().count() << "us\n  attempts";
+    for(std::size_t j = 0; j < STATUS_NUM; ++j)
+    {
+        if(result.statuses[j]) os << ' ' << toString(Status(j)) << ' ' << result.statuses[j];
+    }
+    os << "\n  injected";
+    for(std::size_t j = 0; j < FAULT_NUM; ++j)
+    {
+        if(result.faults[j]) os << ' ' << toString(Fault(j)) << ' ' << result.faults[j];
+    }
+    os << std::endl;
+    os.flags(flags);
+}
+
+void storeCSV(std::ostream &os, const std::vector<Result> &results)
+{
+    const auto flags = os.flags();
+
+    os << "rate,requests,succeeded,tps,attempts";
+    for(const auto name : PERCENTILE_NAMES) os << ',' << name << "_us";
+    os << ",max_us";
+    for(std::size_t j = 0; j < STATUS_NUM; ++j) os << ',' << toString(Status(j));
+    for(std::size_t j = 0; j < FAULT_NUM; ++j) os << ',' << toString(Fault(j));
+    os << '\n';
+
+    os << std::fixed;
+    for(const auto &result : results)
+    {
+        os
+            << std::setprecision(4) << result.rate << ','
+            << result.requests << ',' << result.ok << ','
+            << std::setprecision(1) << result.tps() << ',' << result.attempts;
+        for(const auto q : PERCENTILES) os << ',' << result.latency.percentile(q).count();
+        os << ',' << result.latency.max().count();
+        for(const auto cntr : result.statuses) os << ',' << cntr;
+        for(const auto cntr : result.faults) os << ',' << cntr;
+        os << '\n';
+    }
+    os << std::flush;
+    os.flags(flags);
+}
+
+} /* namespace */
+
+int main(int argc, char *argv[])
+{
+    std::string iname, oname, rate = "19200";
+    std::string rates = "0,0.001,0.01,0.05,0.1";
+    std::string kinds = "flip,drop,truncate,gap,duplicate,echo";
+    long num = 1000, gap = 2000, turnaround = 0;
+    uint32_t seed = std::mt19937::default_seed;
+    bool virtualTime = false;
+
+    for(int c; -1 != (c = ::getopt(argc, argv, "hi:n:e:k:g:t:r:s:Vo:"));)
+    {
+        switch(c)
+        {
+            case 'h':
+                help(argv[0]);
+                return EXIT_SUCCESS;
+                break;
+            case 'i':
+                iname = optarg ? optarg : "";
+                break;
+            case 'n':
+                num = optarg ? ::atol(optarg) : 0;
+                break;
+            case 'e':
+                rates = optarg ? optarg : "";
+                break;
+            case 'k':
+                kinds = optarg ? optarg : "";
+                break;
+            case 'g':
+                gap = optarg ? ::atol(optarg) : -1;
+                break;
+            case 't':
+                turnaround = optarg ? ::atol(optarg) : -1;
+                break;
+            case 'r':
+                rate = optarg ? optarg : "";
+                break;
+            case 's':
+                seed = optarg ? uint32_t(::atol(optarg)) : seed;
+                break;
+            case 'V':
+                virtualTime = true;
+                break;
+            case 'o':
+                oname = optarg ? optarg : "";
+                break;
+            case ':':
+            case '?':
+            default:
+                help(argv[0], "geopt() failure");
+                return EXIT_FAILURE;
+                break;
+        }
+    }
+
+    if(iname.empty() || 0 >= num || 0 > gap || 0 > turnaround || rates.empty() || kinds.empty())
+    {
+        help(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    try
+    {
+        JSON::json input;
+
+        if("-" == iname) std::cin >> input;
+        else std::ifstream(iname) >> input;
+
+        const auto plan = JSON::compile(input);
+
+        ENSURE(!plan.empty(), RuntimeError);
+
+        /* every slave addressed by input script is simulated */
+        Simulator::Profiles profiles;
+
+        for(std::size_t i = 0; i < plan.size(); ++i)
+        {
+            if(plan[i].slave) profiles[plan[i].slave].turnaround = uSecs{turnaround};
+        }
+
+        Faults faults;
+        std::vector<Fault> selected;
+
+        faults.gap = uSecs{gap};
+        for(const auto &kind : split(kinds)) selected.push_back(toFault(kind));
+
+        std::vector<Result> results;
+
+        for(const auto &r : split(rates))
+        {
+            const auto errorRate = std::stod(r);
+
+            ENSURE(0.0 <= errorRate && 1.0 >= errorRate, RuntimeError);
+            for(const auto fault : selected) faults[fault] = errorRate;
+
+            results.push_back(
+                run(
+                    plan, profiles, faults, errorRate, seed, toBaudRate(rate),
+                    uint64_t(num), virtualTime));
+            print(std::cout, results.back());
+        }
+
+        if(!oname.empty())
+        {
+            if("-" == oname) storeCSV(std::cout, results);
+            else
+            {
+                std::ofstream ofile{oname};
+
+                ENSURE(ofile, RuntimeError);
+                storeCSV(ofile, results);
+            }
+        }
+    }
+    catch(const std::exception &except)
+    {
+        TRACE(TraceLevel::Error, except.what());
+        return EXIT_FAILURE;
+    }
+    catch(...)
+    {
+        TRACE(TraceLevel::Error, "unsupported exception");
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
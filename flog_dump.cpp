@@ -0,0 +1,73 @@
+#include <unistd.h>
+
+#include <fstream>
+#include <iostream>
+
+#include "Ensure.h"
+#include "FrameLog.h"
+
+void help(const char *argv0, const char *message = nullptr)
+{
+    if(message) std::cout << "WARNING: " << message << '\n';
+
+    std::cout
+        << argv0
+        << " -i frame_log.bin|-"
+        << std::endl;
+}
+
+int main(int argc, char *argv[])
+{
+    std::string iname;
+
+    for(int c; -1 != (c = ::getopt(argc, argv, "hi:"));)
+    {
+        switch(c)
+        {
+            case 'h':
+                help(argv[0]);
+                return EXIT_SUCCESS;
+                break;
+            case 'i':
+                iname = optarg ? optarg : "";
+                break;
+            case ':':
+            case '?':
+            default:
+                help(argv[0], "geopt() failure");
+                return EXIT_FAILURE;
+                break;
+        }
+    }
+
+    if(iname.empty())
+    {
+        help(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    try
+    {
+        std::ifstream ifile;
+
+        if("-" != iname)
+        {
+            ifile.open(iname, std::ios::binary);
+            ENSURE(ifile, RuntimeError);
+        }
+
+        Modbus::RTU::FrameLog::decode("-" == iname ? std::cin : ifile, std::cout);
+    }
+    catch(const std::exception &except)
+    {
+        std::cerr << except.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+    catch(...)
+    {
+        std::cerr << "unsupported exception" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
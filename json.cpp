@@ -10,9 +10,11 @@ namespace JSON {
 const char *const ADDR = "addr";
 const char *const COUNT = "count";
 const char *const FCODE = "fcode";
+const char *const INDEX = "index";
 const char *const RETRY = "retry";
 const char *const SLAVE = "slave";
 const char *const TIMEOUT_MS = "timeout_ms";
+const char *const TTL_MS = "ttl_ms";
 const char *const VALUE = "value";
 
 constexpr auto FCODE_RD_COILS = 1;
@@ -31,7 +33,9 @@ bool inRange(V value)
         && std::numeric_limits<T>::max() >= value;
 }
 
-json rdCoils(Master &master, Addr slave, mSecs timeout, const json &input, int retryNum)
+namespace {
+
+int toAddr(const json &input)
 {
     ENSURE(input.count(ADDR), TagMissingError);
     ENSURE(input[ADDR].is_number(), TagFormatError);
@@ -39,35 +43,189 @@ json rdCoils(Master &master, Addr slave, mSecs timeout, const json &input, int r
     const auto addr = input[ADDR].get<int>();
 
     ENSURE(inRange<uint16_t>(addr), TagFormatError);
+    return addr;
+}
 
+template <typename T>
+int toCount(const json &input)
+{
     ENSURE(input.count(COUNT), TagMissingError);
     ENSURE(input[COUNT].is_number(), TagFormatError);
 
     const auto count = input[COUNT].get<int>();
 
-    ENSURE(inRange<uint16_t>(count), TagFormatError);
-    /* this is Modbus V1.1b3 protocol requirement */
-    ENSURE(2001 > count, TagFormatError);
+    ENSURE(inRange<T>(count), TagFormatError);
+    return count;
+}
 
-    Master::DataSeq data;
+/* T - type of single value (uint8_t or uint16_t), used to decode
+ * binary blob (CBOR/MessagePack input) - words are stored in big-endian order */
+template <typename T>
+std::vector<int> toValues(const json &input, int count)
+{
+    ENSURE(input.count(VALUE), TagMissingError);
+
+    ENSURE(input[VALUE].is_array() || input[VALUE].is_binary(), TagFormatError);
 
-    do
+    std::vector<int> value;
+
+    if(input[VALUE].is_binary())
     {
-        const auto warn = [&]()
+        const auto &blob = input[VALUE].get_binary();
+
+        ENSURE(0 == blob.size() % sizeof(T), TagFormatError);
+
+        for(auto i = std::begin(blob); i != std::end(blob); i += sizeof(T))
         {
-            TRACE(
-                TraceLevel::Warning,
-                " failed,"
-                " retryNum ", retryNum,
-                " addr ", slave,
-                " data ", input.dump());
-        };
-        try { data = master.rdCoils(slave, addr, count, timeout); break; }
-        catch(const TimeoutError &) { --retryNum; warn(); if(!retryNum) throw; }
-        catch(const CRCError &) { --retryNum; warn(); if(!retryNum) throw; }
-        catch(const ReplyError &) { --retryNum; warn(); if(!retryNum) throw; }
+            value.push_back(
+                1 == sizeof(T)
+                ? int(*i)
+                : int((uint16_t(*i) << 8) | *std::next(i)));
+        }
+    }
+    else value = input[VALUE].get<std::vector<int>>();
+
+    ENSURE(int(value.size()) == count, TagFormatError);
+    return value;
+}
+
+Addr toSlave(const json &input)
+{
+    ENSURE(input.count(SLAVE), TagMissingError);
+    ENSURE(input[SLAVE].is_number(), TagFormatError);
+
+    const auto slave = input[SLAVE].get<int>();
+
+    ENSURE(inRange<uint8_t>(slave), TagFormatError);
+    return {uint8_t(slave)};
+}
+
+mSecs toTimeout(const json &input)
+{
+    /* default timeout @ 19200bps (default MODBUS RTU rate)
+     * 256 bytes ADU (max size) is transmitted as 2816 bits (11bits / frame)
+     * 11 bits == [start_bit | 8_data_bits | parity_bit | stop_bit]
+     * 1bit takes 52,08us, 256bytes ~ 146666us ~ 147ms
+     * worst case is 256 bytes Request + 256 byte Reply ~ 2x 147ms = 294ms */
+    mSecs timeout{500};
+
+    if(input.count(TIMEOUT_MS))
+    {
+        /* if timeout in milliseconds is provided - use it */
+        ENSURE(input[TIMEOUT_MS].is_number(), TagFormatError);
+
+        const int timeout_ms = input[TIMEOUT_MS].get<int>();
+
+        ENSURE(0 < timeout_ms, TagFormatError);
+
+        timeout = mSecs{timeout_ms};
+    }
+    return timeout;
+}
+
+int toRetryNum(const json &input)
+{
+    auto retryNum = 1;
+
+    if(input.count(RETRY))
+    {
+        ENSURE(input[RETRY].is_number(), TagFormatError);
+
+        const auto retry = input[RETRY].get<int>();
+
+        ENSURE(0 < retry, TagFormatError);
+
+        retryNum = retry;
+    }
+    return retryNum;
+}
+
+int toFCode(const json &input)
+{
+    ENSURE(input.count(FCODE), TagMissingError);
+    ENSURE(input[FCODE].is_number(), TagFormatError);
+
+    return input[FCODE].get<int>();
+}
+
+ReadCache::Space toSpace(int fcode)
+{
+    switch(fcode)
+    {
+        case FCODE_RD_COILS: return ReadCache::Space::Coils;
+        case FCODE_RD_HOLDING_REGISTERS: return ReadCache::Space::Registers;
+        case FCODE_RD_BYTES: return ReadCache::Space::Bytes;
+        default: break;
+    }
+    ENSURE(false && "unsupported fcode", TagFormatError);
+    return ReadCache::Space::Bytes;
+}
+
+/* execute non-throwing request, failed request is repeated up to retryNum
+ * times, if all attempts failed last failure is reported as exception */
+template <typename Request>
+void retry(Request request, int retryNum, Addr slave, mSecs timeout, const json &input)
+{
+    for(;;)
+    {
+        const auto status = request();
+
+        if(Status::Ok == status) return;
+
+        --retryNum;
+        TRACE(
+            TraceLevel::Warning,
+            " failed (", toString(status), "),"
+            " retryNum ", retryNum,
+            " addr ", slave,
+            " data ", input.dump());
+
+        if(!retryNum) ensureOk(status);
         std::this_thread::sleep_for(timeout);
-    } while(retryNum);
+    }
+}
+
+/* replace array of values with binary blob (registers in big-endian order) */
+void toBinary(json &output, int fcode)
+{
+    if(!output.count(VALUE)) return;
+
+    const auto value = output[VALUE].get<std::vector<int>>();
+    json::binary_t blob;
+
+    for(auto i : value)
+    {
+        if(FCODE_RD_HOLDING_REGISTERS == fcode) blob.push_back(uint8_t(i >> 8));
+        blob.push_back(uint8_t(i & 0xFF));
+    }
+    output[VALUE] = json::binary(std::move(blob));
+}
+
+Master::DataSeq toDataSeq(const uint8_t *begin, const uint8_t *const end)
+{
+    Master::DataSeq seq;
+
+    for(; begin != end && std::next(begin) != end; begin += 2)
+    {
+        seq.push_back((uint16_t(*begin) << 8) | *std::next(begin));
+    }
+    return seq;
+}
+
+} /* namespace */
+
+json rdCoils(Master &master, Addr slave, mSecs timeout, const json &input, int retryNum)
+{
+    const auto addr = toAddr(input);
+    const auto count = toCount<uint16_t>(input);
+    /* this is Modbus V1.1b3 protocol requirement */
+    ENSURE(2001 > count, TagFormatError);
+
+    Master::DataSeq data;
+
+    retry(
+        [&]() { return master.tryRdCoils(slave, addr, count, data, timeout); },
+        retryNum, slave, timeout, input);
 
     return json
     {
@@ -80,39 +238,14 @@ json rdCoils(Master &master, Addr slave, mSecs timeout, const json &input, int r
 
 json rdRegisters(Master &master, Addr slave, mSecs timeout, const json &input, int retryNum)
 {
-    ENSURE(input.count(ADDR), TagMissingError);
-    ENSURE(input[ADDR].is_number(), TagFormatError);
-
-    const auto addr = input[ADDR].get<int>();
-
-    ENSURE(inRange<uint16_t>(addr), TagFormatError);
-
-    ENSURE(input.count(COUNT), TagMissingError);
-    ENSURE(input[COUNT].is_number(), TagFormatError);
-
-    const auto count = input[COUNT].get<int>();
-
-    ENSURE(inRange<uint8_t>(count), TagFormatError);
+    const auto addr = toAddr(input);
+    const auto count = toCount<uint8_t>(input);
 
     Master::DataSeq data;
 
-    do
-    {
-        const auto warn = [&]()
-        {
-            TRACE(
-                TraceLevel::Warning,
-                " failed,"
-                " retryNum ", retryNum,
-                " addr ", slave,
-                " data ", input.dump());
-        };
-        try { data = master.rdRegisters(slave, addr, count, timeout); break; }
-        catch(const TimeoutError &) { --retryNum; warn(); if(!retryNum) throw; }
-        catch(const CRCError &) { --retryNum; warn(); if(!retryNum) throw; }
-        catch(const ReplyError &) { --retryNum; warn(); if(!retryNum) throw; }
-        std::this_thread::sleep_for(timeout);
-    } while(retryNum);
+    retry(
+        [&]() { return master.tryRdRegisters(slave, addr, count, data, timeout); },
+        retryNum, slave, timeout, input);
 
     return json
     {
@@ -125,12 +258,7 @@ json rdRegisters(Master &master, Addr slave, mSecs timeout, const json &input, i
 
 json wrCoil(Master &master, Addr slave, mSecs timeout, const json &input, int retryNum)
 {
-    ENSURE(input.count(ADDR), TagMissingError);
-    ENSURE(input[ADDR].is_number(), TagFormatError);
-
-    const auto addr = input[ADDR].get<int>();
-
-    ENSURE(inRange<uint16_t>(addr), TagFormatError);
+    const auto addr = toAddr(input);
 
     ENSURE(input.count(VALUE), TagMissingError);
 
@@ -138,23 +266,9 @@ json wrCoil(Master &master, Addr slave, mSecs timeout, const json &input, int re
 
     const auto value = input[VALUE].get<bool>();
 
-    do
-    {
-        const auto warn = [&]()
-        {
-            TRACE(
-                TraceLevel::Warning,
-                " failed,"
-                " retryNum ", retryNum,
-                " addr ", slave,
-                " data ", input.dump());
-        };
-        try { master.wrCoil(slave, addr, value, timeout); break; }
-        catch(const TimeoutError &) { --retryNum; warn(); if(!retryNum) throw; }
-        catch(const CRCError &) { --retryNum; warn(); if(!retryNum) throw; }
-        catch(const ReplyError &) { --retryNum; warn(); if(!retryNum) throw; }
-        std::this_thread::sleep_for(timeout);
-    } while(retryNum);
+    retry(
+        [&]() { return master.tryWrCoil(slave, addr, value, timeout); },
+        retryNum, slave, timeout, input);
 
     return json
     {
@@ -165,12 +279,7 @@ json wrCoil(Master &master, Addr slave, mSecs timeout, const json &input, int re
 
 json wrRegister(Master &master, Addr slave, mSecs timeout, const json &input, int retryNum)
 {
-    ENSURE(input.count(ADDR), TagMissingError);
-    ENSURE(input[ADDR].is_number(), TagFormatError);
-
-    const auto addr = input[ADDR].get<int>();
-
-    ENSURE(inRange<uint16_t>(addr), TagFormatError);
+    const auto addr = toAddr(input);
 
     ENSURE(input.count(VALUE), TagMissingError);
 
@@ -180,23 +289,9 @@ json wrRegister(Master &master, Addr slave, mSecs timeout, const json &input, in
 
     ENSURE(inRange<uint16_t>(value), TagFormatError);
 
-    do
-    {
-        const auto warn = [&]()
-        {
-            TRACE(
-                TraceLevel::Warning,
-                " failed,"
-                " retryNum ", retryNum,
-                " addr ", slave,
-                " data ", input.dump());
-        };
-        try { master.wrRegister(slave, addr, value, timeout); break; }
-        catch(const TimeoutError &) { --retryNum; warn(); if(!retryNum) throw; }
-        catch(const CRCError &) { --retryNum; warn(); if(!retryNum) throw; }
-        catch(const ReplyError &) { --retryNum; warn(); if(!retryNum) throw; }
-        std::this_thread::sleep_for(timeout);
-    } while(retryNum);
+    retry(
+        [&]() { return master.tryWrRegister(slave, addr, value, timeout); },
+        retryNum, slave, timeout, input);
 
     return json
     {
@@ -207,47 +302,16 @@ json wrRegister(Master &master, Addr slave, mSecs timeout, const json &input, in
 
 json wrRegisters(Master &master, Addr slave, mSecs timeout, const json &input, int retryNum)
 {
-    ENSURE(input.count(ADDR), TagMissingError);
-    ENSURE(input[ADDR].is_number(), TagFormatError);
-
-    const auto addr = input[ADDR].get<int>();
-
-    ENSURE(inRange<uint16_t>(addr), TagFormatError);
-
-    ENSURE(input.count(COUNT), TagMissingError);
-    ENSURE(input[COUNT].is_number(), TagFormatError);
-
-    const auto count = input[COUNT].get<int>();
-
-    ENSURE(inRange<uint8_t>(count), TagFormatError);
-
-    ENSURE(input.count(VALUE), TagMissingError);
-
-    ENSURE(input[VALUE].is_array(), TagFormatError);
+    const auto addr = toAddr(input);
+    const auto count = toCount<uint8_t>(input);
 
-    const auto value = input[VALUE].get<std::vector<int>>();
-
-    ENSURE(int(value.size()) == count, TagFormatError);
+    const auto value = toValues<uint16_t>(input, count);
 
     Master::DataSeq seq(std::begin(value), std::end(value));
 
-    do
-    {
-        const auto warn = [&]()
-        {
-            TRACE(
-                TraceLevel::Warning,
-                " failed,"
-                " retryNum ", retryNum,
-                " addr ", slave,
-                " data ", input.dump());
-        };
-        try { master.wrRegisters(slave, addr, seq, timeout); break; }
-        catch(const TimeoutError &) { --retryNum; warn(); if(!retryNum) throw; }
-        catch(const CRCError &) { --retryNum; warn(); if(!retryNum) throw; }
-        catch(const ReplyError &) { --retryNum; warn(); if(!retryNum) throw; }
-        std::this_thread::sleep_for(timeout);
-    } while(retryNum);
+    retry(
+        [&]() { return master.tryWrRegisters(slave, addr, seq, timeout); },
+        retryNum, slave, timeout, input);
 
     return json
     {
@@ -259,47 +323,16 @@ json wrRegisters(Master &master, Addr slave, mSecs timeout, const json &input, i
 
 json wrBytes(Master &master, Addr slave, mSecs timeout, const json &input, int retryNum)
 {
-    ENSURE(input.count(ADDR), TagMissingError);
-    ENSURE(input[ADDR].is_number(), TagFormatError);
-
-    const auto addr = input[ADDR].get<int>();
-
-    ENSURE(inRange<uint16_t>(addr), TagFormatError);
-
-    ENSURE(input.count(COUNT), TagMissingError);
-    ENSURE(input[COUNT].is_number(), TagFormatError);
-
-    const auto count = input[COUNT].get<int>();
+    const auto addr = toAddr(input);
+    const auto count = toCount<uint8_t>(input);
 
-    ENSURE(inRange<uint8_t>(count), TagFormatError);
-
-    ENSURE(input.count(VALUE), TagMissingError);
-
-    ENSURE(input[VALUE].is_array(), TagFormatError);
-
-    const auto value = input[VALUE].get<std::vector<int>>();
-
-    ENSURE(int(value.size()) == count, TagFormatError);
+    const auto value = toValues<uint8_t>(input, count);
 
     Master::ByteSeq seq(std::begin(value), std::end(value));
 
-    do
-    {
-        const auto warn = [&]()
-        {
-            TRACE(
-                TraceLevel::Warning,
-                " failed,"
-                " retryNum ", retryNum,
-                " addr ", slave,
-                " data ", input.dump());
-        };
-        try { master.wrBytes(slave, addr, seq, timeout); break; }
-        catch(const TimeoutError &) { --retryNum; warn(); if(!retryNum) throw; }
-        catch(const CRCError &) { --retryNum; warn(); if(!retryNum) throw; }
-        catch(const ReplyError &) { --retryNum; warn(); if(!retryNum) throw; }
-        std::this_thread::sleep_for(timeout);
-    } while(retryNum);
+    retry(
+        [&]() { return master.tryWrBytes(slave, addr, seq, timeout); },
+        retryNum, slave, timeout, input);
 
     return json
     {
@@ -311,39 +344,14 @@ json wrBytes(Master &master, Addr slave, mSecs timeout, const json &input, int r
 
 json rdBytes(Master &master, Addr slave, mSecs timeout, const json &input, int retryNum)
 {
-    ENSURE(input.count(ADDR), TagMissingError);
-    ENSURE(input[ADDR].is_number(), TagFormatError);
-
-    const auto addr = input[ADDR].get<int>();
-
-    ENSURE(inRange<uint16_t>(addr), TagFormatError);
-
-    ENSURE(input.count(COUNT), TagMissingError);
-    ENSURE(input[COUNT].is_number(), TagFormatError);
-
-    const auto count = input[COUNT].get<int>();
-
-    ENSURE(inRange<uint8_t>(count), TagFormatError);
+    const auto addr = toAddr(input);
+    const auto count = toCount<uint8_t>(input);
 
     Master::ByteSeq data;
 
-    do
-    {
-        const auto warn = [&]()
-        {
-            TRACE(
-                TraceLevel::Warning,
-                " failed,"
-                " retryNum ", retryNum,
-                " addr ", slave,
-                " data ", input.dump());
-        };
-        try { data = master.rdBytes(slave, addr, count, timeout); break; }
-        catch(const TimeoutError &) { --retryNum; warn(); if(!retryNum) throw; }
-        catch(const CRCError &) { --retryNum; warn(); if(!retryNum) throw; }
-        catch(const ReplyError &) { --retryNum; warn(); if(!retryNum) throw; }
-        std::this_thread::sleep_for(timeout);
-    } while(retryNum);
+    retry(
+        [&]() { return master.tryRdBytes(slave, addr, count, data, timeout); },
+        retryNum, slave, timeout, input);
 
     return json
     {
@@ -354,87 +362,137 @@ json rdBytes(Master &master, Addr slave, mSecs timeout, const json &input, int r
     };
 }
 
-void dispatch(Master &master, const json &input, json &output)
+void dispatch(Master &master, const json &input, json &output, Format format)
 {
-    ENSURE(input.count(SLAVE), TagMissingError);
-    ENSURE(input[SLAVE].is_number(), TagFormatError);
-
-    const auto slave = input[SLAVE].get<int>();
+    const auto slave = toSlave(input);
+    const auto timeout = toTimeout(input);
+    const auto retryNum = toRetryNum(input);
+    const auto fcode = toFCode(input);
 
-    ENSURE(inRange<uint8_t>(slave), TagFormatError);
-
-    /* default timeout @ 19200bps (default MODBUS RTU rate)
-     * 256 bytes ADU (max size) is transmitted as 2816 bits (11bits / frame)
-     * 11 bits == [start_bit | 8_data_bits | parity_bit | stop_bit]
-     * 1bit takes 52,08us, 256bytes ~ 146666us ~ 147ms
-     * worst case is 256 bytes Request + 256 byte Reply ~ 2x 147ms = 294ms */
-    mSecs timeout{500};
-
-    if(input.count(TIMEOUT_MS))
-    {
-        /* if timeout in milliseconds is provided - use it */
-        ENSURE(input[TIMEOUT_MS].is_number(), TagFormatError);
-
-        const int timeout_ms = input[TIMEOUT_MS].get<int>();
-
-        ENSURE(0 < timeout_ms, TagFormatError);
-
-        timeout = mSecs{timeout_ms};
-    }
-
-    auto retryNum = 1;
-
-    if(input.count(RETRY))
+    switch(fcode)
     {
-        ENSURE(input[RETRY].is_number(), TagFormatError);
-
-        const auto retry = input[RETRY].get<int>();
-
-        ENSURE(0 < retry, TagFormatError);
-
-        retryNum = retry;
+        case FCODE_RD_COILS:
+        {
+            output.push_back(rdCoils(master, slave, timeout, input, retryNum));
+            break;
+        }
+        case FCODE_RD_HOLDING_REGISTERS:
+        {
+            output.push_back(rdRegisters(master, slave, timeout, input, retryNum));
+            break;
+        }
+        case FCODE_WR_COIL:
+        {
+            output.push_back(wrCoil(master, slave, timeout, input, retryNum));
+            break;
+        }
+        case FCODE_WR_REGISTER:
+        {
+            output.push_back(wrRegister(master, slave, timeout, input, retryNum));
+            break;
+        }
+        case FCODE_WR_REGISTERS:
+        {
+            output.push_back(wrRegisters(master, slave, timeout, input, retryNum));
+            break;
+        }
+        case FCODE_WR_BYTES:
+        {
+            output.push_back(wrBytes(master, slave, timeout, input, retryNum));
+            break;
+        }
+        case FCODE_RD_BYTES:
+        {
+            output.push_back(rdBytes(master, slave, timeout, input, retryNum));
+            break;
+        }
+        default:
+        {
+            ENSURE(false && "not supported fcode", RuntimeError);
+            break;
+        }
     }
 
-    ENSURE(input.count(FCODE), TagMissingError);
-    ENSURE(input[FCODE].is_number(), TagFormatError);
+    if(Format::JSON != format) toBinary(output.back(), fcode);
+}
 
-    const auto fcode = input[FCODE].get<int>();
+void compile(Plan &plan, const json &input)
+{
+    const auto slave = toSlave(input);
+    const auto timeout = toTimeout(input);
+    const auto retryNum = toRetryNum(input);
+    const auto fcode = toFCode(input);
 
     switch(fcode)
     {
         case FCODE_RD_COILS:
         {
-            output.push_back(rdCoils(master, {uint8_t(slave)}, timeout, input, retryNum));
+            const auto addr = toAddr(input);
+            const auto count = toCount<uint16_t>(input);
+            /* this is Modbus V1.1b3 protocol requirement */
+            ENSURE(2001 > count, TagFormatError);
+            plan.rdCoils(slave, addr, count, timeout, retryNum);
             break;
         }
         case FCODE_RD_HOLDING_REGISTERS:
         {
-            output.push_back(rdRegisters(master, {uint8_t(slave)}, timeout, input, retryNum));
+            const auto addr = toAddr(input);
+            const auto count = toCount<uint8_t>(input);
+            plan.rdRegisters(slave, addr, count, timeout, retryNum);
             break;
         }
         case FCODE_WR_COIL:
         {
-            output.push_back(wrCoil(master, {uint8_t(slave)}, timeout, input, retryNum));
+            const auto addr = toAddr(input);
+
+            ENSURE(input.count(VALUE), TagMissingError);
+            ENSURE(input[VALUE].is_boolean(), TagFormatError);
+
+            plan.wrCoil(slave, addr, input[VALUE].get<bool>(), timeout, retryNum);
             break;
         }
         case FCODE_WR_REGISTER:
         {
-            output.push_back(wrRegister(master, {uint8_t(slave)}, timeout, input, retryNum));
+            const auto addr = toAddr(input);
+
+            ENSURE(input.count(VALUE), TagMissingError);
+            ENSURE(input[VALUE].is_number(), TagFormatError);
+
+            const auto value = input[VALUE].get<int>();
+
+            ENSURE(inRange<uint16_t>(value), TagFormatError);
+            plan.wrRegister(slave, addr, value, timeout, retryNum);
             break;
         }
         case FCODE_WR_REGISTERS:
         {
-            output.push_back(wrRegisters(master, {uint8_t(slave)}, timeout, input, retryNum));
+            const auto addr = toAddr(input);
+            const auto count = toCount<uint8_t>(input);
+            const auto value = toValues<uint16_t>(input, count);
+
+            plan.wrRegisters(
+                slave, addr,
+                Master::DataSeq(std::begin(value), std::end(value)),
+                timeout, retryNum);
             break;
         }
         case FCODE_WR_BYTES:
         {
-            output.push_back(wrBytes(master, {uint8_t(slave)}, timeout, input, retryNum));
+            const auto addr = toAddr(input);
+            const auto count = toCount<uint8_t>(input);
+            const auto value = toValues<uint8_t>(input, count);
+
+            plan.wrBytes(
+                slave, addr,
+                Master::ByteSeq(std::begin(value), std::end(value)),
+                timeout, retryNum);
             break;
         }
         case FCODE_RD_BYTES:
         {
-            output.push_back(rdBytes(master, {uint8_t(slave)}, timeout, input, retryNum));
+            const auto addr = toAddr(input);
+            const auto count = toCount<uint8_t>(input);
+            plan.rdBytes(slave, addr, count, timeout, retryNum);
             break;
         }
         default:
@@ -445,6 +503,170 @@ void dispatch(Master &master, const json &input, json &output)
     }
 }
 
+Plan compile(const json &input)
+{
+    ENSURE(input.is_array(), RuntimeError);
+
+    Plan plan;
+
+    for(const auto &i : input) compile(plan, i);
+    return plan;
+}
+
+void configure(ReadCache &cache, const json &input)
+{
+    ENSURE(input.is_array(), RuntimeError);
+
+    for(const auto &rule : input)
+    {
+        const auto slave = rule.count(SLAVE) ? toSlave(rule).value : uint8_t(0);
+        const auto fcode = toFCode(rule);
+        const auto addr = toAddr(rule);
+        const auto count = toCount<uint16_t>(rule);
+
+        ENSURE(rule.count(TTL_MS), TagMissingError);
+        ENSURE(rule[TTL_MS].is_number(), TagFormatError);
+        ENSURE(0 <= rule[TTL_MS].get<int>(), TagFormatError);
+        ENSURE(0 < count, TagFormatError);
+
+        cache.rule(slave, toSpace(fcode), uint16_t(addr), uint32_t(count), mSecs{rule[TTL_MS].get<int>()});
+    }
+}
+
+namespace {
+
+json toResult(const Executor &executor, std::size_t i)
+{
+    const auto &req = executor.plan()[i];
+
+    switch(req.fcode)
+    {
+        case FCODE_RD_COILS:
+        {
+            return json
+            {
+                {SLAVE, req.slave},
+                {ADDR, req.addr},
+                {COUNT, req.count},
+                {VALUE, Master::DataSeq(executor.dataBegin(i), executor.dataEnd(i))}
+            };
+        }
+        case FCODE_RD_HOLDING_REGISTERS:
+        {
+            return json
+            {
+                {SLAVE, req.slave},
+                {ADDR, req.addr},
+                {COUNT, req.count},
+                {VALUE, toDataSeq(executor.dataBegin(i), executor.dataEnd(i))}
+            };
+        }
+        case FCODE_RD_BYTES:
+        {
+            return json
+            {
+                {SLAVE, req.slave},
+                {ADDR, req.addr},
+                {COUNT, req.count},
+                {VALUE, Master::ByteSeq(executor.dataBegin(i), executor.dataEnd(i))}
+            };
+        }
+        case FCODE_WR_COIL:
+        case FCODE_WR_REGISTER:
+        {
+            return json
+            {
+                {SLAVE, req.slave},
+                {ADDR, req.addr}
+            };
+        }
+        default:
+        {
+            return json
+            {
+                {SLAVE, req.slave},
+                {ADDR, req.addr},
+                {COUNT, req.count}
+            };
+        }
+    }
+}
+
+} /* namespace */
+
+json result(const Executor &executor, std::size_t i, Format format)
+{
+    auto output = toResult(executor, i);
+
+    if(Format::JSON != format) toBinary(output, executor.plan()[i].fcode);
+    return output;
+}
+
+json delta(const Executor &executor, std::size_t i, const std::vector<uint32_t> &index, Format format)
+{
+    const auto &req = executor.plan()[i];
+    const auto *const data = executor.dataBegin(i);
+    std::vector<int> value;
+
+    value.reserve(index.size());
+    for(const auto n : index)
+    {
+        value.push_back(
+            FCODE_RD_HOLDING_REGISTERS == req.fcode
+            ? int((uint16_t(data[n << 1]) << 8) | data[(n << 1) + 1])
+            : int(data[n]));
+    }
+
+    json output
+    {
+        {SLAVE, req.slave},
+        {ADDR, req.addr},
+        {COUNT, req.count},
+        {INDEX, index},
+        {VALUE, value}
+    };
+
+    if(Format::JSON != format) toBinary(output, req.fcode);
+    return output;
+}
+
+Format toFormat(const std::string &format)
+{
+    if("json" == format) return Format::JSON;
+    else if("cbor" == format) return Format::CBOR;
+    else if("msgpack" == format) return Format::MsgPack;
+
+    ENSURE(false && "unsupported format", RuntimeError);
+    return Format::JSON;
+}
+
+json load(std::istream &is, Format format)
+{
+    /* strict == false: single value is consumed, so binary formats
+     * can be read as sequence of values from one stream */
+    switch(format)
+    {
+        case Format::CBOR: return json::from_cbor(is, false);
+        case Format::MsgPack: return json::from_msgpack(is, false);
+        default: break;
+    }
+
+    json input;
+
+    is >> input;
+    return input;
+}
+
+void store(std::ostream &os, const json &output, Format format)
+{
+    switch(format)
+    {
+        case Format::CBOR: json::to_cbor(output, os); break;
+        case Format::MsgPack: json::to_msgpack(output, os); break;
+        default: os << output; break;
+    }
+}
+
 } /* JSON */
 } /* RTU */
 } /* Modbus */
@@ -1,8 +1,14 @@
 #pragma once
 
+#include <istream>
+#include <ostream>
+#include <string>
+
 #include <nlohmann/json.hpp>
 
 #include "Master.h"
+#include "Plan.h"
+#include "ReadCache.h"
 
 namespace Modbus {
 namespace RTU {
@@ -10,6 +16,48 @@ namespace JSON {
 
 using json = nlohmann::json;
 
+/* encoding of input/output, for binary formats (CBOR, MessagePack)
+ * value arrays are emitted as binary blobs (registers in big-endian order) */
+enum class Format
+{
+    JSON, CBOR, MsgPack
+};
+
+Format toFormat(const std::string &);
+json load(std::istream &, Format);
+void store(std::ostream &, const json &, Format);
+
+/* newline delimited JSON: single request per input line (blank lines are
+ * skipped, CRLF line endings accepted), reply of execute(request) is written
+ * as single line and flushed before next request is read.
+ * For binary formats input/output is a sequence of concatenated values. */
+template <typename Execute>
+void stream(std::istream &is, std::ostream &os, Format format, Execute execute)
+{
+    const auto reply =
+        [&os, format](const json &output)
+        {
+            store(os, output, format);
+            if(Format::JSON == format) os << '\n';
+            os << std::flush;
+        };
+
+    if(Format::JSON != format)
+    {
+        while(std::istream::traits_type::eof() != is.peek()) reply(execute(load(is, format)));
+        return;
+    }
+
+    std::string line;
+
+    while(std::getline(is, line))
+    {
+        if(line.find_first_not_of(" \t\r") == std::string::npos) continue;
+
+        reply(execute(json::parse(line)));
+    }
+}
+
 json rdCoils(Master &master, Addr slave, mSecs timeout, const json &input);
 json rdRegisters(Master &master, Addr slave, mSecs timeout, const json &input);
 json wrCoil(Master &master, Addr slave, mSecs timeout, const json &input);
@@ -17,7 +65,22 @@ json wrRegister(Master &master, Addr slave, mSecs timeout, const json &input);
 json wrRegisters(Master &master, Addr slave, mSecs timeout, const json &input);
 json wrBytes(Master &master, Addr slave, mSecs timeout, const json &input);
 json rdBytes(Master &master, Addr slave, mSecs timeout, const json &input);
-void dispatch(Master &master, const json &input, json &output);
+void dispatch(Master &master, const json &input, json &output, Format format = Format::JSON);
+/* validate and encode single request/array of requests,
+ * requests are validated same way as in dispatch() */
+void compile(Plan &plan, const json &input);
+Plan compile(const json &input);
+/* per range TTL rules of read cache (matched in given order):
+ * [{"slave" : 1, "fcode" : 3, "addr" : 0, "count" : 16, "ttl_ms" : 500}, ...]
+ * slave is optional (any slave), fcode is read function of cached space */
+void configure(ReadCache &cache, const json &input);
+/* output of i-th (executed) request, same as produced by dispatch() */
+json result(const Executor &executor, std::size_t i, Format format = Format::JSON);
+/* changed elements of i-th (executed) read (see Delta): same as result() but
+ * "value" holds only elements listed in "index" (positions in full value array) */
+json delta(
+    const Executor &executor, std::size_t i, const std::vector<uint32_t> &index,
+    Format format = Format::JSON);
 
 } /* JSON */
 } /* RTU */
@@ -1,12 +1,19 @@
 #include <unistd.h>
 
+#include <algorithm>
+#include <chrono>
+#include <csignal>
 #include <fstream>
 #include <iomanip>
 #include <iostream>
 #include <thread>
 
+#include "Delta.h"
 #include "Ensure.h"
 #include "Master.h"
+#include "Plan.h"
+#include "TraceLevel.h"
+#include "UnixSocket.h"
 #include "json.h"
 
 void help(const char *argv0, const char *message = nullptr)
@@ -16,19 +23,232 @@ void help(const char *argv0, const char *message = nullptr)
     std::cout
         << argv0
         <<
-            " -d device"
+            " -d device|-u bus_daemon_socket"
             " -i input.json|-"
             " [-o output.json]"
             " [-r rate]"
             " [-p parity(O/E/N)]"
+            " [-s (stream NDJSON)]"
+            " [-L loop_period(ms)]"
+            " [-n cycles(0 - infinite)]"
+            " [-D snapshot_every(cycles, 0 - first only)]"
+            " [-f format(json/cbor/msgpack)]"
+            " [-v (debug)]"
+            " [-l frame_log.bin]"
+            " [-t (timing stats)]"
         << std::endl;
 }
 
+/* frame log is dumped on error and on SIGUSR1:
+ * as binary file if -l is given (see flog_dump), as text to stderr otherwise */
+std::string frameLogName;
+volatile std::sig_atomic_t frameLogRequested = 0;
+
+void onFrameLogSignal(int)
+{
+    frameLogRequested = 1;
+}
+
+void dumpFrameLog(const Modbus::RTU::Master &master)
+{
+    frameLogRequested = 0;
+    if(frameLogName.empty()) master.frameLog().dump(std::cerr);
+    else master.frameLog().store(frameLogName);
+}
+
+void pollFrameLog(const Modbus::RTU::Master &master)
+{
+    if(frameLogRequested) dumpFrameLog(master);
+}
+
+void silentInterval()
+{
+    /* (silent interval) at least 3.5t character delay ~ 1750us @ 19200bps */
+    std::this_thread::sleep_for(std::chrono::microseconds(1750 * 19200/9600));
+}
+
+using Format = Modbus::RTU::JSON::Format;
+
+void batch(Modbus::RTU::Master &master, std::istream &is, const std::string &oname, Format format)
+{
+    const auto input = Modbus::RTU::JSON::load(is, format);
+    auto output = Modbus::RTU::JSON::json::array();
+
+    /* validate and encode all requests before touching the bus */
+    const auto plan = Modbus::RTU::JSON::compile(input);
+
+    Modbus::RTU::Executor executor{master, plan};
+
+    for(std::size_t i = 0; i < plan.size(); ++i)
+    {
+        executor.exec(i);
+        output.push_back(Modbus::RTU::JSON::result(executor, i, format));
+        pollFrameLog(master);
+        silentInterval();
+    }
+
+    if(oname.empty()) Modbus::RTU::JSON::store(std::cout, output, format);
+    else
+    {
+        std::ofstream ofile{oname, std::ios::binary};
+        Modbus::RTU::JSON::store(ofile, output, format);
+    }
+}
+
+/* loop mode: batch is executed cyclically (fixed rate), every cycle is written
+ * as single line (array of results, for binary formats concatenated values).
+ * In delta mode (-D) only changed elements of reads are written (see
+ * JSON::delta(), cycle without changes is skipped) and full results every
+ * snapshot cycles. Failed request (after its retries) does not end the loop,
+ * it is written as {"slave", "addr", "status"} in its cycle (as poller does) */
+void loop(
+    Modbus::RTU::Master &master,
+    std::istream &is, std::ostream &os, Format format,
+    Modbus::RTU::mSecs period, uint64_t cycles, long snapshot)
+{
+    using namespace std::chrono;
+
+    const auto plan = Modbus::RTU::JSON::compile(Modbus::RTU::JSON::load(is, format));
+    Modbus::RTU::Executor executor{master, plan};
+    Modbus::RTU::Delta delta{plan};
+    std::vector<uint32_t> index;
+    auto next = steady_clock::now();
+    uint64_t failed = 0;
+    uint64_t cycle = 0;
+
+    for(; !cycles || cycle < cycles; ++cycle)
+    {
+        const auto full = 0 > snapshot || 0 == cycle || (0 < snapshot && 0 == cycle % uint64_t(snapshot));
+        auto output = Modbus::RTU::JSON::json::array();
+
+        if(full) delta.reset();
+        for(std::size_t i = 0; i < plan.size(); ++i)
+        {
+            const auto status = executor.tryExec(i);
+
+            if(Modbus::RTU::Status::Ok != status)
+            {
+                const auto &req = plan[i];
+
+                ++failed;
+                output.push_back(
+                    Modbus::RTU::JSON::json
+                    {
+                        {"slave", req.slave},
+                        {"addr", req.addr},
+                        {"status", Modbus::RTU::toString(status)}
+                    });
+            }
+            else if(full)
+            {
+                delta.update(executor, i, index);
+                output.push_back(Modbus::RTU::JSON::result(executor, i, format));
+            }
+            else if(delta.update(executor, i, index))
+            {
+                output.push_back(Modbus::RTU::JSON::delta(executor, i, index, format));
+            }
+            pollFrameLog(master);
+            silentInterval();
+        }
+
+        if(!output.empty())
+        {
+            Modbus::RTU::JSON::store(os, output, format);
+            if(Format::JSON == format) os << '\n';
+            os << std::flush;
+        }
+
+        /* cycle overrun starts next one immediately */
+        next = std::max(next + period, steady_clock::now());
+        std::this_thread::sleep_until(next);
+    }
+    std::cerr << "cycles " << cycle << " failed " << failed << '\n';
+}
+
+void stream(Modbus::RTU::Master &master, std::istream &is, std::ostream &os, Format format)
+{
+    Modbus::RTU::JSON::stream(
+        is, os, format,
+        [&master, format](const Modbus::RTU::JSON::json &input)
+        {
+            Modbus::RTU::JSON::json output;
+
+            silentInterval();
+            Modbus::RTU::JSON::dispatch(master, input, output, format);
+            ENSURE(1u == output.size(), RuntimeError);
+            pollFrameLog(master);
+            return output.front();
+        });
+}
+
+/* client of bus_daemon: port is kept open (and configured) by daemon,
+ * requests of concurrent clients are serialized */
+class Remote
+{
+    FdGuard fdGuard_;
+    std::string format_;
+public:
+    Remote(const std::string &path, const std::string &format):
+        fdGuard_{UnixSocket::connect(path)},
+        format_{format}
+    {}
+
+    Modbus::RTU::JSON::json execute(const Modbus::RTU::JSON::json &input)
+    {
+        using json = Modbus::RTU::JSON::json;
+
+        /* daemon may be busy serving other clients */
+        constexpr const UnixSocket::mSecs timeout{60000};
+
+        UnixSocket::send(fdGuard_.fd(), json::to_cbor(json{{"format", format_}, {"input", input}}), timeout);
+
+        UnixSocket::ByteSeq message;
+
+        ENSURE(UnixSocket::receive(fdGuard_.fd(), message, timeout, timeout), RuntimeError);
+
+        const auto reply = json::from_cbor(message);
+
+        /* failure reported by daemon (e.g. timeout) */
+        if(reply.count("error")) std::cerr << reply["error"].get<std::string>() << std::endl;
+        ENSURE(!reply.count("error"), RuntimeError);
+        return reply.at("output");
+    }
+};
+
+void batch(Remote &remote, std::istream &is, const std::string &oname, Format format)
+{
+    const auto output = remote.execute(Modbus::RTU::JSON::load(is, format));
+
+    if(oname.empty()) Modbus::RTU::JSON::store(std::cout, output, format);
+    else
+    {
+        std::ofstream ofile{oname, std::ios::binary};
+        Modbus::RTU::JSON::store(ofile, output, format);
+    }
+}
+
+void stream(Remote &remote, std::istream &is, std::ostream &os, Format format)
+{
+    Modbus::RTU::JSON::stream(
+        is, os, format,
+        [&remote](const Modbus::RTU::JSON::json &input)
+        {
+            /* single request - daemon expects array */
+            const auto output = remote.execute(Modbus::RTU::JSON::json::array({input}));
+
+            ENSURE(1u == output.size(), RuntimeError);
+            return output.front();
+        });
+}
+
 int main(int argc, char *argv[])
 {
-    std::string device, iname, oname, rate = "19200", parity = "E";
+    std::string device, socket, iname, oname, rate = "19200", parity = "E", format = "json";
+    bool ndjson = false, verbose = false, timingStats = false;
+    long period = -1, cycles = 0, snapshot = -1;
 
-    for(int c; -1 != (c = ::getopt(argc, argv, "hd:i:o:r:p:"));)
+    for(int c; -1 != (c = ::getopt(argc, argv, "hd:u:i:o:r:p:sL:n:D:f:vl:t"));)
     {
         switch(c)
         {
@@ -39,6 +259,9 @@ int main(int argc, char *argv[])
             case 'd':
                 device = optarg ? optarg : "";
                 break;
+            case 'u':
+                socket = optarg ? optarg : "";
+                break;
             case 'i':
                 iname = optarg ? optarg : "";
                 break;
@@ -51,6 +274,31 @@ int main(int argc, char *argv[])
             case 'p':
                 parity = optarg ? optarg : "";
                 break;
+            case 's':
+                ndjson = true;
+                break;
+            case 'L':
+                period = optarg ? ::atol(optarg) : 0;
+                break;
+            case 'n':
+                cycles = optarg ? ::atol(optarg) : 0;
+                break;
+            case 'D':
+                snapshot = optarg ? ::atol(optarg) : 0;
+                break;
+            case 'f':
+                format = optarg ? optarg : "";
+                break;
+            case 'v':
+                verbose = true;
+                traceLevel(TraceLevel::Debug);
+                break;
+            case 'l':
+                frameLogName = optarg ? optarg : "";
+                break;
+            case 't':
+                timingStats = true;
+                break;
             case ':':
             case '?':
             default:
@@ -60,7 +308,13 @@ int main(int argc, char *argv[])
         }
     }
 
-    if(device.empty() || iname.empty())
+    /* loop mode executes batch, locally only */
+    const auto looping = 0 <= period;
+
+    if(
+        device.empty() == socket.empty() || iname.empty()
+        || (looping && (!socket.empty() || ndjson || 0 > cycles))
+        || (!looping && 0 <= snapshot))
     {
         help(argv[0]);
         return EXIT_FAILURE;
@@ -68,12 +322,35 @@ int main(int argc, char *argv[])
 
     try
     {
-        Modbus::RTU::JSON::json input, output;
+        const auto ioFormat = Modbus::RTU::JSON::toFormat(format);
+        std::ifstream ifile;
 
-        if("-" == iname) std::cin >> input;
-        else std::ifstream(iname) >> input;
+        if("-" != iname)
+        {
+            ifile.open(iname, std::ios::binary);
+            ENSURE(ifile, RuntimeError);
+        }
 
-        ENSURE(input.is_array(), RuntimeError);
+        std::istream &is = "-" == iname ? std::cin : ifile;
+
+        if(!socket.empty())
+        {
+            Remote remote{socket, format};
+
+            if(ndjson)
+            {
+                std::ofstream ofile;
+
+                if(!oname.empty())
+                {
+                    ofile.open(oname, std::ios::binary);
+                    ENSURE(ofile, RuntimeError);
+                }
+                stream(remote, is, oname.empty() ? std::cout : ofile, ioFormat);
+            }
+            else batch(remote, is, oname, ioFormat);
+            return EXIT_SUCCESS;
+        }
 
         Modbus::RTU::Master master
         {
@@ -84,15 +361,35 @@ int main(int argc, char *argv[])
             SerialPort::StopBits::One
         };
 
-        for(const auto &i : input)
+        master.debug(verbose);
+        std::signal(SIGUSR1, onFrameLogSignal);
+
+        try
         {
-            Modbus::RTU::JSON::dispatch(master, i, output);
-            /* (silent interval) at least 3.5t character delay ~ 1750us @ 19200bps */
-            std::this_thread::sleep_for(std::chrono::microseconds(1750 * 19200/9600));
-        }
+            if(ndjson || looping)
+            {
+                std::ofstream ofile;
 
-        if(oname.empty()) std::cout << output;
-        else std::ofstream{oname} << output;
+                if(!oname.empty())
+                {
+                    ofile.open(oname, std::ios::binary);
+                    ENSURE(ofile, RuntimeError);
+                }
+
+                auto &os = oname.empty() ? std::cout : ofile;
+
+                if(looping) loop(master, is, os, ioFormat, Modbus::RTU::mSecs{period}, uint64_t(cycles), snapshot);
+                else stream(master, is, os, ioFormat);
+            }
+            else batch(master, is, oname, ioFormat);
+        }
+        catch(...)
+        {
+            dumpFrameLog(master);
+            if(timingStats) master.timingStats().dump(std::cerr);
+            throw;
+        }
+        if(timingStats) master.timingStats().dump(std::cerr);
     }
     catch(const std::exception &except)
     {
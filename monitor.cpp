@@ -1,13 +1,20 @@
+#include <poll.h>
 #include <unistd.h>
 
+#include <cerrno>
+#include <csignal>
 #include <fstream>
 #include <iomanip>
 #include <iostream>
 #include <iterator>
+#include <memory>
 #include <thread>
+#include <vector>
 
+#include "Capture.h"
 #include "Ensure.h"
 #include "Master.h"
+#include "Sniffer.h"
 #include "json.h"
 
 namespace {
@@ -18,8 +25,13 @@ void help(const char *argv0, const char *message = nullptr)
 
     std::cout
         << argv0
-        << " -d device"
-        << " -t (ASCII only)"
+        << " -d device|-i capture.bin"
+        << " [-t (ASCII only)]"
+        << " [-s (sniffer - decoded frames)]"
+        << " [-q (sniffer statistics only)]"
+        << " [-w capture.bin (sniffer, raw data with timestamps)]"
+        << " [-r rate]"
+        << " [-p parity(O/E/N)]"
         << std::endl;
 }
 
@@ -62,7 +74,20 @@ void dump(std::ostream &os, const uint8_t *begin, const uint8_t *const end)
     os << '\n';
 }
 
-void exec(const std::string &device, bool hex)
+volatile std::sig_atomic_t stopRequested = 0;
+volatile std::sig_atomic_t statsRequested = 0;
+
+void onStopSignal(int)
+{
+    stopRequested = 1;
+}
+
+void onStatsSignal(int)
+{
+    statsRequested = 1;
+}
+
+void exec(const std::string &device, SerialPort::BaudRate baudRate, SerialPort::Parity parity, bool hex)
 {
     using namespace Modbus;
     using namespace std::chrono;
@@ -74,8 +99,8 @@ void exec(const std::string &device, bool hex)
         SerialPort serialPort
         {
             device,
-            SerialPort::BaudRate::BR_19200,
-            SerialPort::Parity::Even,
+            baudRate,
+            parity,
             SerialPort::DataBits::Eight,
             SerialPort::StopBits::One,
             &debugBuf
@@ -123,14 +148,166 @@ void exec(const std::string &device, bool hex)
     }
 }
 
+/* Received chunks are collected into segment until silent interval (3.5t),
+ * segment is passed to Sniffer. Without silence (fully loaded line) frames
+ * received so far are processed once segment is long enough. */
+class Segmenter
+{
+    using Clock = Modbus::RTU::Sniffer::Clock;
+
+    Modbus::RTU::Sniffer &sniffer_;
+    Modbus::RTU::uSecs charTime_;
+    Modbus::RTU::uSecs silence_;
+    std::vector<uint8_t> segment_;
+    Clock::time_point begin_;
+    Clock::time_point last_;
+public:
+    Segmenter(Modbus::RTU::Sniffer &sniffer, Modbus::RTU::uSecs charTime, Modbus::RTU::uSecs silence):
+        sniffer_{sniffer},
+        charTime_{charTime},
+        silence_{silence}
+    {
+        segment_.reserve(4 * Modbus::RTU::Sniffer::MAX_FRAME_SIZE);
+    }
+
+    bool empty() const { return segment_.empty(); }
+
+    /* chunk read at now */
+    void add(const uint8_t *data, std::size_t size, Clock::time_point now)
+    {
+        /* first byte of chunk was on the wire before whole chunk was received */
+        const auto first = std::max(last_, now - charTime_ * int64_t(size));
+
+        if(!segment_.empty() && first - last_ >= silence_) complete();
+        if(segment_.empty()) begin_ = first;
+        segment_.insert(std::end(segment_), data, data + size);
+        last_ = now;
+
+        if(2 * Modbus::RTU::Sniffer::MAX_FRAME_SIZE < segment_.size())
+        {
+            const auto done = sniffer_.segment(segment_.data(), segment_.size(), begin_, last_, false);
+
+            segment_.erase(std::begin(segment_), std::next(std::begin(segment_), done));
+            begin_ += charTime_ * int64_t(done);
+        }
+    }
+
+    /* silent interval (or end of data) */
+    void complete()
+    {
+        if(!segment_.empty()) sniffer_.segment(segment_.data(), segment_.size(), begin_, last_);
+        segment_.clear();
+    }
+};
+
+/* Bytes are read as soon as they arrive (poll) and stored into capture
+ * (if any) as read. Output is buffered and flushed when bus is idle, so
+ * decoding keeps up with fully loaded line (115200bps is ~11.5kB/s, kernel
+ * buffers 4kB at least). */
+void sniff(
+    const std::string &device, SerialPort::BaudRate baudRate, SerialPort::Parity parity,
+    const std::string &cname, bool quiet)
+{
+    using namespace Modbus::RTU;
+    using namespace std::chrono;
+
+    SerialPort serialPort
+    {
+        device,
+        baudRate,
+        parity,
+        SerialPort::DataBits::Eight,
+        SerialPort::StopBits::One,
+        nullptr
+    };
+    const auto silence = serialPort.silentInterval();
+    const auto idle = duration_cast<nanoseconds>(mSecs{100});
+    Sniffer sniffer{serialPort.wireTime(1)};
+    Segmenter segmenter{sniffer, serialPort.wireTime(1), silence};
+    std::unique_ptr<CaptureWriter> capture;
+    std::vector<uint8_t> buffer(4096, uint8_t{0});
+    const auto start = SerialPort::Clock::now();
+    struct pollfd events{serialPort.fd(), short(POLLIN), short(0)};
+
+    if(!cname.empty())
+    {
+        capture =
+            std::make_unique<CaptureWriter>(
+                cname, serialPort.bitRate(), uint8_t(serialPort.bitsPerChar()));
+    }
+    if(!quiet) sniffer.output(&std::cout);
+
+    while(!stopRequested)
+    {
+        const auto timeout = duration_cast<nanoseconds>(segmenter.empty() ? idle : silence);
+        const struct timespec ts{time_t(timeout.count() / 1000000000), long(timeout.count() % 1000000000)};
+        const auto r = ::ppoll(&events, 1, &ts, nullptr);
+
+        if(-1 == r && EINTR == errno) continue;
+        ENSURE(-1 != r, CRuntimeError);
+
+        if(statsRequested)
+        {
+            statsRequested = 0;
+            sniffer.dump(std::cerr, SerialPort::Clock::now() - start);
+        }
+
+        if(0 == r)
+        {
+            if(segmenter.empty()) std::cout << std::flush;
+            segmenter.complete();
+            continue;
+        }
+
+        const auto n = ::read(serialPort.fd(), buffer.data(), buffer.size());
+
+        if(-1 == n && (EAGAIN == errno || EINTR == errno)) continue;
+        /* hangup e.g. replay finished */
+        if(0 == n || (-1 == n && EIO == errno)) break;
+        ENSURE(0 < n, CRuntimeError);
+
+        const auto now = SerialPort::Clock::now();
+
+        if(capture) capture->write(now, buffer.data(), buffer.data() + n);
+        segmenter.add(buffer.data(), std::size_t(n), now);
+    }
+    segmenter.complete();
+    std::cout << std::flush;
+    sniffer.dump(std::cerr, SerialPort::Clock::now() - start);
+}
+
+/* offline decoding of capture (monitor -w) with its original timing */
+void sniff(const std::string &iname, bool quiet)
+{
+    using namespace Modbus::RTU;
+
+    CaptureReader capture{iname};
+    const auto &header = capture.header();
+    Sniffer sniffer{header.charTime()};
+    Segmenter segmenter{sniffer, header.charTime(), header.silentInterval()};
+    CaptureReader::Chunk chunk;
+    Sniffer::Clock::duration last{0};
+
+    if(!quiet) sniffer.output(&std::cout);
+
+    while(!stopRequested && capture.next(chunk))
+    {
+        last = std::chrono::nanoseconds{chunk.timestamp};
+        segmenter.add(chunk.data, chunk.size, Sniffer::Clock::time_point{} + last);
+    }
+    segmenter.complete();
+    std::cout << std::flush;
+    sniffer.dump(std::cerr, last);
+}
+
 } /* namespace */
 
 int main(int argc, char *argv[])
 {
-    std::string device;
-    bool hex = true;
+    std::string device, iname, cname, rate = "19200", parity = "E";
+    bool hex = true, sniffer = false, quiet = false;
 
-    for(int c; -1 != (c = ::getopt(argc, argv, "htd:"));)
+    for(int c; -1 != (c = ::getopt(argc, argv, "htsqd:i:w:r:p:"));)
     {
         switch(c)
         {
@@ -144,6 +321,26 @@ int main(int argc, char *argv[])
             case 't':
                 hex = false;
                 break;
+            case 's':
+                sniffer = true;
+                break;
+            case 'q':
+                sniffer = true;
+                quiet = true;
+                break;
+            case 'i':
+                iname = optarg ? optarg : "";
+                break;
+            case 'w':
+                cname = optarg ? optarg : "";
+                sniffer = true;
+                break;
+            case 'r':
+                rate = optarg ? optarg : "";
+                break;
+            case 'p':
+                parity = optarg ? optarg : "";
+                break;
             case ':':
             case '?':
             default:
@@ -153,7 +350,7 @@ int main(int argc, char *argv[])
         }
     }
 
-    if(device.empty())
+    if(device.empty() == iname.empty())
     {
         help(argv[0]);
         return EXIT_FAILURE;
@@ -161,7 +358,15 @@ int main(int argc, char *argv[])
 
     try
     {
-        exec(device, hex);
+        if(!iname.empty()) sniff(iname, quiet);
+        else if(sniffer)
+        {
+            std::signal(SIGINT, onStopSignal);
+            std::signal(SIGTERM, onStopSignal);
+            std::signal(SIGUSR1, onStatsSignal);
+            sniff(device, toBaudRate(rate), toParity(parity), cname, quiet);
+        }
+        else exec(device, toBaudRate(rate), toParity(parity), hex);
     }
     catch(const std::exception &except)
     {
@@ -0,0 +1,277 @@
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <csignal>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "Delta.h"
+#include "Ensure.h"
+#include "Master.h"
+#include "Plan.h"
+#include "Recorder.h"
+#include "ShmImage.h"
+#include "TraceLevel.h"
+#include "json.h"
+
+namespace {
+
+void help(const char *argv0, const char *message = nullptr)
+{
+    if(message) std::cout << "WARNING: " << message << '\n';
+
+    std::cout
+        << argv0
+        << " -d device"
+        << " -i input.json"
+        << " -m shm_name(/name)|-o output.ndjson|-|-R series_dir"
+        << " [-D snapshot_every(cycles, 0 - first only)]"
+        << " [-f format(json/cbor/msgpack)]"
+        << " [-c cycle_period(ms)]"
+        << " [-n cycles(0 - infinite)]"
+        << " [-r rate]"
+        << " [-p parity(O/E/N)]"
+        << " [-v (debug)]"
+        << std::endl;
+}
+
+using namespace Modbus::RTU;
+
+volatile std::sig_atomic_t stopRequested = 0;
+volatile std::sig_atomic_t statsRequested = 0;
+
+void onStopSignal(int)
+{
+    stopRequested = 1;
+}
+
+void onStatsSignal(int)
+{
+    statsRequested = 1;
+}
+
+/* single line per cycle (array), see master_cli loop mode: full results or
+ * (delta) only changed elements, failed request is reported every cycle */
+class Output
+{
+    std::ostream &os_;
+    JSON::Format format_;
+    long snapshot_;
+    Delta delta_;
+    std::vector<uint32_t> index_;
+    JSON::json cycle_;
+    bool full_{true};
+public:
+    Output(std::ostream &os, JSON::Format format, long snapshot, const Plan &plan):
+        os_{os},
+        format_{format},
+        snapshot_{snapshot},
+        delta_{plan}
+    {}
+
+    void begin(uint64_t cycle)
+    {
+        full_ = 0 > snapshot_ || 0 == cycle || (0 < snapshot_ && 0 == cycle % uint64_t(snapshot_));
+        cycle_ = JSON::json::array();
+        if(full_) delta_.reset();
+    }
+
+    void add(const Executor &executor, std::size_t i, Status status)
+    {
+        const auto &req = executor.plan()[i];
+
+        if(Status::Ok != status)
+        {
+            cycle_.push_back(
+                JSON::json{{"slave", req.slave}, {"addr", req.addr}, {"status", toString(status)}});
+        }
+        else if(full_)
+        {
+            delta_.update(executor, i, index_);
+            cycle_.push_back(JSON::result(executor, i, format_));
+        }
+        else if(delta_.update(executor, i, index_))
+        {
+            cycle_.push_back(JSON::delta(executor, i, index_, format_));
+        }
+    }
+
+    void end()
+    {
+        if(cycle_.empty()) return;
+        JSON::store(os_, cycle_, format_);
+        if(JSON::Format::JSON == format_) os_ << '\n';
+        os_ << std::flush;
+    }
+};
+
+} /* namespace */
+
+int main(int argc, char *argv[])
+{
+    std::string device, iname, name, oname, dname, rate = "19200", parity = "E", format = "json";
+    long period = 1000;
+    long cycles = 0;
+    long snapshot = -1;
+    bool verbose = false;
+
+    for(int c; -1 != (c = ::getopt(argc, argv, "hd:i:m:o:R:D:f:c:n:r:p:v"));)
+    {
+        switch(c)
+        {
+            case 'h':
+                help(argv[0]);
+                return EXIT_SUCCESS;
+                break;
+            case 'd':
+                device = optarg ? optarg : "";
+                break;
+            case 'i':
+                iname = optarg ? optarg : "";
+                break;
+            case 'm':
+                name = optarg ? optarg : "";
+                break;
+            case 'o':
+                oname = optarg ? optarg : "";
+                break;
+            case 'R':
+                dname = optarg ? optarg : "";
+                break;
+            case 'D':
+                snapshot = optarg ? ::atol(optarg) : 0;
+                break;
+            case 'f':
+                format = optarg ? optarg : "";
+                break;
+            case 'c':
+                period = optarg ? ::atol(optarg) : 0;
+                break;
+            case 'n':
+                cycles = optarg ? ::atol(optarg) : 0;
+                break;
+            case 'r':
+                rate = optarg ? optarg : "";
+                break;
+            case 'p':
+                parity = optarg ? optarg : "";
+                break;
+            case 'v':
+                verbose = true;
+                traceLevel(TraceLevel::Debug);
+                break;
+            case ':':
+            case '?':
+            default:
+                help(argv[0], "geopt() failure");
+                return EXIT_FAILURE;
+                break;
+        }
+    }
+
+    if(
+        device.empty() || iname.empty() || (name.empty() && oname.empty() && dname.empty())
+        || 0 >= period || 0 > cycles)
+    {
+        help(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    try
+    {
+        std::ifstream ifile{iname, std::ios::binary};
+
+        ENSURE(ifile, RuntimeError);
+
+        /* requests are validated and encoded once, executed every cycle */
+        const auto plan = JSON::compile(JSON::load(ifile, JSON::Format::JSON));
+        Master master
+        {
+            device,
+            toBaudRate(rate),
+            toParity(parity),
+            SerialPort::DataBits::Eight,
+            SerialPort::StopBits::One
+        };
+        Executor executor{master, plan};
+        std::unique_ptr<ShmImage> image;
+        std::unique_ptr<Output> output;
+        std::unique_ptr<Recorder> recorder;
+        std::ofstream ofile;
+        uint64_t failed = 0;
+
+        if(!name.empty()) image = std::make_unique<ShmImage>(name, plan);
+        if(!dname.empty()) recorder = std::make_unique<Recorder>(dname, plan);
+        if(!oname.empty())
+        {
+            if("-" != oname)
+            {
+                ofile.open(oname, std::ios::binary);
+                ENSURE(ofile, RuntimeError);
+            }
+            output =
+                std::make_unique<Output>(
+                    "-" == oname ? std::cout : ofile, JSON::toFormat(format), snapshot, plan);
+        }
+
+        master.debug(verbose);
+        std::signal(SIGINT, onStopSignal);
+        std::signal(SIGTERM, onStopSignal);
+        std::signal(SIGUSR1, onStatsSignal);
+
+        /* bus traffic does not depend on number of readers */
+        auto next = std::chrono::steady_clock::now();
+
+        uint64_t cycle = 0;
+
+        for(; !stopRequested && (!cycles || cycle < uint64_t(cycles)); ++cycle)
+        {
+            if(output) output->begin(cycle);
+            for(std::size_t i = 0; i < plan.size() && !stopRequested; ++i)
+            {
+                /* failure is published (quality), polling continues */
+                const auto status = executor.tryExec(i);
+
+                if(Status::Ok != status) ++failed;
+                if(image) image->publish(executor, i, status);
+                if(output) output->add(executor, i, status);
+                if(recorder) recorder->record(executor, i, status, Recorder::now());
+            }
+            if(image) image->heartbeat();
+            if(output) output->end();
+
+            if(statsRequested)
+            {
+                statsRequested = 0;
+                std::cerr << "cycles " << cycle + 1 << " failed " << failed << '\n';
+                master.timingStats().dump(std::cerr);
+            }
+
+            /* fixed rate, cycle overrun starts next one immediately */
+            next = std::max(next + mSecs{period}, std::chrono::steady_clock::now());
+            while(!stopRequested && std::chrono::steady_clock::now() < next)
+            {
+                std::this_thread::sleep_for(std::min<std::chrono::steady_clock::duration>(
+                    mSecs{100}, next - std::chrono::steady_clock::now()));
+            }
+        }
+        if(image) ShmImage::remove(name);
+        std::cerr << "cycles " << cycle << " failed " << failed << '\n';
+    }
+    catch(const std::exception &except)
+    {
+        TRACE(TraceLevel::Error, except.what());
+        return EXIT_FAILURE;
+    }
+    catch(...)
+    {
+        TRACE(TraceLevel::Error, "unsupported exception");
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
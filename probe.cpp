@@ -8,7 +8,7 @@
 #include "Ensure.h"
 #include "Except.h"
 #include "Master.h"
-#include "json.h"
+#include "TraceLevel.h"
 
 void help(const char *argv0, const char *message = nullptr)
 {
@@ -17,16 +17,20 @@ void help(const char *argv0, const char *message = nullptr)
     std::cout
         << argv0
         << " -d device"
+        << " [-r rate]"
+        << " [-p parity(O/E/N)]"
         << " [-s slave]"
+        << " [-v (debug)]"
         << std::endl;
 }
 
 int main(int argc, char *argv[])
 {
-    std::string device;
+    std::string device, rate = "19200", parity = "E";
     int slave = -1;
+    bool verbose = false;
 
-    for(int c; -1 != (c = ::getopt(argc, argv, "hd:s:"));)
+    for(int c; -1 != (c = ::getopt(argc, argv, "hd:r:p:s:v"));)
     {
         switch(c)
         {
@@ -37,9 +41,19 @@ int main(int argc, char *argv[])
             case 'd':
                 device = optarg ? optarg : "";
                 break;
+            case 'r':
+                rate = optarg ? optarg : "";
+                break;
+            case 'p':
+                parity = optarg ? optarg : "";
+                break;
             case 's':
                 slave = optarg ? ::atoi(optarg) : -1;
                 break;
+            case 'v':
+                verbose = true;
+                traceLevel(TraceLevel::Debug);
+                break;
             case ':':
             case '?':
             default:
@@ -58,35 +72,43 @@ int main(int argc, char *argv[])
     try
     {
         using namespace Modbus;
-        RTU::Master master{device.c_str()};
+        RTU::Master master
+        {
+            device,
+            toBaudRate(rate),
+            toParity(parity),
+            SerialPort::DataBits::Eight,
+            SerialPort::StopBits::One
+        };
+        master.debug(verbose);
         const auto begin = -1 == slave ? 1 : slave;
         const auto end = -1 == slave ? 256 : slave + 1;
 
         for(auto i = begin; i != end; ++i)
         {
-            RTU::JSON::json input
-            {
-                {"slave", i},
-                {"fcode", 3}, /* READ HOLDING REGISTERS */
-                {"addr", 0},
-                {"count", 1},
-            };
-
-            RTU::JSON::json output;
-
             try
             {
                 TRACE(TraceLevel::Info, "slave ", int(i));
-                Modbus::RTU::JSON::dispatch(master, input, output);
-            }
-            catch(const RTU::TimeoutError &except)
-            {
-                std::this_thread::sleep_for(std::chrono::milliseconds{25});
-            }
-            catch(const RTU::ReplyError &except)
-            {
-                TRACE(TraceLevel::Info, "reply error ", except.what(), " from ", int(i));
-                std::this_thread::sleep_for(std::chrono::milliseconds{25});
+
+                RTU::Master::DataSeq data;
+                /* READ HOLDING REGISTERS, failures are expected (most addresses
+                 * are not used) so non-throwing API is used */
+                const auto status =
+                    master.tryRdRegisters(RTU::Addr{uint8_t(i)}, 0, 1, data, RTU::mSecs{500});
+
+                if(RTU::Status::Ok == status)
+                {
+                    TRACE(TraceLevel::Info, "reply from ", int(i));
+                }
+                else if(RTU::Status::Timeout == status)
+                {
+                    std::this_thread::sleep_for(std::chrono::milliseconds{25});
+                }
+                else
+                {
+                    TRACE(TraceLevel::Info, "reply error (", RTU::toString(status), ") from ", int(i));
+                    std::this_thread::sleep_for(std::chrono::milliseconds{25});
+                }
             }
             catch(const RuntimeError &except)
             {
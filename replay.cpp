@@ -0,0 +1,197 @@
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <csignal>
+#include <iostream>
+#include <string>
+#include <thread>
+
+#include "Capture.h"
+#include "Ensure.h"
+#include "PseudoSerial.h"
+
+namespace {
+
+void help(const char *argv0, const char *message = nullptr)
+{
+    if(message) std::cout << "WARNING: " << message << '\n';
+
+    std::cout
+        << argv0
+        << " -i capture.bin"
+        << " [-d device (instead of pseudo terminal)]"
+        << " [-p parity(O/E/N) (device only)]"
+        << " [-s speed(1 - original, 0 - as fast as possible)]"
+        << " [-n loops(0 - infinite)]"
+        << " [-w start_delay(ms)]"
+        << std::endl;
+}
+
+using namespace Modbus::RTU;
+
+volatile std::sig_atomic_t stopRequested = 0;
+
+void onStopSignal(int)
+{
+    stopRequested = 1;
+}
+
+/* chunks are written at (scaled) capture timestamps, so gaps between frames
+ * (and chunking of received data) are reproduced - line rate is given by
+ * port settings (same as capture) */
+void replay(CaptureReader &capture, SerialPort &port, double speed, long loops)
+{
+    using namespace std::chrono;
+    using Clock = SerialPort::Clock;
+
+    const auto silence = duration_cast<nanoseconds>(capture.header().silentInterval());
+    const auto start = Clock::now();
+    /* capture time of loop start */
+    nanoseconds offset{0};
+    uint64_t chunks = 0, bytes = 0;
+
+    for(long loop = 0; !stopRequested && (!loops || loop < loops); ++loop)
+    {
+        CaptureReader::Chunk chunk;
+        nanoseconds last{0};
+
+        capture.rewind();
+        while(!stopRequested && capture.next(chunk))
+        {
+            const auto *const end = chunk.data + chunk.size;
+
+            last = nanoseconds{chunk.timestamp};
+            if(0.0 < speed)
+            {
+                const duration<double, std::nano> at{double((offset + last).count()) / speed};
+
+                std::this_thread::sleep_until(start + duration_cast<Clock::duration>(at));
+            }
+
+            /* reader does not keep up - pty buffer is full */
+            ENSURE(end == port.write(chunk.data, end, SerialPort::mSecs{1000}), RuntimeError);
+            ++chunks;
+            bytes += chunk.size;
+        }
+        /* next loop starts after silent interval */
+        offset += last + silence;
+    }
+    port.drain();
+    std::cerr << "chunks " << chunks << " bytes " << bytes << std::endl;
+}
+
+/* pty: data not read by reader yet is discarded when master is closed */
+void waitRead(const FdGuard &slave, std::chrono::milliseconds timeout)
+{
+    const auto deadline = std::chrono::steady_clock::now() + timeout;
+    int pending = 0;
+
+    while(
+        !stopRequested
+        && 0 == ::ioctl(slave.fd(), FIONREAD, &pending) && 0 < pending
+        && std::chrono::steady_clock::now() < deadline)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds{10});
+    }
+}
+
+} /* namespace */
+
+int main(int argc, char *argv[])
+{
+    std::string iname, device, parity = "E";
+    double speed = 1.0;
+    long loops = 1;
+    long delay = 1000;
+
+    for(int c; -1 != (c = ::getopt(argc, argv, "hi:d:p:s:n:w:"));)
+    {
+        switch(c)
+        {
+            case 'h':
+                help(argv[0]);
+                return EXIT_SUCCESS;
+                break;
+            case 'i':
+                iname = optarg ? optarg : "";
+                break;
+            case 'd':
+                device = optarg ? optarg : "";
+                break;
+            case 'p':
+                parity = optarg ? optarg : "";
+                break;
+            case 's':
+                speed = optarg ? ::atof(optarg) : 0;
+                break;
+            case 'n':
+                loops = optarg ? ::atol(optarg) : 0;
+                break;
+            case 'w':
+                delay = optarg ? ::atol(optarg) : 0;
+                break;
+            case ':':
+            case '?':
+            default:
+                help(argv[0], "geopt() failure");
+                return EXIT_FAILURE;
+                break;
+        }
+    }
+
+    if(iname.empty() || 0.0 > speed || 0 > loops || 0 > delay)
+    {
+        help(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    try
+    {
+        CaptureReader capture{iname};
+        const auto rate = toBaudRate(std::to_string(capture.header().bitRate));
+
+        std::signal(SIGINT, onStopSignal);
+        std::signal(SIGTERM, onStopSignal);
+
+        if(!device.empty())
+        {
+            SerialPort port
+            {
+                device,
+                rate,
+                toParity(parity),
+                SerialPort::DataBits::Eight,
+                SerialPort::StopBits::One,
+                nullptr
+            };
+
+            replay(capture, port, speed, loops);
+            return EXIT_SUCCESS;
+        }
+
+        /* pseudo terminals do not support parity - reader has to use -p N */
+        auto pty =
+            createPseudoTerminal(
+                rate, SerialPort::Parity::None,
+                SerialPort::DataBits::Eight, SerialPort::StopBits::One);
+
+        std::cout << pty.slave.path() << std::endl;
+        /* time to open pty by reader (monitor, ...) */
+        std::this_thread::sleep_for(std::chrono::milliseconds{delay});
+        replay(capture, pty.master, speed, loops);
+        waitRead(pty.slave, std::chrono::milliseconds{delay});
+    }
+    catch(const std::exception &except)
+    {
+        std::cerr << except.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+    catch(...)
+    {
+        std::cerr << "unsupported exception" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
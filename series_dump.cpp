@@ -0,0 +1,150 @@
+#include <unistd.h>
+
+#include <cstdint>
+#include <iostream>
+#include <limits>
+#include <string>
+
+#include "Ensure.h"
+#include "Frame.h"
+#include "Recorder.h"
+#include "json.h"
+
+namespace {
+
+void help(const char *argv0, const char *message = nullptr)
+{
+    if(message) std::cout << "WARNING: " << message << '\n';
+
+    std::cout
+        << argv0
+        << " -i input.series"
+        << " [-b begin(ms since epoch)]"
+        << " [-e end(ms since epoch)]"
+        << " [-f format(json/csv)]"
+        << " [-l (info only)]"
+        << std::endl;
+}
+
+using namespace Modbus::RTU;
+
+JSON::json info(const SeriesReader::Info &info)
+{
+    return JSON::json
+    {
+        {"slave", info.slave},
+        {"fcode", info.fcode},
+        {"addr", info.addr},
+        {"count", info.count},
+        {"elements", info.elementNum},
+        {"blocks", info.blockNum},
+        {"samples", info.sampleNum},
+        {"size", info.dataSize},
+        {"first", info.first},
+        {"last", info.last}
+    };
+}
+
+/* address of (first item of) element: register, byte of packed coils, byte */
+uint32_t address(const SeriesReader::Info &info, uint32_t n)
+{
+    return info.addr + (FCODE_RD_COILS == info.fcode ? n << 3 : n);
+}
+
+} /* namespace */
+
+int main(int argc, char *argv[])
+{
+    std::string iname, format = "json";
+    int64_t from = std::numeric_limits<int64_t>::min(), to = std::numeric_limits<int64_t>::max();
+    bool infoOnly = false;
+
+    for(int c; -1 != (c = ::getopt(argc, argv, "hi:b:e:f:l"));)
+    {
+        switch(c)
+        {
+            case 'h':
+                help(argv[0]);
+                return EXIT_SUCCESS;
+                break;
+            case 'i':
+                iname = optarg ? optarg : "";
+                break;
+            case 'b':
+                from = std::stoll(optarg ? optarg : "0");
+                break;
+            case 'e':
+                to = std::stoll(optarg ? optarg : "0");
+                break;
+            case 'f':
+                format = optarg ? optarg : "";
+                break;
+            case 'l':
+                infoOnly = true;
+                break;
+            case ':':
+            case '?':
+            default:
+                help(argv[0], "geopt() failure");
+                return EXIT_FAILURE;
+                break;
+        }
+    }
+
+    if(iname.empty() || ("json" != format && "csv" != format))
+    {
+        help(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    try
+    {
+        const SeriesReader reader{iname};
+        const auto series = reader.info();
+
+        if(infoOnly)
+        {
+            std::cout << info(series).dump(4) << std::endl;
+            return EXIT_SUCCESS;
+        }
+
+        /* one line per sample, only blocks of [from, to] are decoded */
+        if("csv" == format)
+        {
+            std::cout << "timestamp";
+            for(uint32_t n = 0; n < series.elementNum; ++n) std::cout << ',' << address(series, n);
+            std::cout << '\n';
+
+            reader.forEach(
+                from, to,
+                [](int64_t timestamp, const std::vector<uint16_t> &values)
+                {
+                    std::cout << timestamp;
+                    for(const auto value : values) std::cout << ',' << value;
+                    std::cout << '\n';
+                });
+        }
+        else
+        {
+            reader.forEach(
+                from, to,
+                [](int64_t timestamp, const std::vector<uint16_t> &values)
+                {
+                    std::cout << JSON::json{{"timestamp", timestamp}, {"value", values}} << '\n';
+                });
+        }
+        std::cout << std::flush;
+    }
+    catch(const std::exception &except)
+    {
+        std::cerr << except.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+    catch(...)
+    {
+        std::cerr << "unsupported exception" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
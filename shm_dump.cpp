@@ -0,0 +1,134 @@
+#include <unistd.h>
+
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include "Ensure.h"
+#include "Frame.h"
+#include "ShmImage.h"
+#include "json.h"
+
+namespace {
+
+void help(const char *argv0, const char *message = nullptr)
+{
+    if(message) std::cout << "WARNING: " << message << '\n';
+
+    std::cout
+        << argv0
+        << " -m shm_name(/name)"
+        << " [-w watch_period(ms)]"
+        << std::endl;
+}
+
+using namespace Modbus::RTU;
+
+/* consistent copy of every block, same keys as master_cli output */
+JSON::json snapshot(const ShmImage &image)
+{
+    auto output = JSON::json::array();
+    std::vector<uint8_t> data;
+
+    for(std::size_t i = 0; i < image.blockNum(); ++i)
+    {
+        const auto &block = image.block(i);
+
+        data.resize(block.size);
+
+        const auto state = image.read(i, data.data());
+        JSON::json value;
+
+        if(FCODE_RD_HOLDING_REGISTERS == block.fcode)
+        {
+            const auto *const reg = reinterpret_cast<const uint16_t *>(data.data());
+
+            value = Master::DataSeq(reg, reg + block.count);
+        }
+        else value = data;
+
+        output.push_back(
+            JSON::json
+            {
+                {"slave", block.slave},
+                {"fcode", block.fcode},
+                {"addr", block.addr},
+                {"count", block.count},
+                {"quality", toString(state.quality)},
+                {"status", toString(state.status)},
+                {"failures", state.failures},
+                {"updated", state.updated},
+                {"polled", state.polled},
+                {"value", value}
+            });
+    }
+    return output;
+}
+
+} /* namespace */
+
+int main(int argc, char *argv[])
+{
+    std::string name;
+    unsigned long period = 0;
+
+    for(int c; -1 != (c = ::getopt(argc, argv, "hm:w:"));)
+    {
+        switch(c)
+        {
+            case 'h':
+                help(argv[0]);
+                return EXIT_SUCCESS;
+                break;
+            case 'm':
+                name = optarg ? optarg : "";
+                break;
+            case 'w':
+                period = std::stoul(optarg ? optarg : "0");
+                break;
+            case ':':
+            case '?':
+            default:
+                help(argv[0], "geopt() failure");
+                return EXIT_FAILURE;
+                break;
+        }
+    }
+
+    if(name.empty())
+    {
+        help(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    try
+    {
+        const ShmImage image{name};
+
+        /* single snapshot or (-w) one line per period */
+        if(!period)
+        {
+            std::cout << snapshot(image).dump(4) << std::endl;
+            return EXIT_SUCCESS;
+        }
+
+        for(;;)
+        {
+            std::cout << snapshot(image) << std::endl;
+            std::this_thread::sleep_for(std::chrono::milliseconds{period});
+        }
+    }
+    catch(const std::exception &except)
+    {
+        std::cerr << except.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+    catch(...)
+    {
+        std::cerr << "unsupported exception" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
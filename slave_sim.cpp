@@ -0,0 +1,336 @@
+#include <unistd.h>
+
+#include <csignal>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+#include <nlohmann/json.hpp>
+
+#include "Ensure.h"
+#include "Slave.h"
+#include "TcpPort.h"
+#include "TraceLevel.h"
+
+namespace {
+
+void help(const char *argv0, const char *message = nullptr)
+{
+    if(message) std::cout << "WARNING: " << message << '\n';
+
+    std::cout
+        << argv0
+        <<
+            " -a slaves(e.g. 1-40,45)|-c profiles.json"
+            " [-r rate]"
+            " [-l [host:]port (raw RTU over TCP instead of pseudo terminal)]"
+            " [-t turnaround_us]"
+            " [-j jitter_us]"
+            " [-e (exponential jitter)]"
+            " [-x drop_percent]"
+            " [-k dead_percent]"
+            " [-m registers]"
+            " [-f faults(e.g. flip=0.01,echo=0.001)]"
+            " [-g gap_us]"
+            " [-s seed]"
+            " [-v (debug)]"
+        << std::endl;
+}
+
+using json = nlohmann::json;
+using uSecs = Modbus::RTU::Slave::uSecs;
+using Profile = Modbus::RTU::Slave::Profile;
+using Profiles = Modbus::RTU::Simulator::Profiles;
+
+volatile std::sig_atomic_t stopRequested = 0;
+volatile std::sig_atomic_t statsRequested = 0;
+
+void onStopSignal(int)
+{
+    stopRequested = 1;
+}
+
+void onStatsSignal(int)
+{
+    statsRequested = 1;
+}
+
+void add(Profiles &profiles, int first, int last, const Profile &profile)
+{
+    ENSURE(0 < first && first <= last && 247 >= last, RuntimeError);
+
+    for(auto i = first; i <= last; ++i) profiles[uint8_t(i)] = profile;
+}
+
+/* comma separated list of addresses or ranges e.g. 1-40,45 */
+Profiles parseSlaves(const std::string &slaves, const Profile &profile)
+{
+    Profiles profiles;
+    std::istringstream is{slaves};
+
+    for(std::string item; std::getline(is, item, ',');)
+    {
+        const auto dash = item.find('-');
+        const auto first = std::stoi(item.substr(0, dash));
+        const auto last = std::string::npos == dash ? first : std::stoi(item.substr(dash + 1));
+
+        add(profiles, first, last, profile);
+    }
+    return profiles;
+}
+
+/* comma separated list of fault=rate e.g. flip=0.01,drop=0.001 */
+Modbus::RTU::Faults parseFaults(const std::string &list, uSecs gap)
+{
+    Modbus::RTU::Faults faults;
+    std::istringstream is{list};
+
+    faults.gap = gap;
+    for(std::string item; std::getline(is, item, ',');)
+    {
+        const auto eq = item.find('=');
+
+        ENSURE(std::string::npos != eq, RuntimeError);
+
+        const auto rate = std::stod(item.substr(eq + 1));
+
+        ENSURE(0.0 <= rate && 1.0 >= rate, RuntimeError);
+        faults[Modbus::RTU::toFault(item.substr(0, eq))] = rate;
+    }
+    return faults;
+}
+
+/* [{"slave": 1 | [first, last], "turnaround": us, "jitter": us,
+ *   "distribution": "uniform" | "exponential", "drop": 0-1, "dead": 0-1,
+ *   "coils": N, "registers": N, "bytes": N}, ...]
+ * missing parameters are taken from command line options */
+Profiles loadProfiles(const std::string &fname, const Profile &defaults)
+{
+    std::ifstream ifile{fname};
+
+    ENSURE(ifile, RuntimeError);
+
+    const auto input = json::parse(ifile);
+    Profiles profiles;
+
+    ENSURE(input.is_array(), RuntimeError);
+
+    for(const auto &i : input)
+    {
+        ENSURE(i.is_object() && i.count("slave"), RuntimeError);
+
+        auto profile = defaults;
+        const auto &slave = i["slave"];
+        const auto first = slave.is_array() ? slave.at(0).get<int>() : slave.get<int>();
+        const auto last = slave.is_array() ? slave.at(1).get<int>() : first;
+
+        if(i.count("turnaround")) profile.turnaround = uSecs{i["turnaround"].get<int64_t>()};
+        if(i.count("jitter")) profile.jitter = uSecs{i["jitter"].get<int64_t>()};
+        if(i.count("distribution"))
+        {
+            const auto distribution = i["distribution"].get<std::string>();
+
+            ENSURE("uniform" == distribution || "exponential" == distribution, RuntimeError);
+            profile.distribution =
+                "exponential" == distribution
+                ? Profile::Distribution::Exponential
+                : Profile::Distribution::Uniform;
+        }
+        if(i.count("drop")) profile.dropRate = i["drop"].get<double>();
+        if(i.count("dead")) profile.deadRate = i["dead"].get<double>();
+        if(i.count("coils")) profile.coilNum = i["coils"].get<std::size_t>();
+        if(i.count("registers")) profile.registerNum = i["registers"].get<std::size_t>();
+        if(i.count("bytes")) profile.byteNum = i["bytes"].get<std::size_t>();
+        add(profiles, first, last, profile);
+    }
+    return profiles;
+}
+
+void dumpIfRequested(const Modbus::RTU::Bus &bus)
+{
+    if(!statsRequested) return;
+    statsRequested = 0;
+    bus.dump(std::cerr);
+}
+
+/* serve until stop is requested (true) or port failure e.g. closed connection */
+bool serve(Modbus::RTU::Bus &bus)
+{
+    while(!stopRequested)
+    {
+        try
+        {
+            bus.serve(Modbus::RTU::mSecs{100});
+        }
+        catch(const std::exception &except)
+        {
+            /* interrupted by signal */
+            if(!stopRequested && !statsRequested)
+            {
+                TRACE(TraceLevel::Warning, except.what());
+                return false;
+            }
+        }
+        dumpIfRequested(bus);
+    }
+    return true;
+}
+
+void servePseudoTerminal(Modbus::RTU::Bus &bus, const std::string &rate, std::ostream *debugTo)
+{
+    using namespace Modbus;
+
+    /* pseudo terminals do not support parity - master has to use -p N */
+    auto pty =
+        createPseudoTerminal(
+            toBaudRate(rate), SerialPort::Parity::None,
+            SerialPort::DataBits::Eight, SerialPort::StopBits::One,
+            debugTo);
+
+    bus.port(&pty.master);
+    std::cout << pty.slave.path() << std::endl;
+    ENSURE(serve(bus), RuntimeError);
+    bus.port(nullptr);
+}
+
+/* single connection at a time (as serial device server), line settings
+ * do not apply - timing is given by slave profiles only */
+void serveTcp(Modbus::RTU::Bus &bus, const std::string &address, std::ostream *debugTo)
+{
+    TcpListener listener{address};
+    const auto colon = address.rfind(':');
+
+    std::cout
+        << "tcp://"
+        << (std::string::npos == colon ? std::string{"localhost"} : address.substr(0, colon))
+        << ':' << listener.port()
+        << std::endl;
+
+    while(!stopRequested)
+    {
+        auto fdGuard = listener.accept(Modbus::RTU::mSecs{100});
+
+        if(fdGuard)
+        {
+            TcpPort connection{std::move(fdGuard), debugTo};
+
+            bus.port(&connection);
+            serve(bus);
+            bus.port(nullptr);
+        }
+        dumpIfRequested(bus);
+    }
+}
+
+} /* namespace */
+
+int main(int argc, char *argv[])
+{
+    std::string slaves, cname, faults, address;
+    uSecs gap{2000};
+    std::string rate = "19200";
+    Profile profile;
+    uint32_t seed = std::mt19937::default_seed;
+    bool verbose = false;
+
+    for(int c; -1 != (c = ::getopt(argc, argv, "ha:c:r:l:t:j:ex:k:m:f:g:s:v"));)
+    {
+        switch(c)
+        {
+            case 'h':
+                help(argv[0]);
+                return EXIT_SUCCESS;
+                break;
+            case 'a':
+                slaves = optarg ? optarg : "";
+                break;
+            case 'c':
+                cname = optarg ? optarg : "";
+                break;
+            case 'r':
+                rate = optarg ? optarg : "";
+                break;
+            case 'l':
+                address = optarg ? optarg : "";
+                break;
+            case 't':
+                profile.turnaround = uSecs{optarg ? ::atol(optarg) : -1};
+                break;
+            case 'j':
+                profile.jitter = uSecs{optarg ? ::atol(optarg) : -1};
+                break;
+            case 'e':
+                profile.distribution = Profile::Distribution::Exponential;
+                break;
+            case 'x':
+                profile.dropRate = optarg ? ::atof(optarg) / 100.0 : -1.0;
+                break;
+            case 'k':
+                profile.deadRate = optarg ? ::atof(optarg) / 100.0 : -1.0;
+                break;
+            case 'm':
+                profile.registerNum = optarg ? ::atol(optarg) : 0;
+                break;
+            case 'f':
+                faults = optarg ? optarg : "";
+                break;
+            case 'g':
+                gap = uSecs{optarg ? ::atol(optarg) : -1};
+                break;
+            case 's':
+                seed = optarg ? uint32_t(::atol(optarg)) : seed;
+                break;
+            case 'v':
+                verbose = true;
+                traceLevel(TraceLevel::Debug);
+                break;
+            case ':':
+            case '?':
+            default:
+                help(argv[0], "geopt() failure");
+                return EXIT_FAILURE;
+                break;
+        }
+    }
+
+    if(
+        slaves.empty() == cname.empty()
+        || uSecs{0} > profile.turnaround || uSecs{0} > profile.jitter || uSecs{0} > gap)
+    {
+        help(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    try
+    {
+        using namespace Modbus;
+
+        const auto profiles =
+            cname.empty() ? parseSlaves(slaves, profile) : loadProfiles(cname, profile);
+
+        RTU::Bus bus{seed};
+
+        for(const auto &i : profiles) bus.add(RTU::Addr{i.first}, i.second);
+        bus.faults(parseFaults(faults, gap));
+
+        std::signal(SIGINT, onStopSignal);
+        std::signal(SIGTERM, onStopSignal);
+        std::signal(SIGUSR1, onStatsSignal);
+
+        if(address.empty()) servePseudoTerminal(bus, rate, verbose ? &std::cerr : nullptr);
+        else serveTcp(bus, address, verbose ? &std::cerr : nullptr);
+        bus.dump(std::cerr);
+    }
+    catch(const std::exception &except)
+    {
+        TRACE(TraceLevel::Error, except.what());
+        return EXIT_FAILURE;
+    }
+    catch(...)
+    {
+        TRACE(TraceLevel::Error, "unsupported exception");
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
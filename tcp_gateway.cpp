@@ -0,0 +1,170 @@
+#include <unistd.h>
+
+#include <algorithm>
+#include <csignal>
+#include <fstream>
+#include <iostream>
+
+#include "Ensure.h"
+#include "Gateway.h"
+#include "ReadCache.h"
+#include "TraceLevel.h"
+#include "json.h"
+
+namespace {
+
+void help(const char *argv0, const char *message = nullptr)
+{
+    if(message) std::cout << "WARNING: " << message << '\n';
+
+    std::cout
+        << argv0
+        << " -d device"
+        << " [-r rate]"
+        << " [-p parity(O/E/N)]"
+        << " [-l [host:]port (default 502)]"
+        << " [-t timeout_ms]"
+        << " [-n retry]"
+        << " [-q queue_per_client]"
+        << " [-c cache_ttl_ms]"
+        << " [-C cache_rules.json]"
+        << " [-v (debug)]"
+        << std::endl;
+}
+
+volatile std::sig_atomic_t stopRequested = 0;
+volatile std::sig_atomic_t statsRequested = 0;
+
+void onStopSignal(int)
+{
+    stopRequested = 1;
+}
+
+void onStatsSignal(int)
+{
+    statsRequested = 1;
+}
+
+} /* namespace */
+
+int main(int argc, char *argv[])
+{
+    std::string device, rate = "19200", parity = "E", address = "502", rules;
+    long timeout = 100, retry = 1, queue = 32, ttl = -1;
+    bool verbose = false;
+
+    for(int c; -1 != (c = ::getopt(argc, argv, "hd:r:p:l:t:n:q:c:C:v"));)
+    {
+        switch(c)
+        {
+            case 'h':
+                help(argv[0]);
+                return EXIT_SUCCESS;
+                break;
+            case 'd':
+                device = optarg ? optarg : "";
+                break;
+            case 'r':
+                rate = optarg ? optarg : "";
+                break;
+            case 'p':
+                parity = optarg ? optarg : "";
+                break;
+            case 'l':
+                address = optarg ? optarg : "";
+                break;
+            case 't':
+                timeout = optarg ? ::atol(optarg) : 0;
+                break;
+            case 'n':
+                retry = optarg ? ::atol(optarg) : 0;
+                break;
+            case 'q':
+                queue = optarg ? ::atol(optarg) : 0;
+                break;
+            case 'c':
+                ttl = optarg ? ::atol(optarg) : 0;
+                break;
+            case 'C':
+                rules = optarg ? optarg : "";
+                break;
+            case 'v':
+                verbose = true;
+                traceLevel(TraceLevel::Debug);
+                break;
+            case ':':
+            case '?':
+            default:
+                help(argv[0], "geopt() failure");
+                return EXIT_FAILURE;
+                break;
+        }
+    }
+
+    if(device.empty() || address.empty() || 0 >= timeout || 0 >= retry || 0 >= queue)
+    {
+        help(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    try
+    {
+        using namespace Modbus;
+
+        RTU::Master master
+        {
+            device,
+            toBaudRate(rate),
+            toParity(parity),
+            SerialPort::DataBits::Eight,
+            SerialPort::StopBits::One
+        };
+        RTU::Gateway::Config config;
+        /* repeated reads (also of different clients) within TTL */
+        RTU::ReadCache cache{RTU::mSecs{std::max(0l, ttl)}};
+
+        if(!rules.empty())
+        {
+            std::ifstream ifile{rules, std::ios::binary};
+
+            ENSURE(ifile, RuntimeError);
+            RTU::JSON::configure(cache, RTU::JSON::load(ifile, RTU::JSON::Format::JSON));
+        }
+        if(0 <= ttl || !rules.empty()) master.cache(&cache);
+
+        config.timeout = RTU::mSecs{timeout};
+        config.retryNum = int(retry);
+        config.queueLimit = std::size_t(queue);
+        master.debug(verbose);
+
+        RTU::Gateway gateway{master, address, config};
+
+        std::signal(SIGINT, onStopSignal);
+        std::signal(SIGTERM, onStopSignal);
+        std::signal(SIGUSR1, onStatsSignal);
+        TRACE(TraceLevel::Info, "listening on port ", gateway.port());
+
+        while(!stopRequested)
+        {
+            gateway.step(RTU::mSecs{100});
+            if(statsRequested)
+            {
+                statsRequested = 0;
+                gateway.dump(std::cerr);
+            }
+        }
+        gateway.dump(std::cerr);
+    }
+    catch(const std::exception &except)
+    {
+        TRACE(TraceLevel::Error, except.what());
+        return EXIT_FAILURE;
+    }
+    catch(...)
+    {
+        TRACE(TraceLevel::Error, "unsupported exception");
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,386 @@
+#include <cstdint>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "Plan.h"
+#include "Slave.h"
+#include "VirtualPort.h"
+#include "json.h"
+#include "utest.h"
+
+using namespace Modbus::RTU;
+using namespace Modbus::RTU::JSON;
+
+namespace {
+
+const auto timeout = mSecs{100};
+
+const Format formats[] = {Format::JSON, Format::CBOR, Format::MsgPack};
+
+/* values as sent by client of binary format (registers in big-endian order) */
+json::binary_t toBlob(const std::vector<int> &values, bool words)
+{
+    json::binary_t blob;
+
+    for(const auto i : values)
+    {
+        if(words) blob.push_back(uint8_t(i >> 8));
+        blob.push_back(uint8_t(i & 0xFF));
+    }
+    return blob;
+}
+
+std::vector<int> fromBlob(const json::binary_t &blob, bool words)
+{
+    std::vector<int> values;
+
+    for(std::size_t i = 0; i < blob.size(); i += words ? 2 : 1)
+    {
+        values.push_back(words ? (int(blob[i]) << 8) | blob[i + 1] : int(blob[i]));
+    }
+    return values;
+}
+
+/* store() followed by load() - whole encoded value has to be consumed */
+json roundTrip(const json &value, Format format)
+{
+    std::stringstream ss;
+
+    store(ss, value, format);
+
+    const auto decoded = load(ss, format);
+
+    ss.peek();
+    return ss.eof() ? decoded : json{};
+}
+
+/* every fcode: writes first, then reads of written data */
+json requests(Format format)
+{
+    const auto binary = Format::JSON != format;
+    const std::vector<int> registers{0x1234, 0xABCD, 7};
+    const std::vector<int> bytes{1, 2, 255};
+
+    return json::array(
+        {
+            {
+                {"slave", 1}, {"fcode", 16}, {"addr", 0}, {"count", 3},
+                {"value", binary ? json::binary(toBlob(registers, true)) : json(registers)}
+            },
+            {
+                {"slave", 1}, {"fcode", 66}, {"addr", 0}, {"count", 3},
+                {"value", binary ? json::binary(toBlob(bytes, false)) : json(bytes)}
+            },
+            {{"slave", 1}, {"fcode", 5}, {"addr", 3}, {"value", true}},
+            {{"slave", 1}, {"fcode", 6}, {"addr", 5}, {"value", 0xBEEF}},
+            {{"slave", 1}, {"fcode", 3}, {"addr", 0}, {"count", 6}},
+            {{"slave", 1}, {"fcode", 65}, {"addr", 0}, {"count", 3}},
+            {{"slave", 1}, {"fcode", 1}, {"addr", 0}, {"count", 8}}
+        });
+}
+
+/* values read back by last three requests */
+const std::vector<std::vector<int>> readValues
+{
+    {0x1234, 0xABCD, 7, 0, 0, 0xBEEF},
+    {1, 2, 255},
+    /* coils are packed - 8 coils per byte, lowest address in bit 0 */
+    {0x08}
+};
+
+/* counts flushes of output stream, content at every flush is kept */
+struct FlushLog: std::stringbuf
+{
+    std::vector<std::string> flushed;
+
+    int sync() override
+    {
+        flushed.push_back(str());
+        return std::stringbuf::sync();
+    }
+};
+
+} /* namespace */
+
+UTEST(JSON, roundTrip)
+{
+    for(const auto format : formats)
+    {
+        Bus bus;
+
+        bus.add(Addr{1});
+
+        VirtualPort port{bus};
+        Master master{port};
+        const auto input = requests(format);
+        json output = json::array();
+
+        for(const auto &request : input)
+        {
+            const auto loaded = roundTrip(request, format);
+
+            EXPECT_TRUE(request == loaded);
+            dispatch(master, loaded, output, format);
+            EXPECT_TRUE(output.back() == roundTrip(output.back(), format));
+        }
+        ASSERT_TRUE(input.size() == output.size());
+
+        for(std::size_t i = 0; i < readValues.size(); ++i)
+        {
+            const auto &reply = output[input.size() - readValues.size() + i];
+            const auto words = 0 == i;
+
+            ASSERT_TRUE(reply.count("value"));
+            if(Format::JSON == format)
+            {
+                EXPECT_TRUE(reply["value"].is_array());
+                EXPECT_TRUE(readValues[i] == reply["value"].get<std::vector<int>>());
+            }
+            else
+            {
+                EXPECT_TRUE(reply["value"].is_binary());
+                EXPECT_TRUE(readValues[i] == fromBlob(reply["value"].get_binary(), words));
+            }
+        }
+
+        /* same requests compiled into Plan - result() encodes as dispatch() */
+        const auto plan = compile(input);
+        Executor executor{master, plan};
+
+        ASSERT_TRUE(input.size() == plan.size());
+        for(std::size_t i = 0; i < plan.size(); ++i)
+        {
+            executor.exec(i);
+            EXPECT_TRUE(roundTrip(output[i], format) == roundTrip(result(executor, i, format), format));
+        }
+    }
+}
+
+UTEST(JSON, sequence)
+{
+    /* binary values follow one another in single stream (no delimiter) */
+    for(const auto format : formats)
+    {
+        const auto input = requests(format);
+        std::stringstream ss;
+
+        for(const auto &request : input) store(ss, request, format);
+        for(const auto &request : input) EXPECT_TRUE(request == load(ss, format));
+    }
+}
+
+UTEST(JSON, compileRejects)
+{
+    Bus bus;
+
+    bus.add(Addr{1});
+
+    VirtualPort port{bus};
+    Master master{port};
+    const json valid = {{"slave", 1}, {"fcode", 3}, {"addr", 0}, {"count", 2}};
+    const json invalid[] =
+    {
+        /* not an array of requests */
+        valid,
+        json::array({json{{"fcode", 3}, {"addr", 0}, {"count", 2}}}),
+        json::array({json{{"slave", 256}, {"fcode", 3}, {"addr", 0}, {"count", 2}}}),
+        json::array({json{{"slave", 1}, {"fcode", 4}, {"addr", 0}, {"count", 2}}}),
+        json::array({json{{"slave", 1}, {"fcode", 3}, {"addr", 70000}, {"count", 2}}}),
+        json::array({json{{"slave", 1}, {"fcode", 3}, {"addr", 0}, {"count", 300}}}),
+        json::array({json{{"slave", 1}, {"fcode", 1}, {"addr", 0}, {"count", 2001}}}),
+        json::array({json{{"slave", 1}, {"fcode", 5}, {"addr", 0}, {"value", 1}}}),
+        json::array({json{{"slave", 1}, {"fcode", 6}, {"addr", 0}, {"value", 70000}}}),
+        json::array({json{{"slave", 1}, {"fcode", 16}, {"addr", 0}, {"count", 2}, {"value", {1}}}}),
+        json::array({json{{"slave", 1}, {"fcode", 3}, {"addr", 0}, {"count", 2}, {"timeout_ms", 0}}}),
+        /* valid request followed by invalid one */
+        json::array({valid, json{{"slave", 1}, {"fcode", 3}, {"addr", 0}}})
+    };
+    std::size_t rejected = 0;
+
+    for(const auto &input : invalid)
+    {
+        try
+        {
+            compile(input);
+        }
+        catch(const std::exception &)
+        {
+            ++rejected;
+        }
+    }
+    EXPECT_TRUE(std::size(invalid) == rejected);
+    /* whole batch is validated before anything is executed */
+    EXPECT_TRUE(0u == port.txCntr());
+    EXPECT_TRUE(0u == bus.slave(Addr{1}).requestCntr());
+
+    /* unlike dispatch() - which executes requests preceding invalid one */
+    json output = json::array();
+    bool thrown = false;
+
+    try
+    {
+        for(const auto &request : invalid[std::size(invalid) - 1]) dispatch(master, request, output);
+    }
+    catch(const std::exception &)
+    {
+        thrown = true;
+    }
+    EXPECT_TRUE(thrown);
+    EXPECT_TRUE(1u == bus.slave(Addr{1}).requestCntr());
+}
+
+UTEST(JSON, executorReplyBuffer)
+{
+    Bus bus;
+
+    bus.add(Addr{1});
+
+    VirtualPort port{bus};
+    Master master{port};
+    const auto plan =
+        compile(
+            json::array(
+                {
+                    {{"slave", 1}, {"fcode", 3}, {"addr", 0}, {"count", 2}},
+                    {{"slave", 1}, {"fcode", 65}, {"addr", 0}, {"count", 4}}
+                }));
+    Executor executor{master, plan};
+    const uint8_t *const replies[] = {executor.reply(0), executor.reply(1)};
+
+    /* replies are laid out back to back in single buffer */
+    EXPECT_TRUE(replies[0] + plan[0].repSize == replies[1]);
+
+    for(uint16_t i = 1; i <= 3; ++i)
+    {
+        master.wrRegisters(Addr{1}, 0, Master::DataSeq{i, uint16_t(i << 8)}, timeout);
+        executor.exec(0);
+        executor.exec(1);
+
+        /* executed in place - no reallocation between exec() calls */
+        EXPECT_TRUE(replies[0] == executor.reply(0));
+        EXPECT_TRUE(replies[1] == executor.reply(1));
+        EXPECT_TRUE(0 == replies[0][3] && i == replies[0][4]);
+        EXPECT_TRUE(i == replies[0][5] && 0 == replies[0][6]);
+
+        const json expected = {{"slave", 1}, {"addr", 0}, {"count", 2}, {"value", {i, i << 8}}};
+
+        EXPECT_TRUE(expected == result(executor, 0));
+    }
+}
+
+UTEST(JSON, stream)
+{
+    Bus bus;
+
+    bus.add(Addr{1});
+
+    VirtualPort port{bus};
+    Master master{port};
+    std::istringstream is
+    {
+        "\n"
+        "  \t\n"
+        "{\"slave\": 1, \"fcode\": 6, \"addr\": 0, \"value\": 4660}\r\n"
+        "\r\n"
+        "{\"slave\": 1, \"fcode\": 3, \"addr\": 0, \"count\": 1}\r\n"
+        "\n"
+        /* last line without line feed */
+        "{\"slave\": 1, \"fcode\": 65, \"addr\": 0, \"count\": 2}"
+    };
+    FlushLog log;
+    std::ostream os{&log};
+    /* output written so far when request is executed */
+    std::vector<std::string> before;
+
+    JSON::stream(
+        is, os, Format::JSON,
+        [&](const json &input)
+        {
+            json output;
+
+            before.push_back(log.str());
+            dispatch(master, input, output);
+            return output.front();
+        });
+
+    const std::string replies[] =
+    {
+        R"({"addr":0,"slave":1})" "\n",
+        R"({"addr":0,"count":1,"slave":1,"value":[4660]})" "\n",
+        R"({"addr":0,"count":2,"slave":1,"value":[0,0]})" "\n"
+    };
+
+    /* blank lines are skipped, every reply is flushed before next request */
+    ASSERT_TRUE(3u == before.size());
+    ASSERT_TRUE(3u == log.flushed.size());
+    EXPECT_TRUE("" == before[0]);
+    EXPECT_TRUE(replies[0] == before[1]);
+    EXPECT_TRUE(replies[0] + replies[1] == before[2]);
+    EXPECT_TRUE(before[1] == log.flushed[0]);
+    EXPECT_TRUE(before[2] == log.flushed[1]);
+    EXPECT_TRUE(replies[0] + replies[1] + replies[2] == log.flushed[2]);
+
+    /* malformed line ends stream, preceding replies are already written */
+    std::istringstream malformed{"{\"slave\": 1, \"fcode\": 3, \"addr\": 0, \"count\": 1}\n{\"slave\": \n"};
+    std::ostringstream out;
+    bool thrown = false;
+
+    try
+    {
+        JSON::stream(
+            malformed, out, Format::JSON,
+            [&master](const json &input)
+            {
+                json output;
+
+                dispatch(master, input, output);
+                return output.front();
+            });
+    }
+    catch(const std::exception &)
+    {
+        thrown = true;
+    }
+    EXPECT_TRUE(thrown);
+    EXPECT_TRUE(replies[1] == out.str());
+}
+
+UTEST(JSON, streamBinary)
+{
+    for(const auto format : {Format::CBOR, Format::MsgPack})
+    {
+        Bus bus;
+
+        bus.add(Addr{1});
+
+        VirtualPort port{bus};
+        Master master{port};
+        const auto input = requests(format);
+        std::stringstream is;
+
+        for(const auto &request : input) store(is, request, format);
+
+        std::stringstream os;
+        json expected = json::array();
+
+        JSON::stream(
+            is, os, format,
+            [&](const json &request)
+            {
+                json output;
+
+                dispatch(master, request, output, format);
+                expected.push_back(output.front());
+                return output.front();
+            });
+
+        /* concatenated values - no line feeds */
+        ASSERT_TRUE(input.size() == expected.size());
+        for(const auto &reply : expected) EXPECT_TRUE(reply == load(os, format));
+        EXPECT_TRUE(std::istream::traits_type::eof() == os.peek());
+    }
+}
+
+UTEST_MAIN();
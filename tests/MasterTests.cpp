@@ -0,0 +1,1050 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "Capture.h"
+#include "Delta.h"
+#include "Except.h"
+#include "Frame.h"
+#include "Gateway.h"
+#include "Master.h"
+#include "Plan.h"
+#include "ReadCache.h"
+#include "Recorder.h"
+#include "RequestStats.h"
+#include "ShmImage.h"
+#include "Sniffer.h"
+#include "Slave.h"
+#include "TcpPort.h"
+#include "VirtualPort.h"
+#include "utest.h"
+
+using namespace Modbus::RTU;
+
+namespace {
+
+constexpr const auto timeout = mSecs{100};
+
+Master makeMaster(const Simulator &sim)
+{
+    /* pseudo terminals do not support parity */
+    return Master{sim.device(), Master::BaudRate::BR_19200, Master::Parity::None};
+}
+
+/* MBAP header + PDU */
+Master::ByteSeq mbap(uint16_t tid, uint8_t unit, const Master::ByteSeq &pdu)
+{
+    Master::ByteSeq frame(7 + pdu.size(), 0);
+
+    frame[0] = uint8_t(tid >> 8);
+    frame[1] = uint8_t(tid);
+    frame[4] = uint8_t((pdu.size() + 1) >> 8);
+    frame[5] = uint8_t(pdu.size() + 1);
+    frame[6] = unit;
+    std::copy(std::begin(pdu), std::end(pdu), std::begin(frame) + 7);
+    return frame;
+}
+
+} // namespace
+
+UTEST(Master, registers)
+{
+    Simulator sim{Addr{1}};
+    auto master = makeMaster(sim);
+
+    master.wrRegister(Addr{1}, 10, 0x1234, timeout);
+    master.wrRegisters(Addr{1}, 11, {0xABCD, 0x0001, 0xFFFF}, timeout);
+
+    const auto data = master.rdRegisters(Addr{1}, 10, 4, timeout);
+
+    EXPECT_TRUE((Master::DataSeq{0x1234, 0xABCD, 0x0001, 0xFFFF} == data));
+    EXPECT_TRUE(3u == sim.slave(Addr{1}).requestCntr());
+}
+
+UTEST(Master, coils)
+{
+    Simulator sim{Addr{2}};
+    auto master = makeMaster(sim);
+
+    master.wrCoil(Addr{2}, 100, true, timeout);
+    master.wrCoil(Addr{2}, 102, true, timeout);
+    master.wrCoil(Addr{2}, 109, true, timeout);
+
+    /* coils are packed LSB first, single byte per element */
+    const auto data = master.rdCoils(Addr{2}, 100, 10, timeout);
+
+    EXPECT_TRUE((Master::DataSeq{0x05, 0x02} == data));
+    EXPECT_TRUE(1 == sim.slave(Addr{2}).image().coils[109]);
+}
+
+UTEST(Master, bytes)
+{
+    Simulator sim{Addr{3}};
+    auto master = makeMaster(sim);
+    const Master::ByteSeq message{'m', 'o', 'd', 'b', 'u', 's'};
+
+    master.wrBytes(Addr{3}, 0x1000, message, timeout);
+    EXPECT_TRUE(message == master.rdBytes(Addr{3}, 0x1000, uint8_t(message.size()), timeout));
+    EXPECT_TRUE('m' == sim.slave(Addr{3}).image().bytes[0x1000]);
+}
+
+UTEST(Master, exception)
+{
+    Simulator sim{Addr{4}};
+    auto master = makeMaster(sim);
+    Master::DataSeq data;
+
+    /* 0xFFFF + 2 registers is out of address space */
+    EXPECT_TRUE(Status::Exception == master.tryRdRegisters(Addr{4}, 0xFFFF, 2, data, timeout));
+    EXPECT_TRUE(1u == sim.slave(Addr{4}).exceptionCntr());
+    /* slave is still responsive */
+    EXPECT_TRUE(Status::Ok == master.tryRdRegisters(Addr{4}, 0xFFFE, 2, data, timeout));
+}
+
+UTEST(Master, timeout)
+{
+    Simulator sim{Addr{5}};
+    auto master = makeMaster(sim);
+    Master::DataSeq data;
+
+    EXPECT_TRUE(Status::Timeout == master.tryRdRegisters(Addr{6}, 0, 1, data, mSecs{50}));
+    EXPECT_TRUE(0u == sim.slave(Addr{5}).requestCntr());
+}
+
+UTEST(Master, turnaround)
+{
+    const auto turnaround = std::chrono::milliseconds{20};
+    Simulator sim{Addr{7}, turnaround};
+    auto master = makeMaster(sim);
+
+    (void)master.rdRegisters(Addr{7}, 0, 1, timeout);
+    EXPECT_TRUE(master.timing().turnaround >= turnaround);
+}
+
+UTEST(Master, bus)
+{
+    Slave::Profile dead;
+    Slave::Profile small;
+
+    dead.deadRate = 1.0;
+    small.registerNum = 8;
+
+    Simulator sim{Simulator::Profiles{{1, {}}, {2, dead}, {3, small}}};
+    auto master = makeMaster(sim);
+    Master::DataSeq data;
+
+    EXPECT_TRUE(Status::Ok == master.tryRdRegisters(Addr{1}, 0x1000, 8, data, timeout));
+    EXPECT_TRUE(Status::Timeout == master.tryRdRegisters(Addr{2}, 0, 1, data, mSecs{50}));
+    EXPECT_TRUE(Status::Ok == master.tryRdRegisters(Addr{3}, 0, 8, data, timeout));
+    EXPECT_TRUE(Status::Exception == master.tryRdRegisters(Addr{3}, 4, 8, data, timeout));
+    EXPECT_TRUE(sim.slave(Addr{2}).dead());
+    EXPECT_TRUE(1u == sim.bus().absentCntr());
+}
+
+UTEST(Master, faults)
+{
+    Master::DataSeq data;
+
+    {
+        Faults faults;
+
+        faults[Fault::Drop] = 1.0;
+
+        Simulator sim{Simulator::Profiles{{1, {}}}, faults};
+        auto master = makeMaster(sim);
+
+        EXPECT_TRUE(Status::Timeout == master.tryRdRegisters(Addr{1}, 0, 1, data, mSecs{50}));
+        sim.stop();
+        EXPECT_TRUE(1u == sim.bus().faultCntr(Fault::Drop));
+    }
+
+    {
+        Faults faults;
+
+        /* adapter echo is received instead of reply */
+        faults[Fault::Echo] = 1.0;
+
+        Simulator sim{Simulator::Profiles{{1, {}}}, faults};
+        auto master = makeMaster(sim);
+
+        EXPECT_TRUE(Status::Ok != master.tryRdRegisters(Addr{1}, 0, 1, data, timeout));
+    }
+}
+
+UTEST(Master, oversizedRequest)
+{
+    Simulator sim{Addr{1}};
+
+    {
+        SerialPort port
+        {
+            sim.device(),
+            SerialPort::BaudRate::BR_19200,
+            SerialPort::Parity::None,
+            SerialPort::DataBits::Eight,
+            SerialPort::StopBits::One,
+            nullptr
+        };
+        /* WR_REGISTERS byte count beyond ADU (7 + 255 + CRC > 256) */
+        Master::ByteSeq req(7 + 255 + 2, 0xFF);
+
+        req[0] = 1;
+        req[1] = FCODE_WR_REGISTERS;
+        req[6] = 255;
+        EXPECT_TRUE(req.data() + req.size() == port.write(req.data(), req.data() + req.size(), timeout));
+        port.drain();
+    }
+    std::this_thread::sleep_for(timeout);
+
+    auto master = makeMaster(sim);
+    Master::DataSeq data;
+
+    EXPECT_TRUE(Status::Ok == master.tryRdRegisters(Addr{1}, 0, 1, data, timeout));
+    sim.stop();
+    EXPECT_TRUE(1u == sim.slave(Addr{1}).requestCntr());
+}
+
+UTEST(Master, virtualTime)
+{
+    using namespace std::chrono;
+
+    Bus bus;
+
+    bus.add(Addr{1});
+
+    VirtualPort port{bus, VirtualPort::BaudRate::BR_9600};
+    Master master{port};
+    const auto wallBegin = steady_clock::now();
+    const auto begin = port.now();
+    constexpr const int num = 10000;
+
+    master.wrRegisters(Addr{1}, 0, Master::DataSeq(10, 0xA5A5), timeout);
+    for(int i = 1; i < num; ++i)
+    {
+        EXPECT_TRUE((Master::DataSeq(10, 0xA5A5) == master.rdRegisters(Addr{1}, 0, 10, timeout)));
+    }
+
+    /* request (8) + reply (3 + 20 + 2) characters of 10 bits at 9600bps,
+     * slave silent interval and Master inter-frame gap are below 10ms */
+    const auto elapsed = duration_cast<microseconds>(port.now() - begin) / num;
+    const auto wire = microseconds{33 * 10 * 1000000 / 9600};
+
+    EXPECT_TRUE(elapsed >= wire);
+    EXPECT_TRUE(elapsed < wire + milliseconds{10});
+    /* ~7 minutes of bus traffic */
+    EXPECT_TRUE(steady_clock::now() - wallBegin < seconds{60});
+    EXPECT_TRUE(uint64_t(num) == bus.slave(Addr{1}).requestCntr());
+}
+
+UTEST(Master, virtualTimeout)
+{
+    using namespace std::chrono;
+
+    Bus bus;
+    VirtualPort port{bus};
+    Master master{port};
+    Master::DataSeq data;
+    const auto wallBegin = steady_clock::now();
+    const auto begin = port.now();
+
+    EXPECT_TRUE(Status::Timeout == master.tryRdRegisters(Addr{1}, 0, 1, data, hours{1}));
+    EXPECT_TRUE(port.now() - begin >= hours{1});
+    EXPECT_TRUE(steady_clock::now() - wallBegin < seconds{1});
+}
+
+UTEST(Master, tcp)
+{
+    Bus bus;
+    TcpListener listener{"127.0.0.1", 0};
+
+    bus.add(Addr{1});
+
+    /* stand-in for serial device server */
+    std::thread server{
+        [&]()
+        {
+            auto fdGuard = listener.accept(mSecs{1000});
+
+            if(!fdGuard) return;
+
+            TcpPort connection{std::move(fdGuard)};
+
+            bus.port(&connection);
+            /* until connection is closed by Master */
+            try
+            {
+                for(;;) bus.serve(mSecs{10});
+            }
+            catch(const std::exception &) {}
+            bus.port(nullptr);
+        }};
+
+    {
+        Master master{"tcp://127.0.0.1:" + std::to_string(listener.port())};
+
+        master.wrRegisters(Addr{1}, 0x100, {1, 2, 3}, timeout);
+        EXPECT_TRUE((Master::DataSeq{1, 2, 3} == master.rdRegisters(Addr{1}, 0x100, 3, timeout)));
+        /* no silent interval and drain over TCP */
+        EXPECT_TRUE(!master.transport().paced());
+    }
+
+    server.join();
+    EXPECT_TRUE(2u == bus.slave(Addr{1}).requestCntr());
+}
+
+UTEST(Master, gateway)
+{
+    Simulator sim{Addr{1}};
+    auto master = makeMaster(sim);
+    Gateway::Config config;
+    Gateway gateway{master, "127.0.0.1:0", config};
+    const auto device = "tcp://127.0.0.1:" + std::to_string(gateway.port());
+    TcpPort a{device, mSecs{1000}};
+    TcpPort b{device, mSecs{1000}};
+    const auto transmit =
+        [](TcpPort &client, const Master::ByteSeq &frame)
+        {
+            return frame.data() + frame.size() == client.write(frame.data(), frame.data() + frame.size(), timeout);
+        };
+    const auto receive =
+        [](TcpPort &client, std::size_t size)
+        {
+            Master::ByteSeq frame(size, 0);
+
+            frame.resize(client.read(frame.data(), frame.data() + frame.size(), timeout) - frame.data());
+            return frame;
+        };
+
+    master.wrRegisters(Addr{1}, 0, {0x1234, 0x5678}, timeout);
+    gateway.step(mSecs{100});
+    EXPECT_TRUE(2u == gateway.clientNum());
+
+    /* identical reads - single bus transaction, replied with own tid */
+    EXPECT_TRUE(transmit(a, mbap(0x0A01, 1, {3, 0, 0, 0, 2})));
+    EXPECT_TRUE(transmit(b, mbap(0x0B01, 1, {3, 0, 0, 0, 2})));
+    /* unsupported function */
+    EXPECT_TRUE(transmit(b, mbap(0x0B02, 1, {43, 14, 1, 0})));
+    for(int i = 0; i < 10 && 1u > gateway.stats().transactions; ++i) gateway.step(mSecs{10});
+
+    EXPECT_TRUE((mbap(0x0A01, 1, {3, 4, 0x12, 0x34, 0x56, 0x78}) == receive(a, 13)));
+    /* rejected without bus transaction - replied out of order (matched by tid) */
+    EXPECT_TRUE((mbap(0x0B02, 1, {43 | 0x80, 1}) == receive(b, 9)));
+    EXPECT_TRUE((mbap(0x0B01, 1, {3, 4, 0x12, 0x34, 0x56, 0x78}) == receive(b, 13)));
+    EXPECT_TRUE(1u == gateway.stats().deduplicated);
+    EXPECT_TRUE(1u == gateway.stats().transactions);
+
+    /* write, absent slave */
+    EXPECT_TRUE(transmit(a, mbap(0x0A02, 1, {6, 0, 1, 0xAB, 0xCD})));
+    EXPECT_TRUE(transmit(a, mbap(0x0A03, 2, {3, 0, 0, 0, 1})));
+    for(int i = 0; i < 10 && 3u > gateway.stats().transactions; ++i) gateway.step(mSecs{10});
+
+    EXPECT_TRUE((mbap(0x0A02, 1, {6, 0, 1, 0xAB, 0xCD}) == receive(a, 12)));
+    EXPECT_TRUE((mbap(0x0A03, 2, {3 | 0x80, 0x0B}) == receive(a, 9)));
+    EXPECT_TRUE(0xABCD == sim.slave(Addr{1}).image().registers[1]);
+
+    /* b: read pending behind another read, a: write then the same read -
+     * read of a is not merged into (earlier executed) read of b */
+    auto reads = mbap(0x0B03, 1, {3, 0, 10, 0, 1});
+    const auto read = mbap(0x0B04, 1, {3, 0, 0, 0, 1});
+
+    reads.insert(std::end(reads), std::begin(read), std::end(read));
+    EXPECT_TRUE(transmit(b, reads));
+    gateway.step(mSecs{100});
+    EXPECT_TRUE(4u == gateway.stats().transactions);
+    EXPECT_TRUE(transmit(a, mbap(0x0A04, 1, {6, 0, 0, 0x43, 0x21})));
+    EXPECT_TRUE(transmit(a, mbap(0x0A05, 1, {3, 0, 0, 0, 1})));
+    for(int i = 0; i < 10 && 7u > gateway.stats().transactions; ++i) gateway.step(mSecs{10});
+
+    EXPECT_TRUE(11u == receive(b, 11).size());
+    EXPECT_TRUE((mbap(0x0B04, 1, {3, 2, 0x12, 0x34}) == receive(b, 11)));
+    EXPECT_TRUE((mbap(0x0A04, 1, {6, 0, 0, 0x43, 0x21}) == receive(a, 12)));
+    EXPECT_TRUE((mbap(0x0A05, 1, {3, 2, 0x43, 0x21}) == receive(a, 11)));
+    EXPECT_TRUE(1u == gateway.stats().deduplicated);
+    EXPECT_TRUE(7u == gateway.stats().transactions);
+}
+
+UTEST(Master, shmImage)
+{
+    Bus bus;
+
+    bus.add(Addr{1});
+
+    VirtualPort port{bus};
+    Master master{port};
+    Plan plan;
+
+    plan.rdRegisters(Addr{1}, 0, 8, timeout, 1);
+    plan.wrRegister(Addr{1}, 8, 1, timeout, 1);
+    plan.rdCoils(Addr{1}, 0, 10, timeout, 1);
+    /* absent slave */
+    plan.rdBytes(Addr{2}, 0, 4, timeout, 1);
+
+    Executor executor{master, plan};
+    ShmImage writer{"/MasterTests.shmImage", plan};
+    const ShmImage reader{"/MasterTests.shmImage"};
+    std::atomic<bool> done{false};
+    std::atomic<int> torn{0};
+    auto &image = bus.slave(Addr{1}).image();
+
+    EXPECT_TRUE(3u == reader.blockNum());
+    EXPECT_TRUE(0u == reader.find(1, FCODE_RD_HOLDING_REGISTERS, 7));
+    EXPECT_TRUE(ShmImage::npos == reader.find(1, FCODE_RD_HOLDING_REGISTERS, 8));
+    EXPECT_TRUE(2u == reader.find(2, FCODE_RD_BYTES, 0));
+
+    /* every cycle all registers have the same value - reader never sees mix */
+    std::thread thread
+    {
+        [&reader, &done, &torn]()
+        {
+            uint16_t data[8];
+
+            while(!done)
+            {
+                reader.read(0, reinterpret_cast<uint8_t *>(data));
+                if(!std::all_of(data, data + 8, [&data](uint16_t v) { return data[0] == v; })) ++torn;
+            }
+        }
+    };
+
+    image.coils[3] = 1;
+    for(uint16_t cycle = 1; cycle <= 2000; ++cycle)
+    {
+        std::fill_n(std::begin(image.registers), 8, cycle);
+        for(std::size_t i = 0; i < plan.size(); ++i) writer.publish(executor, i, executor.tryExec(i));
+        writer.heartbeat();
+    }
+    done = true;
+    thread.join();
+    ShmImage::remove("/MasterTests.shmImage");
+
+    uint16_t data[8];
+    const auto state = reader.read(0, reinterpret_cast<uint8_t *>(data));
+
+    EXPECT_TRUE(0 == torn);
+    EXPECT_TRUE(2000u == reader.cycles());
+    EXPECT_TRUE(ShmImage::Quality::Good == state.quality);
+    EXPECT_TRUE(2000 == data[7]);
+    /* coils unpacked - byte per coil */
+    EXPECT_TRUE(10u == reader.block(1).size);
+    EXPECT_TRUE(1 == reader.data(1)[3] && 0 == reader.data(1)[4]);
+    EXPECT_TRUE(ShmImage::Quality::None == reader.state(2).quality);
+    EXPECT_TRUE(2000u == reader.state(2).failures);
+}
+
+UTEST(Master, readCache)
+{
+    Bus bus;
+
+    bus.add(Addr{1});
+
+    VirtualPort port{bus};
+    Master master{port};
+    ReadCache cache{mSecs{500}};
+    const auto &slave = bus.slave(Addr{1});
+    auto &image = bus.slave(Addr{1}).image();
+
+    /* never cached */
+    cache.rule(0, ReadCache::Space::Registers, 100, 10, mSecs{0});
+    cache.rule(0, ReadCache::Space::Registers, 90, 10, mSecs{5000});
+    master.cache(&cache);
+    for(uint16_t i = 0; i < 16; ++i) image.registers[i] = 0x100 + i;
+    for(uint16_t i = 0; i < 24; ++i) image.coils[i] = i % 3 ? 1 : 0;
+
+    EXPECT_TRUE((Master::DataSeq{0x100, 0x101, 0x102} == master.rdRegisters(Addr{1}, 0, 3, timeout)));
+    EXPECT_TRUE(1u == slave.requestCntr());
+    /* covered by single range, then by contiguous ranges */
+    EXPECT_TRUE((Master::DataSeq{0x101, 0x102} == master.rdRegisters(Addr{1}, 1, 2, timeout)));
+    EXPECT_TRUE((Master::DataSeq{0x103, 0x104} == master.rdRegisters(Addr{1}, 3, 2, timeout)));
+    EXPECT_TRUE((Master::DataSeq{0x102, 0x103, 0x104} == master.rdRegisters(Addr{1}, 2, 3, timeout)));
+    EXPECT_TRUE(2u == slave.requestCntr());
+
+    /* packed coils of cached sub-range */
+    master.cache(nullptr);
+
+    const auto coils = master.rdCoils(Addr{1}, 5, 11, timeout);
+
+    master.cache(&cache);
+    master.rdCoils(Addr{1}, 0, 24, timeout);
+    EXPECT_TRUE(coils == master.rdCoils(Addr{1}, 5, 11, timeout));
+    EXPECT_TRUE(4u == slave.requestCntr());
+
+    /* write (transaction 5) invalidates overlapped part only */
+    master.wrRegister(Addr{1}, 1, 0xABCD, timeout);
+    EXPECT_TRUE((Master::DataSeq{0x100} == master.rdRegisters(Addr{1}, 0, 1, timeout)));
+    EXPECT_TRUE(5u == slave.requestCntr());
+    EXPECT_TRUE((Master::DataSeq{0xABCD, 0x102} == master.rdRegisters(Addr{1}, 1, 2, timeout)));
+    EXPECT_TRUE(6u == slave.requestCntr());
+
+    /* TTL expired */
+    port.sleepFor(mSecs{500});
+    master.rdRegisters(Addr{1}, 0, 1, timeout);
+    EXPECT_TRUE(7u == slave.requestCntr());
+
+    /* zero TTL rule */
+    master.rdRegisters(Addr{1}, 100, 2, timeout);
+    master.rdRegisters(Addr{1}, 100, 2, timeout);
+    EXPECT_TRUE(9u == slave.requestCntr());
+    EXPECT_TRUE(4u == cache.stats().hits);
+
+    /* read spanning rules: [95, 100) cached, [100, 105) never */
+    master.rdRegisters(Addr{1}, 95, 10, timeout);
+    master.rdRegisters(Addr{1}, 95, 5, timeout);
+    EXPECT_TRUE(10u == slave.requestCntr());
+    master.rdRegisters(Addr{1}, 100, 2, timeout);
+    EXPECT_TRUE(11u == slave.requestCntr());
+    /* default TTL of part not covered by rules */
+    master.rdRegisters(Addr{1}, 108, 4, timeout);
+    master.rdRegisters(Addr{1}, 110, 2, timeout);
+    EXPECT_TRUE(12u == slave.requestCntr());
+    EXPECT_TRUE(6u == cache.stats().hits);
+}
+
+UTEST(Master, delta)
+{
+    Bus bus;
+
+    bus.add(Addr{1});
+
+    VirtualPort port{bus};
+    Master master{port};
+    Plan plan;
+
+    plan.rdRegisters(Addr{1}, 0, 20, timeout, 1);
+    plan.wrRegister(Addr{1}, 30, 1, timeout, 1);
+    plan.rdBytes(Addr{1}, 0, 41, timeout, 1);
+
+    Executor executor{master, plan};
+    Delta delta{plan};
+    auto &image = bus.slave(Addr{1}).image();
+    std::vector<uint32_t> index;
+    const auto cycle =
+        [&executor, &delta, &index](std::size_t i)
+        {
+            executor.exec(i);
+            return delta.update(executor, i, index);
+        };
+
+    /* first update - every element */
+    EXPECT_TRUE(20u == cycle(0));
+    EXPECT_TRUE(0u == cycle(1));
+    EXPECT_TRUE(41u == cycle(2));
+    EXPECT_TRUE(0u == cycle(0));
+
+    /* within compared word, in other word and in tail (beyond last word) */
+    image.registers[3] = 0x0100;
+    image.registers[17] = 0x0001;
+    image.bytes[7] = 0xFF;
+    image.bytes[40] = 0xFF;
+    EXPECT_TRUE(2u == cycle(0));
+    EXPECT_TRUE((std::vector<uint32_t>{3, 17} == index));
+    EXPECT_TRUE(2u == cycle(2));
+    EXPECT_TRUE((std::vector<uint32_t>{7, 40} == index));
+    EXPECT_TRUE(0u == cycle(2));
+
+    delta.reset();
+    EXPECT_TRUE(20u == cycle(0));
+}
+
+UTEST(Master, recorder)
+{
+    Bus bus;
+
+    bus.add(Addr{1});
+
+    VirtualPort port{bus};
+    Master master{port};
+    Plan plan;
+
+    plan.rdRegisters(Addr{1}, 0, 10, timeout, 1);
+    plan.wrRegister(Addr{1}, 30, 1, timeout, 1);
+
+    const std::string dir = "/tmp";
+    const auto path = dir + '/' + Recorder::name(1, FCODE_RD_HOLDING_REGISTERS, 0, 10);
+    Executor executor{master, plan};
+    auto &image = bus.slave(Addr{1}).image();
+    const int64_t start = 1000000;
+
+    std::remove(path.c_str());
+
+    /* several blocks, reopened file is appended to */
+    for(int n = 0; n < 2; ++n)
+    {
+        Recorder recorder{dir, plan};
+
+        for(int64_t k = 0; k < 2000; ++k)
+        {
+            image.registers[k % 10] = uint16_t(n * 2000 + k);
+            for(std::size_t i = 0; i < plan.size(); ++i)
+            {
+                recorder.record(executor, i, executor.tryExec(i), start + (n * 2000 + k) * 100);
+            }
+        }
+    }
+
+    const SeriesReader reader{path};
+    const auto info = reader.info();
+
+    EXPECT_TRUE(10u == info.elementNum);
+    EXPECT_TRUE(4000u == info.sampleNum);
+    EXPECT_TRUE(1u < info.blockNum);
+    EXPECT_TRUE(start == info.first);
+    EXPECT_TRUE(start + 3999 * 100 == info.last);
+
+    std::vector<std::pair<int64_t, std::vector<uint16_t>>> samples;
+
+    reader.forEach(
+        start + 2995 * 100, start + 3005 * 100,
+        [&samples](int64_t timestamp, const std::vector<uint16_t> &values)
+        {
+            samples.emplace_back(timestamp, values);
+        });
+    ASSERT_TRUE(11u == samples.size());
+    for(int64_t k = 2995; k <= 3005; ++k)
+    {
+        const auto &sample = samples[k - 2995];
+
+        EXPECT_TRUE(start + k * 100 == sample.first);
+        EXPECT_TRUE(uint16_t(k) == sample.second[k % 10]);
+        EXPECT_TRUE(uint16_t(k - 1) == sample.second[(k - 1) % 10]);
+    }
+    std::remove(path.c_str());
+}
+
+UTEST(Master, sniffer)
+{
+    using Clock = Sniffer::Clock;
+
+    constexpr auto req = makeRequest<FCODE_RD_HOLDING_REGISTERS>(1, 0, 2);
+    constexpr auto rep = appendCRC(Frame<7>{1, FCODE_RD_HOLDING_REGISTERS, 4, 0, 1, 0, 2});
+    constexpr auto bytesReq = makeRequest<FCODE_RD_BYTES>(2, 0, 2);
+    constexpr auto bytesRep = appendCRC(Frame<7>{2, FCODE_RD_BYTES, 0, 0, 2, 0xAA, 0x55});
+    Sniffer sniffer{uSecs{100}};
+    auto t = Clock::time_point{} + std::chrono::seconds{1};
+    const auto segment =
+        [&sniffer, &t](std::vector<uint8_t> data, uSecs gap)
+        {
+            const auto begin = t + gap;
+
+            t = begin + uSecs{100} * int64_t(data.size());
+            sniffer.segment(data.data(), data.size(), begin, t);
+        };
+    const auto bytes =
+        [](const auto &frame)
+        {
+            return std::vector<uint8_t>(std::begin(frame), std::end(frame));
+        };
+    auto merged = bytes(bytesReq);
+    auto corrupted = bytes(rep);
+    std::vector<uint8_t> garbage{0xFF, 0x01, 0x03};
+
+    merged.insert(std::end(merged), std::begin(bytesRep), std::end(bytesRep));
+    corrupted[4] ^= 0x1;
+    garbage.insert(std::end(garbage), std::begin(req), std::end(req));
+    garbage.insert(std::end(garbage), std::begin(rep), std::end(rep));
+
+    /* request and reply separated by silence */
+    segment(bytes(req), uSecs{5000});
+    segment(bytes(rep), uSecs{2000});
+    /* merged into one segment, split by size and CRC */
+    segment(merged, uSecs{5000});
+    /* no reply - retry of the same request is not its reply */
+    segment(bytes(req), uSecs{5000});
+    segment(bytes(req), uSecs{5000});
+    segment(corrupted, uSecs{2000});
+    /* bytes before valid frames are skipped */
+    segment(garbage, uSecs{5000});
+
+    const auto &slave1 = sniffer.slaves().at(1);
+    const auto &slave2 = sniffer.slaves().at(2);
+
+    EXPECT_TRUE(10u == sniffer.stats().frames);
+    EXPECT_TRUE(2u == sniffer.stats().crcErrors);
+    EXPECT_TRUE(4u == slave1.requests);
+    EXPECT_TRUE(2u == slave1.replies);
+    EXPECT_TRUE(1u == slave1.noReplies);
+    EXPECT_TRUE(1u == slave1.crcErrors);
+    EXPECT_TRUE(uSecs{2000} == slave1.turnaround.max());
+    EXPECT_TRUE(1u == slave2.requests);
+    EXPECT_TRUE(1u == slave2.replies);
+    EXPECT_TRUE(uSecs{0} == slave2.turnaround.max());
+}
+
+UTEST(Master, capture)
+{
+    using Clock = CaptureWriter::Clock;
+
+    const std::string path = "/tmp/capture.bin";
+    std::vector<uint8_t> data(60000);
+    Clock::time_point start;
+
+    /* more than single writer window (8MiB) */
+    {
+        CaptureWriter writer{path, 115200, 11};
+
+        start = Clock::now();
+        for(std::size_t i = 0; i < 150; ++i)
+        {
+            std::fill(std::begin(data), std::end(data), uint8_t(i));
+            writer.write(start + std::chrono::microseconds(i * 100), data.data(), data.data() + data.size() - i);
+        }
+        /* empty chunk is not recorded */
+        writer.write(start, data.data(), data.data());
+    }
+
+    CaptureReader reader{path};
+    CaptureReader::Chunk chunk;
+    std::size_t n = 0;
+    bool valid = true;
+
+    EXPECT_TRUE(115200u == reader.header().bitRate);
+    EXPECT_TRUE(11u == reader.header().bitsPerChar);
+    EXPECT_TRUE(uSecs{1750} == reader.header().silentInterval());
+    for(; reader.next(chunk); ++n)
+    {
+        valid =
+            valid
+            && data.size() - n == chunk.size
+            && std::all_of(chunk.data, chunk.data + chunk.size, [n](uint8_t b) { return uint8_t(n) == b; });
+        if(0 == n % 50) EXPECT_TRUE(int64_t(n * 100000) <= chunk.timestamp);
+    }
+    EXPECT_TRUE(valid);
+    EXPECT_TRUE(150u == n);
+
+    reader.rewind();
+    EXPECT_TRUE(reader.next(chunk));
+    EXPECT_TRUE(data.size() == chunk.size);
+    std::remove(path.c_str());
+}
+
+UTEST(Master, frameLog)
+{
+    using Direction = FrameLog::Direction;
+
+    FrameLog log{4};
+    const auto start = FrameLog::Clock::now();
+
+    /* 6 records into 4 slots - oldest 2 are overwritten */
+    for(uint8_t i = 0; i < 6; ++i)
+    {
+        const uint8_t data[] = {1, 3, i};
+
+        log.record(
+            i & 1 ? Direction::Rx : Direction::Tx,
+            start + std::chrono::microseconds(i * 100), std::chrono::microseconds(50),
+            i & 1 ? Status::Ok : Status::Timeout,
+            data, data + sizeof(data));
+    }
+    EXPECT_TRUE(6u == log.written());
+
+    std::vector<FrameLog::Record> records;
+
+    log.forEach([&records](const FrameLog::Record &record) { records.push_back(record); });
+    ASSERT_TRUE(4u == records.size());
+    for(std::size_t k = 0; k < records.size(); ++k)
+    {
+        EXPECT_TRUE(3u == records[k].size);
+        EXPECT_TRUE(k + 2 == records[k].data[2]);
+        EXPECT_TRUE((k & 1 ? Direction::Rx : Direction::Tx) == records[k].direction);
+        EXPECT_TRUE(50u == records[k].duration);
+    }
+    records.clear();
+    log.forEach([&records](const FrameLog::Record &record) { records.push_back(record); }, 2);
+    ASSERT_TRUE(2u == records.size());
+    EXPECT_TRUE(4u == records[0].data[2]);
+
+    /* binary form decodes to the same text as dump() */
+    std::stringstream binary;
+    std::ostringstream decoded, dumped;
+
+    log.store(binary);
+    FrameLog::decode(binary, decoded);
+    log.dump(dumped);
+    EXPECT_TRUE(!decoded.str().empty());
+    EXPECT_TRUE(dumped.str() == decoded.str());
+
+    /* truncated record is rejected */
+    auto truncated = binary.str();
+    auto rejected = false;
+
+    truncated.pop_back();
+    try
+    {
+        std::istringstream is{truncated};
+        std::ostringstream os;
+
+        FrameLog::decode(is, os);
+    }
+    catch(const std::exception &)
+    {
+        rejected = true;
+    }
+    EXPECT_TRUE(rejected);
+}
+
+UTEST(Master, timing)
+{
+    using namespace std::chrono;
+
+    Bus bus;
+
+    bus.add(Addr{1}, Slave::Profile{uSecs{2000}});
+
+    VirtualPort port{bus};
+    Master master{port};
+    constexpr const int num = 10;
+    Master::DataSeq data;
+
+    for(int i = 0; i < num; ++i)
+    {
+        EXPECT_TRUE(Status::Ok == master.tryRdRegisters(Addr{1}, 0, 2, data, timeout));
+    }
+
+    /* request 8, reply 3 + 4 + 2 characters, first reply character arrives
+     * after slave silent interval (3.5t), turnaround and its own wire time */
+    const auto charTime = port.charTime();
+    const auto drain = duration_cast<uSecs>(charTime * 8);
+    const auto turnaround = duration_cast<uSecs>(charTime * 7 / 2 + uSecs{2000} + charTime);
+    const auto receive = duration_cast<uSecs>(charTime * 8);
+    const auto last = master.timing();
+
+    EXPECT_TRUE(1u == last.slave);
+    EXPECT_TRUE(FCODE_RD_HOLDING_REGISTERS == last.fcode);
+    EXPECT_TRUE(Status::Ok == last.status);
+    EXPECT_TRUE(uSecs{0} == last.write);
+    EXPECT_TRUE(1 >= std::abs((last.drain - drain).count()));
+    EXPECT_TRUE(1 >= std::abs((last.turnaround - turnaround).count()));
+    EXPECT_TRUE(1 >= std::abs((last.receive - receive).count()));
+    EXPECT_TRUE(last.gap + last.flush + last.write + last.drain
+        + last.turnaround + last.receive + last.crc == last.total());
+
+    /* absent slave - whole timeout is turnaround */
+    EXPECT_TRUE(Status::Timeout == master.tryRdRegisters(Addr{2}, 0, 2, data, timeout));
+    EXPECT_TRUE(Status::Timeout == master.timing().status);
+    EXPECT_TRUE(duration_cast<uSecs>(timeout) == master.timing().turnaround);
+    EXPECT_TRUE(uSecs{0} == master.timing().receive);
+
+    const auto &entries = master.timingStats().entries();
+    using Phase = TimingStats::Phase;
+
+    ASSERT_TRUE(2u == entries.size());
+
+    const auto &ok = entries.at(uint16_t(1 << 8 | FCODE_RD_HOLDING_REGISTERS));
+    const auto &timedOut = entries.at(uint16_t(2 << 8 | FCODE_RD_HOLDING_REGISTERS));
+
+    EXPECT_TRUE(uint64_t(num) == ok.statuses[std::size_t(Status::Ok)]);
+    EXPECT_TRUE(0u == ok.statuses[std::size_t(Status::Timeout)]);
+    EXPECT_TRUE(1u == timedOut.statuses[std::size_t(Status::Timeout)]);
+    for(const auto &phase : ok.phases) EXPECT_TRUE(uint64_t(num) == phase.count());
+    for(const auto &phase : timedOut.phases) EXPECT_TRUE(1u == phase.count());
+
+    /* virtual clock - every transaction takes exactly the same time */
+    EXPECT_TRUE(ok[Phase::Turnaround].min() == ok[Phase::Turnaround].max());
+    EXPECT_TRUE(last.turnaround == ok[Phase::Turnaround].percentile(0.5));
+    EXPECT_TRUE(last.receive == ok[Phase::Receive].percentile(0.99));
+    EXPECT_TRUE(last.drain == ok[Phase::Drain].mean());
+    EXPECT_TRUE(duration_cast<uSecs>(timeout) == timedOut[Phase::Turnaround].max());
+    EXPECT_TRUE(uSecs{0} == timedOut[Phase::Receive].max());
+
+    master.clearTimingStats();
+    EXPECT_TRUE(master.timingStats().entries().empty());
+}
+
+UTEST(Histogram, percentiles)
+{
+    Histogram empty;
+
+    EXPECT_TRUE(0u == empty.count());
+    EXPECT_TRUE(uSecs{0} == empty.min());
+    EXPECT_TRUE(uSecs{0} == empty.max());
+    EXPECT_TRUE(uSecs{0} == empty.mean());
+    EXPECT_TRUE(uSecs{0} == empty.percentile(0.5));
+
+    /* values below 2^SUB_BITS have buckets of their own - exact */
+    Histogram exact;
+
+    for(int i = 0; i < int(Histogram::SUB_NUM); ++i) exact.record(uSecs{i});
+    EXPECT_TRUE(uSecs{0} == exact.percentile(0.0));
+    EXPECT_TRUE(uSecs{7} == exact.percentile(0.5));
+    EXPECT_TRUE(uSecs{15} == exact.percentile(1.0));
+
+    /* uniform 1..1000us, halves recorded separately and merged */
+    Histogram uniform;
+    Histogram upper;
+
+    for(int i = 1; i <= 500; ++i) uniform.record(uSecs{i});
+    for(int i = 501; i <= 1000; ++i) upper.record(uSecs{i});
+    uniform.merge(upper);
+
+    EXPECT_TRUE(1000u == uniform.count());
+    EXPECT_TRUE(uSecs{1} == uniform.min());
+    EXPECT_TRUE(uSecs{1000} == uniform.max());
+    EXPECT_TRUE(uSecs{500} == uniform.mean());
+    /* reported value is the highest one of its bucket:
+     * not below exact one, at most 1/16 above it */
+    for(const auto q : {0.1, 0.5, 0.9, 0.99, 0.999})
+    {
+        const auto expected = int64_t(q * 1000 + 0.5);
+        const auto reported = uniform.percentile(q).count();
+
+        EXPECT_TRUE(expected <= reported);
+        EXPECT_TRUE(reported <= expected + expected / int64_t(Histogram::SUB_NUM));
+    }
+    EXPECT_TRUE(uSecs{511} == uniform.percentile(0.5));
+    EXPECT_TRUE(uSecs{991} == uniform.percentile(0.99));
+    EXPECT_TRUE(uSecs{1000} == uniform.percentile(1.0));
+
+    /* long tail: 99% at 100us, 1% at 10ms */
+    Histogram tail;
+
+    for(int i = 0; i < 990; ++i) tail.record(uSecs{100});
+    for(int i = 0; i < 10; ++i) tail.record(uSecs{10000});
+    EXPECT_TRUE(uSecs{199} == tail.mean());
+    EXPECT_TRUE(uSecs{103} == tail.percentile(0.5));
+    EXPECT_TRUE(uSecs{103} == tail.percentile(0.99));
+    /* highest bucket value is capped by maximum */
+    EXPECT_TRUE(uSecs{10000} == tail.percentile(0.999));
+
+    /* negative durations (clock adjustments) count as 0 */
+    Histogram negative;
+
+    negative.record(uSecs{-5});
+    EXPECT_TRUE(uSecs{0} == negative.max());
+    EXPECT_TRUE(uSecs{0} == negative.percentile(0.5));
+
+    tail.clear();
+    EXPECT_TRUE(0u == tail.count());
+    EXPECT_TRUE(uSecs{0} == tail.percentile(0.99));
+}
+
+UTEST(Master, requestStats)
+{
+    Bus bus;
+
+    bus.add(Addr{1});
+
+    VirtualPort port{bus};
+    Master master{port};
+    Plan plan;
+
+    plan.rdRegisters(Addr{1}, 0, 4, timeout, 1);
+    plan.wrRegisters(Addr{1}, 10, Master::DataSeq{1, 2, 3}, timeout, 1);
+    plan.rdRegisters(Addr{2}, 0, 1, timeout, 3);
+
+    Executor executor{master, plan};
+    std::vector<RequestStats> stats(plan.size());
+    constexpr const int num = 5;
+
+    for(int i = 0; i < num; ++i)
+    {
+        exec(master, executor, 0, port.now(), stats[0]);
+        exec(master, executor, 1, port.now(), stats[1]);
+    }
+
+    for(std::size_t i = 0; i < 2; ++i)
+    {
+        EXPECT_TRUE(uint64_t(num) == stats[i].statuses[std::size_t(Status::Ok)]);
+        EXPECT_TRUE(0u == stats[i].errors());
+        EXPECT_TRUE(0u == stats[i].retries);
+        EXPECT_TRUE(uint64_t(num) == stats[i].latency.count());
+        EXPECT_TRUE(uint64_t(num) == stats[i].response.count());
+        EXPECT_TRUE(uSecs{0} == stats[i].queue.max());
+        EXPECT_TRUE(stats[i].latency.min() <= stats[i].response.min());
+    }
+    EXPECT_TRUE(uint64_t(num) * 8 == stats[0].payload);
+    EXPECT_TRUE(uint64_t(num) * 6 == stats[1].payload);
+
+    /* absent slave: every attempt is accounted, last failure is thrown,
+     * retries wait for timeout on transport clock */
+    const auto begin = port.now();
+    bool thrown = false;
+
+    try
+    {
+        exec(master, executor, 2, begin, stats[2]);
+    }
+    catch(const TimeoutError &)
+    {
+        thrown = true;
+    }
+    EXPECT_TRUE(thrown);
+    EXPECT_TRUE(3u == stats[2].statuses[std::size_t(Status::Timeout)]);
+    EXPECT_TRUE(3u == stats[2].errors());
+    EXPECT_TRUE(2u == stats[2].retries);
+    EXPECT_TRUE(0u == stats[2].latency.count());
+    EXPECT_TRUE(0u == stats[2].response.count());
+    EXPECT_TRUE(1u == stats[2].queue.count());
+    EXPECT_TRUE(0u == stats[2].payload);
+    EXPECT_TRUE(port.now() - begin >= 5 * timeout);
+
+    RequestStats total;
+
+    for(const auto &s : stats) total.merge(s);
+    EXPECT_TRUE(uint64_t(2 * num) == total.statuses[std::size_t(Status::Ok)]);
+    EXPECT_TRUE(3u == total.errors());
+    EXPECT_TRUE(2u == total.retries);
+    EXPECT_TRUE(uint64_t(num) * 14 == total.payload);
+    EXPECT_TRUE(uint64_t(2 * num) == total.latency.count());
+    EXPECT_TRUE(uint64_t(2 * num + 1) == total.queue.count());
+}
+
+UTEST(Frame, makeRequest)
+{
+    /* arguments are not constant expressions - frames are built at run time */
+    struct Vector
+    {
+        uint8_t fcode;
+        uint8_t slave;
+        uint16_t memAddr;
+        uint16_t arg;
+        Frame<8> adu;
+        std::size_t size;
+    };
+
+    const Vector vectors[] =
+    {
+        {FCODE_RD_HOLDING_REGISTERS, 0x01, 0x0000, 0x0001, {0x01, 0x03, 0x00, 0x00, 0x00, 0x01, 0x84, 0x0A}, 8},
+        {FCODE_RD_HOLDING_REGISTERS, 0x01, 0x0000, 0x000A, {0x01, 0x03, 0x00, 0x00, 0x00, 0x0A, 0xC5, 0xCD}, 8},
+        {FCODE_RD_HOLDING_REGISTERS, 0x11, 0x006B, 0x0003, {0x11, 0x03, 0x00, 0x6B, 0x00, 0x03, 0x76, 0x87}, 8},
+        {FCODE_RD_COILS, 0x01, 0x0000, 0x000A, {0x01, 0x01, 0x00, 0x00, 0x00, 0x0A, 0xBC, 0x0D}, 8},
+        {FCODE_WR_COIL, 0x01, 0x0000, 0x0001, {0x01, 0x05, 0x00, 0x00, 0xFF, 0x00, 0x8C, 0x3A}, 8},
+        {FCODE_WR_REGISTER, 0x01, 0x0001, 0x0003, {0x01, 0x06, 0x00, 0x01, 0x00, 0x03, 0x98, 0x0B}, 8},
+        {FCODE_RD_BYTES, 0x01, 0x0004, 0x0010, {0x01, 0x41, 0x00, 0x04, 0x10, 0x0E, 0xF0}, 7}
+    };
+    /* capacity below number of distinct requests - cache is cleared on the way */
+    FrameCache cache{2};
+
+    for(const auto &v : vectors)
+    {
+        const auto req = cache.request(v.fcode, v.slave, v.memAddr, v.arg);
+
+        EXPECT_TRUE(v.size == std::size_t(req.end() - req.begin()));
+        EXPECT_TRUE(std::equal(req.begin(), req.end(), v.adu.data()));
+        /* CRC over whole ADU (CRC included) is 0 */
+        EXPECT_TRUE(0 == calcCRC(req.begin(), req.end()).value);
+        EXPECT_TRUE(2u >= cache.size());
+    }
+
+    const auto rdRegisters = makeRequest<FCODE_RD_HOLDING_REGISTERS>(vectors[2].slave, vectors[2].memAddr, vectors[2].arg);
+    const auto rdBytes = makeRequest<FCODE_RD_BYTES>(vectors[6].slave, vectors[6].memAddr, vectors[6].arg);
+
+    EXPECT_TRUE(std::equal(rdRegisters.begin(), rdRegisters.end(), vectors[2].adu.data()));
+    EXPECT_TRUE(7u == rdBytes.size());
+    EXPECT_TRUE(std::equal(rdBytes.begin(), rdBytes.end(), vectors[6].adu.data()));
+
+    /* any non zero value switches coil on */
+    const auto coilOn = makeRequest<FCODE_WR_COIL>(1, 0, 0x1234);
+    const auto coilOff = makeRequest<FCODE_WR_COIL>(1, 0, 0);
+
+    EXPECT_TRUE(std::equal(coilOn.begin(), coilOn.end(), vectors[4].adu.data()));
+    EXPECT_TRUE(0 == coilOff[4] && 0 == calcCRC(coilOff.data(), coilOff.data() + coilOff.size()).value);
+}
+
+UTEST_MAIN();
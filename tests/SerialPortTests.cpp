@@ -188,4 +188,95 @@ UTEST(SerialPort, read_interrupted)
     EXPECT_TRUE(1 == usr1Cntr);
 }
 
+UTEST(SerialPort, character_format)
+{
+    using BaudRate = SerialPort::BaudRate;
+    using Parity = SerialPort::Parity;
+    using DataBits = SerialPort::DataBits;
+    using StopBits = SerialPort::StopBits;
+    using uSecs = SerialPort::uSecs;
+
+    struct Row
+    {
+        BaudRate baudRate;
+        Parity parity;
+        DataBits dataBits;
+        StopBits stopBits;
+        unsigned bitsPerChar;
+        /* wire time of 10 characters */
+        uSecs wireTime;
+        uSecs silentInterval;
+    };
+
+    const Row rows[] =
+    {
+        {BaudRate::BR_1200, Parity::Odd, DataBits::Seven, StopBits::One, 10, uSecs{83333}, uSecs{29166}},
+        {BaudRate::BR_9600, Parity::None, DataBits::Seven, StopBits::One, 9, uSecs{9375}, uSecs{3281}},
+        {BaudRate::BR_9600, Parity::None, DataBits::Eight, StopBits::One, 10, uSecs{10416}, uSecs{3645}},
+        {BaudRate::BR_9600, Parity::Even, DataBits::Eight, StopBits::One, 11, uSecs{11458}, uSecs{4010}},
+        {BaudRate::BR_19200, Parity::Even, DataBits::Eight, StopBits::One, 11, uSecs{5729}, uSecs{2005}},
+        {BaudRate::BR_19200, Parity::None, DataBits::Eight, StopBits::Two, 11, uSecs{5729}, uSecs{2005}},
+        {BaudRate::BR_19200, Parity::Even, DataBits::Eight, StopBits::Two, 12, uSecs{6250}, uSecs{2187}},
+        /* fixed 1750us above 19200bps */
+        {BaudRate::BR_38400, Parity::None, DataBits::Eight, StopBits::One, 10, uSecs{2604}, uSecs{1750}},
+        {BaudRate::BR_115200, Parity::Even, DataBits::Eight, StopBits::One, 11, uSecs{954}, uSecs{1750}},
+    };
+
+    for(const auto &row : rows)
+    {
+        const auto bitRate = SerialPort::toBitRate(row.baudRate);
+
+        EXPECT_TRUE(row.bitsPerChar == SerialPort::bitsPerChar(row.parity, row.dataBits, row.stopBits));
+        EXPECT_TRUE(uSecs{0} == SerialPort::wireTime(0, row.bitsPerChar, bitRate));
+        EXPECT_TRUE(row.wireTime == SerialPort::wireTime(10, row.bitsPerChar, bitRate));
+        EXPECT_TRUE(row.silentInterval == SerialPort::silentInterval(row.bitsPerChar, bitRate));
+
+        /* pseudo terminal keeps neither parity nor data bits other than 8 */
+        if(SerialPort::Parity::None != row.parity || SerialPort::DataBits::Eight != row.dataBits) continue;
+
+        auto pair = createPseudoPair(row.baudRate, row.parity, row.dataBits, row.stopBits);
+
+        EXPECT_TRUE(row.bitsPerChar == pair.master.bitsPerChar());
+        EXPECT_TRUE(bitRate == pair.master.bitRate());
+        EXPECT_TRUE(row.wireTime == pair.master.wireTime(10));
+        EXPECT_TRUE(row.silentInterval == pair.master.silentInterval());
+    }
+}
+
+UTEST(SerialPort, occupancy)
+{
+    using namespace std::chrono;
+    using uSecs = SerialPort::uSecs;
+
+    auto pair =
+        createPseudoPair(
+            SerialPort::BaudRate::BR_19200, SerialPort::Parity::None,
+            SerialPort::DataBits::Eight, SerialPort::StopBits::Two);
+
+    const uint8_t message[20] = {};
+    const auto timeout = milliseconds{100};
+
+    EXPECT_TRUE(std::cend(message) == pair.master.write(std::cbegin(message), std::cend(message), timeout));
+
+    /* 20 characters of 11 bits at 19200bps, one frame (silent interval 2005us) */
+    const auto occupancy = pair.master.occupancy(seconds{1});
+
+    EXPECT_TRUE(uSecs{11458} == occupancy.tx);
+    EXPECT_TRUE(uSecs{0} == occupancy.rx);
+    EXPECT_TRUE(uSecs{2005} == occupancy.gap);
+    EXPECT_TRUE(uSecs{1000000 - 11458 - 2005} == occupancy.idle);
+    EXPECT_TRUE(1.1457 < occupancy.utilization() && occupancy.utilization() < 1.1459);
+    EXPECT_TRUE(1.3462 < occupancy.saturation() && occupancy.saturation() < 1.3464);
+
+    /* window shorter than bus usage - no idle time */
+    EXPECT_TRUE(uSecs{0} == pair.master.occupancy(milliseconds{10}).idle);
+
+    pair.master.clearCntrs();
+
+    const auto cleared = pair.master.occupancy(seconds{1});
+
+    EXPECT_TRUE(uSecs{0} == cleared.tx + cleared.rx + cleared.gap);
+    EXPECT_TRUE(uSecs{1000000} == cleared.idle);
+}
+
 UTEST_MAIN();